@@ -5,6 +5,9 @@
 #include <wx/string.h>
 #include <wx/ffile.h>
 #include <wx/log.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
 #include <math.h>
 #include <stdlib.h>
 #include "kiss_fft/tools/kiss_fftr.h"
@@ -30,6 +33,17 @@ int AudioData::__nextId = 0;
 #define DEFAULT_RATE RESAMPLE_RATE
 #endif
 
+// the spectrum is analysed into one value per MIDI note
+#define SPECTRUM_NOTES 127
+// samples in each FFT window
+#define FRAMEDATA_STEP 2048
+// frames in each piece of work when preparing frame data
+#define FRAMEDATA_CHUNK 256
+#define FRAMEDATA_CACHE_VERSION 1
+// the finest level of the waveform min max pyramid covers blocks of 1 << SAMPLEMINMAX_SHIFT samples
+#define SAMPLEMINMAX_SHIFT 4
+#define SAMPLEMINMAX_CACHE_VERSION 1
+
 void fill_audio(void *udata, Uint8 *stream, int len)
 {
     //SDL 2.0
@@ -776,6 +790,9 @@ AudioManager::AudioManager(const std::string& audio_file, int step, int block)
 	_data[1] = nullptr; // right channel data
 	_intervalMS = -1; // no length
 	_frameDataPrepared = false; // frame data is used by effects to react to the sone
+	_frameDataLevelsPrepared = false;
+	_frameDataStarted = false;
+    _sampleMinMaxReady = false;
 	_media_state = MEDIAPLAYINGSTATE::STOPPED;
 	_pcmdata = nullptr;
 	_polyphonicTranscriptionDone = false;
@@ -815,9 +832,10 @@ AudioManager::AudioManager(const std::string& audio_file, int step, int block)
     }
 }
 
-std::list<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const
+std::vector<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const
 {
-	std::list<float> res;
+	std::vector<float> res;
+	res.reserve(SPECTRUM_NOTES);
 	int outcount = n / 2 + 1;
 	kiss_fftr_cfg cfg;
 	kiss_fft_cpx* out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx) * (outcount));
@@ -829,7 +847,7 @@ std::list<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n,
 			free(cfg);
 		}
 
-		for (int j = 0; j < 127; j++)
+		for (int j = 0; j < SPECTRUM_NOTES; j++)
 		{
             // choose the right bucket for this MIDI note
             double freq = 440.0 * exp2f(((double)j - 69.0) / 12.0);
@@ -966,6 +984,7 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
             logger_pianodata.debug("About to extract Polyphonic Transcription result.");
             Vamp::Plugin::FeatureSet features = pt->getRemainingFeatures();
             logger_pianodata.debug("Polyphonic Transcription result retrieved.");
+            std::vector<std::vector<float>> notes(_frameData[FRAMEDATA_NOTES].GetFrameCount());
             logger_pianodata.debug("Start,Duration,CalcStart,CalcEnd,midinote");
             for (size_t j = 0; j < features[0].size(); j++)
             {
@@ -988,12 +1007,13 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
                 if (currentstart - sframe * _intervalMS > _intervalMS / 2) {
                     sframe++;
                 }
-                int eframe = currentend / _intervalMS;
+                int eframe = std::min(currentend / _intervalMS, (long)notes.size() - 1);
                 while (sframe <= eframe) {
-                    _frameData[sframe][4].push_back(features[0][j].values[0]);
+                    notes[sframe].push_back(features[0][j].values[0]);
                     sframe++;
                 }
             }
+            _frameData[FRAMEDATA_NOTES].SetFrames(notes);
 
             fn(dlg, 100);
 
@@ -1001,11 +1021,11 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
             {
                 logger_pianodata.debug("Piano data calculated:");
                 logger_pianodata.debug("Time MS, Keys");
-                for (size_t i = 0; i < _frameData.size(); i++)
+                for (size_t i = 0; i < notes.size(); i++)
                 {
                     long ms = i * _intervalMS;
                     std::string keys = "";
-                    for (auto it2 = _frameData[i][4].begin(); it2 != _frameData[i][4].end(); ++it2)
+                    for (auto it2 = notes[i].begin(); it2 != notes[i].end(); ++it2)
                     {
                         keys += " " + std::string(wxString::Format("%f", *it2).c_str());
                     }
@@ -1026,28 +1046,278 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
     logger_base.info("DoPolyphonicTranscription: Polyphonic transcription completed in %ld.", sw.Time());
 }
 
+#pragma region AudioFrameDataStore
+void AudioFrameDataStore::SetFrames(const std::vector<std::vector<float>>& frames)
+{
+    _stride = 0;
+    _frames = frames.size();
+    _offsets.resize(_frames + 1);
+
+    size_t total = 0;
+    for (size_t i = 0; i < _frames; i++)
+    {
+        _offsets[i] = total;
+        total += frames[i].size();
+    }
+    _offsets[_frames] = total;
+
+    _values.resize(total);
+    for (size_t i = 0; i < _frames; i++)
+    {
+        std::copy(frames[i].begin(), frames[i].end(), _values.begin() + _offsets[i]);
+    }
+}
+
+void AudioFrameDataStore::Scale(float scale)
+{
+    for (auto& v : _values)
+    {
+        v *= scale;
+    }
+}
+
+AudioFrameData AudioFrameDataStore::GetFrame(size_t frame) const
+{
+    if (frame >= _frames) return AudioFrameData();
+
+    const float* values = _values.data();
+    if (_stride == 0)
+    {
+        return AudioFrameData(values + _offsets[frame], values + _offsets[frame + 1]);
+    }
+    return AudioFrameData(values + frame * _stride, values + (frame + 1) * _stride);
+}
+#pragma endregion AudioFrameDataStore
+
 // Frame Data Extraction Functions
-// process audio data and build data for each frame
-void AudioManager::DoPrepareFrameData()
+
+// Runs one share of a chunked frame data calculation on a job pool thread
+class AudioFrameDataJob : public Job
+{
+    std::function<void()> _fn;
+
+public:
+    AudioFrameDataJob(std::function<void()> fn) : _fn(fn) {}
+    virtual ~AudioFrameDataJob() {};
+    virtual void Process() override { _fn(); }
+    virtual std::string GetStatus() override { return ""; }
+    virtual bool DeleteWhenComplete() override { return true; }
+    virtual const std::string GetName() const override { return "AudioFrameData"; }
+};
+
+// Calls fn(chunk, startFrame, endFrame) for every chunk of frames. The chunks are shared between the
+// job pool and this thread and this returns once they are all done.
+void AudioManager::ProcessFrameDataChunks(int frames, const std::function<void(int, int, int)>& fn)
+{
+    int chunks = (frames + FRAMEDATA_CHUNK - 1) / FRAMEDATA_CHUNK;
+    std::atomic_int nextChunk(0);
+    auto process = [&]() {
+        int chunk;
+        while ((chunk = nextChunk++) < chunks)
+        {
+            fn(chunk, chunk * FRAMEDATA_CHUNK, std::min(frames, (chunk + 1) * FRAMEDATA_CHUNK));
+        }
+    };
+
+    std::mutex lock;
+    std::condition_variable signal;
+    int running = std::max(0, std::min(chunks, wxThread::GetCPUCount()) - 1);
+    int helpers = running;
+    for (int i = 0; i < helpers; i++)
+    {
+        _jobPool.PushJob(new AudioFrameDataJob([&]() {
+            process();
+            std::unique_lock<std::mutex> locker(lock);
+            running--;
+            signal.notify_all();
+        }));
+    }
+
+    process();
+
+    std::unique_lock<std::mutex> locker(lock);
+    signal.wait(locker, [&]() { return running == 0; });
+}
+
+// The FFT windows start every step samples and each one belongs to the frame it starts in. Windows
+// which would read past the end of the song are not used.
+void AudioManager::GetSpectrumWindows(int frame, int samplesperframe, int totalsamples, int& first, int& last)
+{
+    int windows = totalsamples > FRAMEDATA_STEP ? (totalsamples - 1) / FRAMEDATA_STEP : 0;
+    first = std::min(windows, (int)(((long)frame * samplesperframe + FRAMEDATA_STEP - 1) / FRAMEDATA_STEP));
+    last = std::min(windows, (int)(((long)(frame + 1) * samplesperframe + FRAMEDATA_STEP - 1) / FRAMEDATA_STEP));
+}
+
+// The maximum of the spectrum of each window in the frame. False if no window starts in the frame in which
+// case the frame shows the spectrum of the frame before it.
+bool AudioManager::CalculateFrameSpectrum(int frame, int samplesperframe, int totalsamples, std::vector<float>& spectrogram, float& max)
+{
+    int first;
+    int last;
+    GetSpectrumWindows(frame, samplesperframe, totalsamples, first, last);
+    if (first == last) return false;
+
+    spectrogram.clear();
+    for (int w = first; w < last; w++)
+    {
+        float* pdata = GetLeftDataPtr((long)w * FRAMEDATA_STEP);
+        float max2 = 0;
+
+        std::vector<float> subspectrogram;
+        if (pdata != nullptr)
+        {
+            subspectrogram = CalculateSpectrumAnalysis(pdata, FRAMEDATA_STEP, max2, frame);
+        }
+
+        // and keep track of the larges value so we can normalise it
+        if (max2 > max)
+        {
+            max = max2;
+        }
+
+        // either take the newly calculated values or if we are merging two results take the maximum of each value
+        if (spectrogram.size() == 0)
+        {
+            spectrogram = subspectrogram;
+        }
+        else if (subspectrogram.size() > 0)
+        {
+            for (size_t j = 0; j < spectrogram.size(); j++)
+            {
+                if (subspectrogram[j] > spectrogram[j])
+                {
+                    spectrogram[j] = subspectrogram[j];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void AudioManager::SetFrameDataReady(bool levels, bool all)
+{
+    std::unique_lock<std::mutex> locker(_frameDataReadyLock);
+    _frameDataLevelsPrepared = _frameDataLevelsPrepared || levels;
+    _frameDataPrepared = _frameDataPrepared || all;
+    _frameDataReadySignal.notify_all();
+}
+
+// where the results of analysing a song are kept so they dont have to be worked out again next time
+static wxString GetAudioCacheDir()
+{
+    wxString dir = wxFileName::GetTempDir();
+    if (dir == "") return "";
+
+    dir += wxFileName::GetPathSeparator() + wxString("xLightsAudioCache");
+    if (!wxDirExists(dir) && !wxMkdir(dir)) return "";
+
+    return dir;
+}
+
+std::string AudioManager::GetFrameDataCacheFile()
+{
+    wxString dir = GetAudioCacheDir();
+    if (dir == "") return "";
+
+    return (dir + wxFileName::GetPathSeparator() + wxString::Format("%s_%d.xlfd", Hash().c_str(), _intervalMS)).ToStdString();
+}
+
+bool AudioManager::LoadFrameDataCache(const std::string& filename, int frames)
+{
+    wxFile file;
+    if (filename == "" || !wxFile::Exists(filename) || !file.Open(filename)) return false;
+
+    char magic[4];
+    int header[4];
+    if (file.Read(magic, sizeof(magic)) != (ssize_t)sizeof(magic) || memcmp(magic, "xLFD", sizeof(magic)) != 0) return false;
+    if (file.Read(header, sizeof(header)) != (ssize_t)sizeof(header)) return false;
+    if (header[0] != FRAMEDATA_CACHE_VERSION || header[1] != frames || header[2] != _rate || header[3] != FRAMEDATA_STEP) return false;
+
+    float big[4];
+    if (file.Read(big, sizeof(big)) != (ssize_t)sizeof(big)) return false;
+
+    _frameData[FRAMEDATA_HIGH].SetFixedStride(1, frames);
+    _frameData[FRAMEDATA_LOW].SetFixedStride(1, frames);
+    _frameData[FRAMEDATA_SPREAD].SetFixedStride(1, frames);
+    _frameData[FRAMEDATA_VU].SetFixedStride(SPECTRUM_NOTES, frames);
+    if (frames > 0)
+    {
+        for (auto fdt : { FRAMEDATA_HIGH, FRAMEDATA_LOW, FRAMEDATA_SPREAD, FRAMEDATA_VU })
+        {
+            size_t size = (fdt == FRAMEDATA_VU ? SPECTRUM_NOTES : 1) * frames * sizeof(float);
+            if (file.Read(_frameData[fdt].GetFramePtr(0), size) != (ssize_t)size) return false;
+        }
+    }
+
+    _bigmax = big[0];
+    _bigmin = big[1];
+    _bigspread = big[2];
+    _bigspectogrammax = big[3];
+    return true;
+}
+
+void AudioManager::SaveFrameDataCache(const std::string& filename, int frames)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    logger_base.info("DoPrepareFrameData: Start processing audio frame data.");
 
-	// lock the mutex
-    std::unique_lock<std::shared_timed_mutex> locker(_mutex);
-    logger_base.info("DoPrepareFrameData: Got mutex.");
+    if (filename == "") return;
 
-    if (_data[0] == nullptr) return;
+    // write to a temporary file so a partly written cache is never read
+    std::string tmp = filename + ".tmp";
+    wxFile file;
+    if (!file.Open(tmp, wxFile::write))
+    {
+        logger_base.warn("DoPrepareFrameData: Unable to create audio frame data cache %s.", (const char *)tmp.c_str());
+        return;
+    }
 
-    wxStopWatch sw;
+    int header[4] = { FRAMEDATA_CACHE_VERSION, frames, (int)_rate, FRAMEDATA_STEP };
+    float big[4] = { _bigmax, _bigmin, _bigspread, _bigspectogrammax };
+    bool ok = file.Write("xLFD", 4) == 4 && file.Write(header, sizeof(header)) == sizeof(header) && file.Write(big, sizeof(big)) == sizeof(big);
+    if (frames > 0)
+    {
+        for (auto fdt : { FRAMEDATA_HIGH, FRAMEDATA_LOW, FRAMEDATA_SPREAD, FRAMEDATA_VU })
+        {
+            size_t size = (fdt == FRAMEDATA_VU ? SPECTRUM_NOTES : 1) * frames * sizeof(float);
+            ok = ok && file.Write(_frameData[fdt].GetFramePtr(0), size) == size;
+        }
+    }
+    file.Close();
 
-	// if we have already done it ... bail
-	if (_frameDataPrepared)
+    if (!ok || !wxRenameFile(tmp, filename, true))
+    {
+        logger_base.warn("DoPrepareFrameData: Unable to save audio frame data cache %s.", (const char *)filename.c_str());
+        wxRemoveFile(tmp);
+    }
+}
+
+// process audio data and build data for each frame
+void AudioManager::DoPrepareFrameData()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.info("DoPrepareFrameData: Start processing audio frame data.");
+
+	// if we have already done it or it is being done on another thread ... bail
+    bool started = false;
+	if (!_frameDataStarted.compare_exchange_strong(started, true))
 	{
 		logger_base.info("DoPrepareFrameData: Aborting processing audio frame data ... it has already been done.");
 		return;
 	}
 
+	// lock the mutex so the audio data is not deleted while we use it
+    std::shared_lock<std::shared_timed_mutex> locker(_mutex);
+    logger_base.info("DoPrepareFrameData: Got mutex.");
+
+    if (_data[0] == nullptr)
+    {
+        // nothing to prepare ... let anyone waiting for it know
+        SetFrameDataReady(true, true);
+        return;
+    }
+
+    wxStopWatch sw;
+
     // wait for the data to load
     while (!IsDataLoaded())
     {
@@ -1064,166 +1334,119 @@ void AudioManager::DoPrepareFrameData()
 	}
 	int totalsamples = frames * samplesperframe;
 
-	// these are used to normalise output
-	_bigmax = -1;
-	_bigspread = -1;
-	_bigmin = 1;
-	_bigspectogrammax = -1;
+	_frameData[FRAMEDATA_ISTIMINGMARK].Clear();
+	_frameData[FRAMEDATA_NOTES].SetFrames(std::vector<std::vector<float>>(frames));
 
-	size_t step = 2048;
-	float *pdata[2];
+    // if this song has been analysed before reuse the results
+    std::string cacheFile = GetFrameDataCacheFile();
+    if (LoadFrameDataCache(cacheFile, frames))
+    {
+        SetFrameDataReady(true, true);
+        logger_base.info("DoPrepareFrameData: Audio frame data loaded from cache %s in %ld.", (const char *)cacheFile.c_str(), sw.Time());
+        return;
+    }
 
-	int pos = 0;
-	std::list<float> spectrogram;
+	_frameData[FRAMEDATA_HIGH].SetFixedStride(1, frames);
+	_frameData[FRAMEDATA_LOW].SetFixedStride(1, frames);
+	_frameData[FRAMEDATA_SPREAD].SetFixedStride(1, frames);
+	_frameData[FRAMEDATA_VU].SetFixedStride(SPECTRUM_NOTES, frames);
 
-	// process each frome of the song
-	for (int i = 0; i < frames; i++)
-	{
-		std::vector<std::list<float>> aFrameData;
-		aFrameData.resize(5); // preallocate the spots we will need
-
-		// accumulators
-		float max = -100.0;
-		float min = 100.0;
-		float spread = -100;
-
-		// clear the data if we are about to get new data ... dont clear it if we wont
-		// this happens because the spectrogram function has a fixed window based on the parameters we set and it
-		// does not match our time slices exactly so we have to select which one to use
-		if (pos < i * samplesperframe + samplesperframe  && pos + step < totalsamples)
-		{
-			spectrogram.clear();
-		}
-
-		// only get the data if we are not ahead of the music
-		while (pos < i * samplesperframe + samplesperframe && pos + step < totalsamples)
+	// these are used to normalise output
+	int chunks = std::max(1, (frames + FRAMEDATA_CHUNK - 1) / FRAMEDATA_CHUNK);
+	std::vector<float> chunkmax(chunks, -1);
+	std::vector<float> chunkmin(chunks, 1);
+	std::vector<float> chunkspread(chunks, -1);
+	std::vector<float> chunkspectrogrammax(chunks, -1);
+
+	// the raw data analysis is quick so do it first ... most effects only need it
+	ProcessFrameDataChunks(frames, [&](int chunk, int start, int end) {
+		for (int i = start; i < end; i++)
 		{
-			std::list<float> subspectrogram;
-			pdata[0] = GetLeftDataPtr(pos);
-			pdata[1] = GetRightDataPtr(pos);
-			float max2 = 0;
+			// accumulators
+			float max = -100.0;
+			float min = 100.0;
+			float spread = -100;
 
-			if (pdata[0] == nullptr)
-			{
-				subspectrogram.clear();
-			}
-			else
+			for (long j = (long)i * samplesperframe; j < (long)(i + 1) * samplesperframe; j++)
 			{
-				subspectrogram = CalculateSpectrumAnalysis(pdata[0], step, max2, i);
-			}
+				float data = j > _trackSize ? 0 : _data[0][j];
 
-			// and keep track of the larges value so we can normalise it
-			if (max2 > _bigspectogrammax)
-			{
-				_bigspectogrammax = max2;
-			}
-			pos += step;
+				// Max data
+				if (data > max)
+				{
+					max = data;
+				}
 
-			// either take the newly calculated values or if we are merging two results take the maximum of each value
-			if (spectrogram.size() == 0)
-			{
-				spectrogram = subspectrogram;
-			}
-			else
-			{
-				if (subspectrogram.size() > 0)
+				// Min data
+				if (data < min)
 				{
-					std::list<float>::iterator sub = subspectrogram.begin();
-					for (std::list<float>::iterator fr = spectrogram.begin(); fr != spectrogram.end(); ++fr)
-					{
-						if (*sub > *fr)
-						{
-							*fr = *sub;
-						}
-						++sub;
-					}
+					min = data;
+				}
+
+				// Spread data
+				if (max - min > spread)
+				{
+					spread = max - min;
 				}
 			}
-		}
 
-		// now do the raw data analysis for the frame
-		for (int j = 0; j < samplesperframe; j++)
-		{
-			float data = GetLeftData(i * samplesperframe + j);
+			chunkmax[chunk] = std::max(chunkmax[chunk], max);
+			chunkmin[chunk] = std::min(chunkmin[chunk], min);
+			chunkspread[chunk] = std::max(chunkspread[chunk], spread);
 
-			// Max data
-			if (data > max)
-			{
-				max = data;
-			}
+			*_frameData[FRAMEDATA_HIGH].GetFramePtr(i) = max;
+			*_frameData[FRAMEDATA_LOW].GetFramePtr(i) = min;
+			*_frameData[FRAMEDATA_SPREAD].GetFramePtr(i) = spread;
+		}
+	});
 
-			// Min data
-			if (data < min)
+	// normalise data ... basically scale the data so the highest value is the scale value.
+	float scale = 1.0; // 0-1 ... where 0.x means that the max value displayed would be x0% of model size
+	_bigmax = *std::max_element(chunkmax.begin(), chunkmax.end());
+	_bigmin = *std::min_element(chunkmin.begin(), chunkmin.end());
+	_bigspread = *std::max_element(chunkspread.begin(), chunkspread.end());
+	_frameData[FRAMEDATA_HIGH].Scale(1 / (_bigmax * scale));
+	_frameData[FRAMEDATA_LOW].Scale(1 / (_bigmin * scale));
+	_frameData[FRAMEDATA_SPREAD].Scale(1 / (_bigspread * scale));
+	SetFrameDataReady(true, false);
+	logger_base.info("DoPrepareFrameData: Audio level data ready in %ld.", sw.Time());
+
+	// now the spectrum of each frame
+	ProcessFrameDataChunks(frames, [&](int chunk, int start, int end) {
+		std::vector<float> spectrogram;
+		if (!CalculateFrameSpectrum(start, samplesperframe, totalsamples, spectrogram, chunkspectrogrammax[chunk]))
+		{
+			// the first frame carries on from the spectrum of the last window before it
+			int first;
+			int last;
+			GetSpectrumWindows(start, samplesperframe, totalsamples, first, last);
+			if (first > 0)
 			{
-				min = data;
+				int owner = (long)(first - 1) * FRAMEDATA_STEP / samplesperframe;
+				CalculateFrameSpectrum(owner, samplesperframe, totalsamples, spectrogram, chunkspectrogrammax[chunk]);
 			}
+		}
 
-			// Spread data
-			if (max - min > spread)
+		for (int i = start; i < end; i++)
+		{
+			if (i != start)
 			{
-				spread = max - min;
+				CalculateFrameSpectrum(i, samplesperframe, totalsamples, spectrogram, chunkspectrogrammax[chunk]);
 			}
-		}
 
-		if (max > _bigmax)
-		{
-			_bigmax = max;
-		}
-		if (min < _bigmin)
-		{
-			_bigmin = min;
-		}
-		if (spread > _bigspread)
-		{
-			_bigspread = spread;
+			// frames without a spectrogram are left as zeros
+			std::copy(spectrogram.begin(), spectrogram.end(), _frameData[FRAMEDATA_VU].GetFramePtr(i));
 		}
+	});
 
-		// Now save the results for the frame
-		std::list<float> maxlist;
-		maxlist.push_back(max);
-		std::list<float> minlist;
-		minlist.push_back(min);
-		std::list<float> spreadlist;
-		spreadlist.push_back(spread);
-		aFrameData[0] = maxlist;
-		aFrameData[1] = minlist;
-		aFrameData[2] = spreadlist;
-		aFrameData[3] = spectrogram;
-
-		_frameData.push_back(aFrameData);
-	}
-
-	// normalise data ... basically scale the data so the highest value is the scale value.
-	float scale = 1.0; // 0-1 ... where 0.x means that the max value displayed would be x0% of model size
-	float bigmaxscale = 1 / (_bigmax * scale);
-	float bigminscale = 1 / (_bigmin * scale);
-	float bigspreadscale = 1 / (_bigspread * scale);
-	float bigspectrogramscale = 1 / (_bigspectogrammax * scale);
-	for (std::vector<std::vector<std::list<float>>>::iterator itframe = _frameData.begin(); itframe != _frameData.end(); ++itframe)
-	{
-		std::list<float>* fl = &(*itframe)[0];
-		std::list<float>::iterator f = fl->begin();
-		*f = (*f * bigmaxscale);
-
-		fl = &(*itframe)[1];
-		f = fl->begin();
-		*f = (*f * bigminscale);
-
-		fl = &(*itframe)[2];
-		f = fl->begin();
-		*f = (*f * bigspreadscale);
-
-		fl = &(*itframe)[3];
-		for (std::list<float>::iterator ff = fl->begin(); ff != fl->end(); ++ff)
-		{
-			*ff = *ff * bigspectrogramscale;
-		}
-	}
+	_bigspectogrammax = *std::max_element(chunkspectrogrammax.begin(), chunkspectrogrammax.end());
+	_frameData[FRAMEDATA_VU].Scale(1 / (_bigspectogrammax * scale));
 
 	// flag the fact that the data is all ready
-	_frameDataPrepared = true;
-
+	SetFrameDataReady(true, true);
 	logger_base.info("DoPrepareFrameData: Audio frame data processing complete in %ld.", sw.Time());
+
+	SaveFrameDataCache(cacheFile, frames);
 }
 
 // Called to trigger frame data creation
@@ -1270,33 +1493,30 @@ void ProgressFunction(wxProgressDialog* pd, int p)
 }
 
 // Get the pre-prepared data for this frame
-std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
+AudioFrameData AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
 {
     log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    std::list<float>* rc = nullptr;
 
     // Grab the lock so we can safely access the frame data
     std::shared_lock<std::shared_timed_mutex> lock(_mutex);
 
     // make sure we have audio data
-    if (_data[0] == nullptr) return rc;
+    if (_data[0] == nullptr) return AudioFrameData();
+
+    // the levels are ready before the spectrum so effects which only need them can start sooner
+    bool levels = fdt == FRAMEDATA_HIGH || fdt == FRAMEDATA_LOW || fdt == FRAMEDATA_SPREAD;
 
     // if the frame data has not been prepared
-    if (!_frameDataPrepared)
+    if (levels ? !_frameDataLevelsPrepared : !_frameDataPrepared)
     {
         logger_base.debug("GetFrameData was called prior to the frame data being prepared.");
-        // prepare it
+        // prepare it ... this does nothing if another thread already is
         lock.unlock();
         PrepareFrameData(false);
-
         lock.lock();
-        // wait until the new thread grabs the lock
-        while (!_frameDataPrepared)
-        {
-            lock.unlock();
-            wxMilliSleep(5);
-            lock.lock();
-        }
+
+        std::unique_lock<std::mutex> readyLock(_frameDataReadyLock);
+        _frameDataReadySignal.wait(readyLock, [&]() { return levels ? _frameDataLevelsPrepared.load() : _frameDataPrepared.load(); });
     }
     if (fdt == FRAMEDATA_NOTES && !_polyphonicTranscriptionDone) {
         //need to do the polyphonic stuff
@@ -1305,46 +1525,9 @@ std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::
     }
 
     // now we can grab the data we need
-    try
-    {
-        if (frame < (int)_frameData.size())
-        {
-            std::vector<std::list<float>>* framedata = &_frameData[frame];
-
-            if (framedata == nullptr)
-            {
-                logger_base.crit("AudioManager::GetFrameData framedata is nullptr ... this is going to crash.");
-            }
-
-            switch (fdt)
-            {
-            case FRAMEDATA_HIGH:
-                rc = &framedata->at(0);
-                break;
-            case FRAMEDATA_LOW:
-                rc = &framedata->at(1);
-                break;
-            case FRAMEDATA_SPREAD:
-                rc = &framedata->at(2);
-                break;
-            case FRAMEDATA_VU:
-                rc = &framedata->at(3);
-                break;
-            case FRAMEDATA_ISTIMINGMARK:
-                // we dont need to do anything here
-                break;
-            case FRAMEDATA_NOTES:
-                rc = &framedata->at(4);
-                break;
-            }
-        }
-    }
-    catch (...)
-    {
-        rc = nullptr;
-    }
+    if (frame < 0 || fdt == FRAMEDATA_ISTIMINGMARK) return AudioFrameData();
 
-    return rc;
+    return _frameData[fdt].GetFrame(frame);
 }
 
 // Constant Bitrate Detection Functions
@@ -1584,7 +1767,7 @@ AudioManager::~AudioManager()
     // this is only tripped if we try to open a new song too soon after opening another one
 
     // Grab the lock so we know the background process isnt runnning
-    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
 
 	if (_data[1] != _data[0] && _data[1] != nullptr)
 	{
@@ -1791,6 +1974,9 @@ void AudioManager::DoLoadAudioData(AVFormatContext* formatContext, AVCodecContex
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("DoLoadAudioData: Doing load of song data.");
 
+    // lock the mutex so the audio data is not deleted until we have finished with it
+    std::shared_lock<std::shared_timed_mutex> locker(_mutex);
+
     wxStopWatch sw;
 
     long read = 0;
@@ -1941,6 +2127,143 @@ void AudioManager::DoLoadAudioData(AVFormatContext* formatContext, AVCodecContex
     avformat_close_input(&formatContext);
 
     logger_base.debug("DoLoadAudioData: Song data loaded in %ld.", sw.Time());
+
+    PrepareSampleMinMax();
+}
+
+std::string AudioManager::GetSampleMinMaxCacheFile()
+{
+    wxString dir = GetAudioCacheDir();
+    if (dir == "") return "";
+
+    return (dir + wxFileName::GetPathSeparator() + wxString::Format("%s.xlmm", Hash().c_str())).ToStdString();
+}
+
+bool AudioManager::LoadSampleMinMaxCache(const std::string& filename)
+{
+    wxFile file;
+    if (filename == "" || !wxFile::Exists(filename) || !file.Open(filename)) return false;
+
+    char magic[4];
+    int header[4];
+    if (file.Read(magic, sizeof(magic)) != (ssize_t)sizeof(magic) || memcmp(magic, "xLMM", sizeof(magic)) != 0) return false;
+    if (file.Read(header, sizeof(header)) != (ssize_t)sizeof(header)) return false;
+    if (header[0] != SAMPLEMINMAX_CACHE_VERSION || header[1] != _trackSize || header[2] != SAMPLEMINMAX_SHIFT) return false;
+
+    // the size of every level follows from the track size
+    std::vector<std::vector<float>> minmax;
+    long blocks = (_trackSize + (1 << SAMPLEMINMAX_SHIFT) - 1) >> SAMPLEMINMAX_SHIFT;
+    while (blocks > 0)
+    {
+        minmax.push_back(std::vector<float>(blocks * 2));
+        size_t size = blocks * 2 * sizeof(float);
+        if (file.Read(minmax.back().data(), size) != (ssize_t)size) return false;
+        blocks = blocks == 1 ? 0 : (blocks + 1) / 2;
+    }
+    if ((int)minmax.size() != header[3]) return false;
+
+    _sampleMinMax = std::move(minmax);
+    return true;
+}
+
+void AudioManager::SaveSampleMinMaxCache(const std::string& filename)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (filename == "") return;
+
+    // write to a temporary file so a partly written cache is never read
+    std::string tmp = filename + ".tmp";
+    wxFile file;
+    if (!file.Open(tmp, wxFile::write))
+    {
+        logger_base.warn("PrepareSampleMinMax: Unable to create waveform cache %s.", (const char *)tmp.c_str());
+        return;
+    }
+
+    int header[4] = { SAMPLEMINMAX_CACHE_VERSION, (int)_trackSize, SAMPLEMINMAX_SHIFT, (int)_sampleMinMax.size() };
+    bool ok = file.Write("xLMM", 4) == 4 && file.Write(header, sizeof(header)) == sizeof(header);
+    for (auto& level : _sampleMinMax)
+    {
+        size_t size = level.size() * sizeof(float);
+        ok = ok && file.Write(level.data(), size) == size;
+    }
+    file.Close();
+
+    if (!ok || !wxRenameFile(tmp, filename, true))
+    {
+        logger_base.warn("PrepareSampleMinMax: Unable to save waveform cache %s.", (const char *)filename.c_str());
+        wxRemoveFile(tmp);
+    }
+}
+
+// Build the min max pyramid the waveform is drawn from. The finest level is read from the samples and each
+// coarser level from the one below it so the whole song is only read once whatever the zoom.
+void AudioManager::PrepareSampleMinMax()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxStopWatch sw;
+
+    if (_data[0] == nullptr || _trackSize <= 0)
+    {
+        _sampleMinMaxReady = true;
+        return;
+    }
+
+    std::string cacheFile = GetSampleMinMaxCacheFile();
+    if (LoadSampleMinMaxCache(cacheFile))
+    {
+        logger_base.debug("PrepareSampleMinMax: Waveform loaded from cache in %ld.", sw.Time());
+        _sampleMinMaxReady = true;
+        return;
+    }
+
+    const long block = 1 << SAMPLEMINMAX_SHIFT;
+    long blocks = (_trackSize + block - 1) >> SAMPLEMINMAX_SHIFT;
+    std::vector<float> finest(blocks * 2);
+    for (long b = 0; b < blocks; b++)
+    {
+        long start = b << SAMPLEMINMAX_SHIFT;
+        long end = std::min(start + block, _trackSize);
+        float minimum = _data[0][start];
+        float maximum = minimum;
+        for (long j = start + 1; j < end; j++)
+        {
+            minimum = std::min(minimum, _data[0][j]);
+            maximum = std::max(maximum, _data[0][j]);
+        }
+        finest[b * 2] = minimum;
+        finest[b * 2 + 1] = maximum;
+    }
+    _sampleMinMax.clear();
+    _sampleMinMax.push_back(std::move(finest));
+
+    while (_sampleMinMax.back().size() > 2)
+    {
+        const std::vector<float>& finer = _sampleMinMax.back();
+        long finerBlocks = finer.size() / 2;
+        std::vector<float> coarser(((finerBlocks + 1) / 2) * 2);
+        for (long b = 0; b < finerBlocks; b += 2)
+        {
+            // an odd block at the end has nothing to pair with
+            float minimum = finer[b * 2];
+            float maximum = finer[b * 2 + 1];
+            if (b + 1 < finerBlocks)
+            {
+                minimum = std::min(minimum, finer[b * 2 + 2]);
+                maximum = std::max(maximum, finer[b * 2 + 3]);
+            }
+            coarser[b] = minimum;
+            coarser[b + 1] = maximum;
+        }
+        _sampleMinMax.push_back(std::move(coarser));
+    }
+
+    logger_base.debug("PrepareSampleMinMax: Waveform prepared in %ld.", sw.Time());
+
+    SaveSampleMinMaxCache(cacheFile);
+    _sampleMinMaxReady = true;
 }
 
 void AudioManager::GetTrackMetrics(AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream)
@@ -2066,6 +2389,56 @@ float AudioManager::GetLeftData(long offset)
 	return _data[0][offset];
 }
 
+// The smallest and largest left channel samples from start up to but not including end ... 1 and -1 if there are none.
+// Whole blocks come from the min max pyramid once it is ready and only the ragged ends are read sample by sample.
+void AudioManager::GetLeftDataMinMax(long start, long end, float& minimum, float& maximum)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    minimum = 1;
+    maximum = -1;
+
+    end = std::min(end, _trackSize);
+    while (!IsDataLoaded(end))
+    {
+        logger_base.debug("GetLeftDataMinMax waiting for data to be loaded.");
+        wxMilliSleep(100);
+    }
+
+    if (_data[0] == nullptr || start >= end) return;
+
+    long pos = std::max(start, 0L);
+    if (_sampleMinMaxReady && !_sampleMinMax.empty())
+    {
+        const long block = 1 << SAMPLEMINMAX_SHIFT;
+        for (; pos < end && (pos & (block - 1)) != 0; pos++)
+        {
+            minimum = std::min(minimum, _data[0][pos]);
+            maximum = std::max(maximum, _data[0][pos]);
+        }
+
+        // take the coarsest level whose block starts here and fits in what is left
+        while (pos + block <= end)
+        {
+            size_t level = 0;
+            while (level + 1 < _sampleMinMax.size() && (pos & ((block << (level + 1)) - 1)) == 0 && pos + (block << (level + 1)) <= end)
+            {
+                level++;
+            }
+            long b = pos >> (SAMPLEMINMAX_SHIFT + level);
+            minimum = std::min(minimum, _sampleMinMax[level][b * 2]);
+            maximum = std::max(maximum, _sampleMinMax[level][b * 2 + 1]);
+            pos += block << level;
+        }
+    }
+
+    for (; pos < end; pos++)
+    {
+        minimum = std::min(minimum, _data[0][pos]);
+        maximum = std::max(maximum, _data[0][pos]);
+    }
+}
+
 // Access a single piece of track data
 float AudioManager::GetRightData(long offset)
 {
@@ -2165,6 +2538,9 @@ xLightsVamp::~xLightsVamp() {}
 
 std::string AudioManager::Hash()
 {
+    // the frame data and the waveform can both want it at once from different threads
+    std::unique_lock<std::mutex> locker(_hashLock);
+
     if (_hash == "")
     {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
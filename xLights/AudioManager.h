@@ -3,6 +3,11 @@
 
 #include <string>
 #include <list>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <shared_mutex>
 
 extern "C"
@@ -93,6 +98,51 @@ typedef enum FRAMEDATATYPE {
 	FRAMEDATA_NOTES
 } FRAMEDATATYPE;
 
+// A read only view of the values of one type of frame data for a single frame
+class AudioFrameData
+{
+    const float* _begin;
+    const float* _end;
+    bool _valid;
+
+public:
+    AudioFrameData() : _begin(nullptr), _end(nullptr), _valid(false) {}
+    AudioFrameData(const float* begin, const float* end) : _begin(begin), _end(end), _valid(true) {}
+
+    // false if there is no data for the frame
+    bool IsValid() const { return _valid; }
+    const float* begin() const { return _begin; }
+    const float* end() const { return _end; }
+    size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+    float front() const { return *_begin; }
+    float operator[](size_t i) const { return _begin[i]; }
+};
+
+// The values of one type of frame data for every frame of the song in one contiguous array.
+// Most types have the same number of values in every frame ... those that dont (notes) keep the
+// offset of each frame's values.
+class AudioFrameDataStore
+{
+    size_t _stride; // values per frame, 0 if it varies
+    size_t _frames;
+    std::vector<float> _values;
+    std::vector<size_t> _offsets; // frames + 1 entries when the stride varies
+
+public:
+    AudioFrameDataStore() : _stride(0), _frames(0) {}
+
+    void Clear() { _stride = 0; _frames = 0; _values.clear(); _offsets.clear(); }
+    // zero filled frames of a fixed size
+    void SetFixedStride(size_t stride, size_t frames) { _stride = stride; _frames = frames; _values.assign(stride * frames, 0.0f); _offsets.clear(); }
+    // frames of varying size
+    void SetFrames(const std::vector<std::vector<float>>& frames);
+    size_t GetFrameCount() const { return _frames; }
+    float* GetFramePtr(size_t frame) { return &_values[frame * _stride]; }
+    void Scale(float scale);
+    AudioFrameData GetFrame(size_t frame) const;
+};
+
 typedef enum MEDIAPLAYINGSTATE {
 	PLAYING,
 	PAUSED,
@@ -183,7 +233,7 @@ class AudioManager
     Job* _jobAudioLoad;
     std::shared_timed_mutex _mutexAudioLoad;
     long _loadedData;
-    std::vector<std::vector<std::list<float>>> _frameData;
+    AudioFrameDataStore _frameData[FRAMEDATA_NOTES + 1]; // indexed by FRAMEDATATYPE
 	std::string _audio_file;
 	xLightsVamp _vamp;
 	long _rate;
@@ -201,7 +251,11 @@ class AudioManager
 	std::string _album;
 	int _intervalMS;
 	long _lengthMS;
-	bool _frameDataPrepared;
+	std::atomic_bool _frameDataPrepared;
+	std::atomic_bool _frameDataLevelsPrepared; // high, low and spread are ready before the spectrum
+	std::atomic_bool _frameDataStarted;
+	std::mutex _frameDataReadyLock;
+	std::condition_variable _frameDataReadySignal;
 	float _bigmax;
 	float _bigspread;
 	float _bigmin;
@@ -211,6 +265,9 @@ class AudioManager
     int _sdlid;
     bool _ok;
     std::string _hash;
+    std::mutex _hashLock;
+    std::vector<std::vector<float>> _sampleMinMax; // min max pairs of the left channel ... each level's blocks are twice the size of the last
+    std::atomic_bool _sampleMinMaxReady;
 
 	void GetTrackMetrics(AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream);
 	void LoadTrackData(AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream);
@@ -223,9 +280,20 @@ class AudioManager
     static int decodebitrateindex(int bitrateindex, int version, int layertype);
 	int decodesamplerateindex(int samplerateindex, int version) const;
     static int decodesideinfosize(int version, int mono);
-	std::list<float> CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const;
+	std::vector<float> CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const;
+	void ProcessFrameDataChunks(int frames, const std::function<void(int, int, int)>& fn);
+	static void GetSpectrumWindows(int frame, int samplesperframe, int totalsamples, int& first, int& last);
+	bool CalculateFrameSpectrum(int frame, int samplesperframe, int totalsamples, std::vector<float>& spectrogram, float& max);
+	void SetFrameDataReady(bool levels, bool all);
+	std::string GetFrameDataCacheFile();
+	bool LoadFrameDataCache(const std::string& filename, int frames);
+	void SaveFrameDataCache(const std::string& filename, int frames);
     void LoadAudioData(bool separateThread, AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream, AVFrame* frame);
     void SetLoadedData(long pos);
+	void PrepareSampleMinMax();
+	std::string GetSampleMinMaxCacheFile();
+	bool LoadSampleMinMaxCache(const std::string& filename);
+	void SaveSampleMinMaxCache(const std::string& filename);
 
 public:
     bool IsOk() const { return _ok; }
@@ -263,12 +331,13 @@ public:
 	long LengthMS() const { return _lengthMS; };
 	float GetRightData(long offset);
 	float GetLeftData(long offset);
+	void GetLeftDataMinMax(long start, long end, float& minimum, float& maximum);
 	float* GetRightDataPtr(long offset);
 	float* GetLeftDataPtr(long offset);
 	void SetStepBlock(int step, int block);
 	void SetFrameInterval(int intervalMS);
 	int GetFrameInterval() const { return _intervalMS; }
-	std::list<float>* GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
+	AudioFrameData GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
 	void DoPrepareFrameData();
 	void DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback progresscallback);
 	bool IsPolyphonicTranscriptionDone() const { return _polyphonicTranscriptionDone; };
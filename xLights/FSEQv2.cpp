@@ -0,0 +1,482 @@
+#include "FSEQv2.h"
+
+#include <wx/zstream.h>
+#include <wx/mstream.h>
+#include <log4cpp/Category.hh>
+
+#include <algorithm>
+#include <string.h>
+
+static void SetInt16(unsigned char* buf, unsigned int v)
+{
+    buf[0] = (unsigned char)(v & 0xFF);
+    buf[1] = (unsigned char)((v >> 8) & 0xFF);
+}
+
+static void SetInt24(unsigned char* buf, unsigned int v)
+{
+    SetInt16(buf, v);
+    buf[2] = (unsigned char)((v >> 16) & 0xFF);
+}
+
+static void SetInt32(unsigned char* buf, unsigned int v)
+{
+    SetInt24(buf, v);
+    buf[3] = (unsigned char)((v >> 24) & 0xFF);
+}
+
+static unsigned int GetInt16(const unsigned char* buf)
+{
+    return buf[0] + (buf[1] << 8);
+}
+
+static unsigned int GetInt24(const unsigned char* buf)
+{
+    return GetInt16(buf) + (buf[2] << 16);
+}
+
+static unsigned int GetInt32(const unsigned char* buf)
+{
+    return GetInt24(buf) + ((unsigned int)buf[3] << 24);
+}
+
+#pragma region Writer
+
+FSEQv2Writer::FSEQv2Writer(unsigned int channels, unsigned int frames, unsigned int stepTime, int compressionLevel)
+{
+    _channels = channels;
+    _frames = frames;
+    _stepTime = stepTime;
+    _compressionLevel = compressionLevel;
+    _framesPerBlock = 1;
+    _storedChannels = channels;
+    _framesWritten = 0;
+    _blockBuffer = nullptr;
+    _blockFrames = 0;
+    _ok = false;
+}
+
+FSEQv2Writer::~FSEQv2Writer()
+{
+    if (_file.IsOpened())
+    {
+        _file.Close();
+    }
+    if (_blockBuffer != nullptr)
+    {
+        free(_blockBuffer);
+    }
+}
+
+void FSEQv2Writer::AddSparseRange(unsigned int start, unsigned int count)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // AddFrame copies the ranges out of a full frame so they must lie within it
+    if (start >= _channels || count > _channels - start)
+    {
+        logger_base.warn("FSEQ sparse range %u-%u is outside the %u channels being written ... ignored.", start, start + count, _channels);
+        return;
+    }
+
+    if (_ranges.size() < FSEQ_V2_MAX_RANGES && count > 0)
+    {
+        _ranges.push_back(FSEQv2Range(start, count));
+    }
+}
+
+void FSEQv2Writer::WriteHeader()
+{
+    size_t mfLen = _mediaFilename == "" ? 0 : _mediaFilename.size() + 5;
+    size_t varHeaderOffset = FSEQ_V2_HEADER_SIZE + _blocks.size() * 8 + _ranges.size() * 6;
+    size_t dataOffset = (varHeaderOffset + mfLen + 3) & ~3;
+
+    std::vector<unsigned char> header(dataOffset, 0);
+    unsigned char* buf = &header[0];
+    buf[0] = 'P';
+    buf[1] = 'S';
+    buf[2] = 'E';
+    buf[3] = 'Q';
+    SetInt16(&buf[4], dataOffset);
+    buf[6] = 0;
+    buf[7] = 2;
+    SetInt16(&buf[8], varHeaderOffset);
+    SetInt32(&buf[10], _storedChannels);
+    SetInt32(&buf[14], _frames);
+    buf[18] = (unsigned char)std::min(_stepTime, 255u);
+    buf[20] = FSEQ_V2_COMPRESSION_ZLIB;
+    buf[21] = (unsigned char)_blocks.size();
+    buf[22] = (unsigned char)_ranges.size();
+    wxLongLong id = wxGetUTCTimeMillis();
+    SetInt32(&buf[24], id.GetLo());
+    SetInt32(&buf[28], id.GetHi());
+
+    unsigned char* p = &buf[FSEQ_V2_HEADER_SIZE];
+    for (auto it = _blocks.begin(); it != _blocks.end(); ++it)
+    {
+        SetInt32(p, it->first);
+        SetInt32(p + 4, it->second);
+        p += 8;
+    }
+    for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+    {
+        SetInt24(p, it->start);
+        SetInt24(p + 3, it->count);
+        p += 6;
+    }
+    if (mfLen > 0)
+    {
+        SetInt16(p, mfLen);
+        p[2] = 'm';
+        p[3] = 'f';
+        strcpy((char *)&p[4], _mediaFilename.c_str());
+    }
+
+    _file.Write(buf, dataOffset);
+}
+
+bool FSEQv2Writer::Open(const wxString& filename)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_file.Create(filename, true))
+    {
+        logger_base.error("Unable to create fseq file %s.", (const char *)filename.c_str());
+        return false;
+    }
+
+    if (!_ranges.empty())
+    {
+        _storedChannels = 0;
+        for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+        {
+            _storedChannels += it->count;
+        }
+    }
+
+    // blocks are as small as the block count allows so seeking only has to decompress a few frames
+    _framesPerBlock = std::max(1u, (_frames + FSEQ_V2_MAX_BLOCKS - 1) / FSEQ_V2_MAX_BLOCKS);
+    unsigned int numBlocks = (_frames + _framesPerBlock - 1) / _framesPerBlock;
+    _blocks.assign(numBlocks, std::make_pair(0u, 0u));
+
+    _blockBuffer = (unsigned char*)malloc((size_t)_storedChannels * _framesPerBlock + 1);
+    if (_blockBuffer == nullptr)
+    {
+        logger_base.error("Unable to allocate fseq block buffer.");
+        _file.Close();
+        return false;
+    }
+
+    // placeholder, the block index is filled in on close
+    WriteHeader();
+    _ok = true;
+    return true;
+}
+
+bool FSEQv2Writer::FlushBlock()
+{
+    if (_blockFrames == 0) return true;
+
+    wxMemoryOutputStream mo;
+    {
+        wxZlibOutputStream zo(mo, _compressionLevel, wxZLIB_ZLIB);
+        zo.Write(_blockBuffer, (size_t)_blockFrames * _storedChannels);
+        zo.Close();
+    }
+
+    size_t len = mo.GetSize();
+    std::vector<unsigned char> compressed(len + 1);
+    mo.CopyTo(&compressed[0], len);
+    if (_file.Write(&compressed[0], len) != len)
+    {
+        _ok = false;
+        return false;
+    }
+
+    unsigned int block = (_framesWritten - _blockFrames) / _framesPerBlock;
+    if (block < _blocks.size())
+    {
+        _blocks[block] = std::make_pair(_framesWritten - _blockFrames, (unsigned int)len);
+    }
+    _blockFrames = 0;
+    return true;
+}
+
+bool FSEQv2Writer::AddFrame(const unsigned char* data)
+{
+    if (!_ok || _framesWritten >= _frames) return false;
+
+    unsigned char* dest = _blockBuffer + (size_t)_blockFrames * _storedChannels;
+    if (_ranges.empty())
+    {
+        memcpy(dest, data, _storedChannels);
+    }
+    else
+    {
+        for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+        {
+            memcpy(dest, data + it->start, it->count);
+            dest += it->count;
+        }
+    }
+    _blockFrames++;
+    _framesWritten++;
+
+    if (_blockFrames == _framesPerBlock)
+    {
+        return FlushBlock();
+    }
+    return true;
+}
+
+bool FSEQv2Writer::Close()
+{
+    if (!_file.IsOpened()) return false;
+
+    FlushBlock();
+    _file.Seek(0);
+    WriteHeader();
+    _file.Close();
+
+    if (_blockBuffer != nullptr)
+    {
+        free(_blockBuffer);
+        _blockBuffer = nullptr;
+    }
+
+    return _ok;
+}
+
+#pragma endregion Writer
+
+#pragma region Reader
+
+bool FSEQv2Reader::IsV2(const unsigned char* header, size_t len)
+{
+    return len >= 8 &&
+        header[0] == 'P' && header[1] == 'S' && header[2] == 'E' && header[3] == 'Q' &&
+        header[7] == 2;
+}
+
+FSEQv2Reader::FSEQv2Reader()
+{
+    _storedChannels = 0;
+    _channels = 0;
+    _frames = 0;
+    _stepTime = 50;
+    _compression = FSEQ_V2_COMPRESSION_NONE;
+    _dataOffset = 0;
+    _currentBlock = -1;
+    _currentBlockFrames = 0;
+    _ok = false;
+}
+
+FSEQv2Reader::~FSEQv2Reader()
+{
+    Close();
+}
+
+void FSEQv2Reader::Close()
+{
+    if (_file.IsOpened())
+    {
+        _file.Close();
+    }
+    _blocks.clear();
+    _blockOffsets.clear();
+    _ranges.clear();
+    _blockData.clear();
+    _compressed.clear();
+    _currentBlock = -1;
+    _ok = false;
+}
+
+bool FSEQv2Reader::Open(const wxString& filename)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    Close();
+
+    if (!_file.Open(filename))
+    {
+        logger_base.error("Unable to open fseq file %s.", (const char *)filename.c_str());
+        return false;
+    }
+
+    unsigned char hdr[FSEQ_V2_HEADER_SIZE];
+    if (_file.Read(hdr, sizeof(hdr)) != sizeof(hdr) || !IsV2(hdr, sizeof(hdr)))
+    {
+        logger_base.error("File %s is not a v2 fseq file.", (const char *)filename.c_str());
+        _file.Close();
+        return false;
+    }
+
+    _dataOffset = GetInt16(&hdr[4]);
+    unsigned int varHeaderOffset = GetInt16(&hdr[8]);
+    _storedChannels = GetInt32(&hdr[10]);
+    _frames = GetInt32(&hdr[14]);
+    _stepTime = hdr[18];
+    _compression = hdr[20] & 0x0F;
+    int numBlocks = hdr[21];
+    int numRanges = hdr[22];
+
+    if (_compression != FSEQ_V2_COMPRESSION_NONE && _compression != FSEQ_V2_COMPRESSION_ZLIB)
+    {
+        logger_base.error("fseq file %s uses unsupported compression type %d.", (const char *)filename.c_str(), _compression);
+        _file.Close();
+        return false;
+    }
+
+    if (_dataOffset < FSEQ_V2_HEADER_SIZE)
+    {
+        logger_base.error("fseq file %s header is corrupt.", (const char *)filename.c_str());
+        _file.Close();
+        return false;
+    }
+    std::vector<unsigned char> header(_dataOffset);
+    _file.Seek(0);
+    if (_file.Read(&header[0], (size_t)_dataOffset) != (ssize_t)_dataOffset)
+    {
+        logger_base.error("fseq file %s header is truncated.", (const char *)filename.c_str());
+        _file.Close();
+        return false;
+    }
+
+    const unsigned char* p = &header[FSEQ_V2_HEADER_SIZE];
+    wxFileOffset offset = _dataOffset;
+    for (int i = 0; i < numBlocks && p + 8 <= &header[0] + header.size(); ++i)
+    {
+        unsigned int frame = GetInt32(p);
+        unsigned int len = GetInt32(p + 4);
+        if (len > 0)
+        {
+            _blocks.push_back(std::make_pair(frame, len));
+            _blockOffsets.push_back(offset);
+        }
+        offset += len;
+        p += 8;
+    }
+
+    _channels = _storedChannels;
+    for (int i = 0; i < numRanges && p + 6 <= &header[0] + header.size(); ++i)
+    {
+        _ranges.push_back(FSEQv2Range(GetInt24(p), GetInt24(p + 3)));
+        p += 6;
+    }
+    if (!_ranges.empty())
+    {
+        _channels = 0;
+        for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+        {
+            _channels = std::max(_channels, it->start + it->count);
+        }
+    }
+
+    p = &header[0] + varHeaderOffset;
+    while (p + 4 <= &header[0] + header.size())
+    {
+        unsigned int len = GetInt16(p);
+        if (len < 4 || p + len > &header[0] + header.size()) break;
+        if (p[2] == 'm' && p[3] == 'f')
+        {
+            _mediaFilename = std::string((const char*)(p + 4), strnlen((const char*)(p + 4), len - 4));
+        }
+        p += len;
+    }
+
+    _ok = true;
+    logger_base.debug("fseq v2 file %s opened. Frames=%d, Channels=%d, Stored=%d, Blocks=%d, Ranges=%d.",
+        (const char *)filename.c_str(), _frames, _channels, _storedChannels, (int)_blocks.size(), (int)_ranges.size());
+    return true;
+}
+
+int FSEQv2Reader::FindBlock(unsigned int frame) const
+{
+    auto it = std::upper_bound(_blocks.begin(), _blocks.end(), frame,
+        [](unsigned int f, const std::pair<unsigned int, unsigned int>& b) { return f < b.first; });
+    if (it == _blocks.begin()) return -1;
+    return (int)(it - _blocks.begin()) - 1;
+}
+
+bool FSEQv2Reader::LoadBlock(int block)
+{
+    if (block == _currentBlock) return true;
+
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    unsigned int firstFrame = _blocks[block].first;
+    unsigned int endFrame = (block + 1 < (int)_blocks.size()) ? _blocks[block + 1].first : _frames;
+    if (endFrame > _frames) endFrame = _frames;
+    if (endFrame <= firstFrame) return false;
+    unsigned int frames = endFrame - firstFrame;
+
+    unsigned int len = _blocks[block].second;
+    _compressed.resize(len);
+    if (_file.Seek(_blockOffsets[block]) == wxInvalidOffset || _file.Read(&_compressed[0], len) != (ssize_t)len)
+    {
+        logger_base.error("Unable to read fseq block %d.", block);
+        return false;
+    }
+
+    size_t size = (size_t)frames * _storedChannels;
+    _blockData.resize(size + 1);
+    wxMemoryInputStream mi(&_compressed[0], len);
+    wxZlibInputStream zi(mi, wxZLIB_ZLIB);
+    zi.Read(&_blockData[0], size);
+    if (zi.LastRead() != size)
+    {
+        logger_base.error("fseq block %d decompressed to %d bytes rather than %d.", block, (int)zi.LastRead(), (int)size);
+        _currentBlock = -1;
+        return false;
+    }
+
+    _currentBlock = block;
+    _currentBlockFrames = frames;
+    return true;
+}
+
+bool FSEQv2Reader::ReadFrame(unsigned int frame, unsigned char* data, size_t dataSize)
+{
+    if (!_ok || frame >= _frames) return false;
+
+    const unsigned char* src = nullptr;
+    if (_compression == FSEQ_V2_COMPRESSION_NONE)
+    {
+        _blockData.resize(_storedChannels + 1);
+        wxFileOffset pos = _dataOffset + (wxFileOffset)frame * _storedChannels;
+        if (_file.Tell() != pos)
+        {
+            _file.Seek(pos);
+        }
+        if (_file.Read(&_blockData[0], _storedChannels) != (ssize_t)_storedChannels) return false;
+        src = &_blockData[0];
+    }
+    else
+    {
+        int block = FindBlock(frame);
+        if (block < 0 || !LoadBlock(block)) return false;
+        unsigned int idx = frame - _blocks[block].first;
+        if (idx >= _currentBlockFrames) return false;
+        src = &_blockData[(size_t)idx * _storedChannels];
+    }
+
+    if (_ranges.empty())
+    {
+        memcpy(data, src, std::min((size_t)_storedChannels, dataSize));
+    }
+    else
+    {
+        // channels that were not stored are off
+        memset(data, 0x00, dataSize);
+        for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+        {
+            if (it->start < dataSize)
+            {
+                memcpy(data + it->start, src, std::min((size_t)it->count, dataSize - it->start));
+            }
+            src += it->count;
+        }
+    }
+    return true;
+}
+
+#pragma endregion Reader
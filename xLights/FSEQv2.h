@@ -0,0 +1,127 @@
+#ifndef FSEQV2_H
+#define FSEQV2_H
+
+#include <string>
+#include <vector>
+#include <wx/wx.h>
+#include <wx/file.h>
+
+// Version 2 of the falcon player sequence format (.fseq)
+//
+// The frames are stored in blocks of consecutive frames that are each zlib compressed. A block
+// index in the header gives the first frame and compressed size of each block so any frame can
+// be reached by reading and decompressing a single block. Optionally only some channel ranges
+// are stored (sparse) in which case the frame data is those ranges packed one after the other.
+//
+//  0-3   'PSEQ'
+//  4-5   offset to channel data
+//  6     minor version (0)
+//  7     major version (2)
+//  8-9   offset to variable headers
+//  10-13 channels stored per frame
+//  14-17 number of frames
+//  18    step time in ms
+//  19    flags (unused)
+//  20    compression type 0 = none, 2 = zlib
+//  21    number of compression blocks
+//  22    number of sparse ranges
+//  23    flags (unused)
+//  24-31 unique id
+//  32    block index: first frame (4 bytes), compressed length (4 bytes) per block
+//        sparse ranges: start channel (3 bytes), channel count (3 bytes) per range
+//        variable headers: length (2 bytes), code (2 bytes), data ... eg 'mf' media file
+
+#define FSEQ_V2_HEADER_SIZE 32
+#define FSEQ_V2_MAX_BLOCKS 255
+#define FSEQ_V2_MAX_RANGES 255
+#define FSEQ_V2_COMPRESSION_NONE 0
+#define FSEQ_V2_COMPRESSION_ZLIB 2
+
+class FSEQv2Range
+{
+public:
+    FSEQv2Range(unsigned int s, unsigned int c) : start(s), count(c) {}
+    unsigned int start;
+    unsigned int count;
+};
+
+class FSEQv2Writer
+{
+    wxFile _file;
+    std::string _mediaFilename;
+    std::vector<FSEQv2Range> _ranges;
+    std::vector<std::pair<unsigned int, unsigned int>> _blocks;
+    unsigned int _channels;
+    unsigned int _frames;
+    unsigned int _stepTime;
+    unsigned int _framesPerBlock;
+    unsigned int _storedChannels;
+    unsigned int _framesWritten;
+    int _compressionLevel;
+    unsigned char* _blockBuffer;
+    unsigned int _blockFrames;
+    bool _ok;
+
+    void WriteHeader();
+    bool FlushBlock();
+
+public:
+    FSEQv2Writer(unsigned int channels, unsigned int frames, unsigned int stepTime, int compressionLevel = 6);
+    virtual ~FSEQv2Writer();
+
+    void SetMediaFilename(const std::string& mediaFilename) { _mediaFilename = mediaFilename; }
+    // only store these channels, must be called before Open
+    void AddSparseRange(unsigned int start, unsigned int count);
+
+    bool Open(const wxString& filename);
+    // data is a full frame of channels
+    bool AddFrame(const unsigned char* data);
+    bool Close();
+    bool IsOk() const { return _ok; }
+};
+
+class FSEQv2Reader
+{
+    wxFile _file;
+    std::string _mediaFilename;
+    std::vector<FSEQv2Range> _ranges;
+    std::vector<std::pair<unsigned int, unsigned int>> _blocks; // first frame, compressed length
+    std::vector<wxFileOffset> _blockOffsets;
+    unsigned int _storedChannels;
+    unsigned int _channels;
+    unsigned int _frames;
+    unsigned int _stepTime;
+    int _compression;
+    wxFileOffset _dataOffset;
+    std::vector<unsigned char> _blockData;
+    std::vector<unsigned char> _compressed;
+    int _currentBlock;
+    unsigned int _currentBlockFrames;
+    bool _ok;
+
+    int FindBlock(unsigned int frame) const;
+    bool LoadBlock(int block);
+
+public:
+    // true if the header looks like a v2 fseq
+    static bool IsV2(const unsigned char* header, size_t len);
+
+    FSEQv2Reader();
+    virtual ~FSEQv2Reader();
+
+    bool Open(const wxString& filename);
+    void Close();
+    bool IsOk() const { return _ok; }
+
+    // channels in a full frame, for sparse files this is the end of the last range
+    unsigned int GetChannels() const { return _channels; }
+    unsigned int GetFrames() const { return _frames; }
+    unsigned int GetStepTime() const { return _stepTime; }
+    std::string GetMediaFilename() const { return _mediaFilename; }
+    bool IsSparse() const { return !_ranges.empty(); }
+
+    // reads a frame into data expanding any sparse ranges, channels outside the ranges are left untouched
+    bool ReadFrame(unsigned int frame, unsigned char* data, size_t dataSize);
+};
+
+#endif
@@ -16,6 +16,7 @@
 #include "ConvertDialog.h"
 #include "ConvertLogDialog.h"
 #include "outputs/Output.h"
+#include "FSEQv2.h"
 
 #define string_format wxString::Format
 
@@ -1594,6 +1595,13 @@ void FileConverter::ReadFalconFile(ConvertParameters& params)
     unsigned char hdr[1024];
     f.Read(hdr, fixedHeaderLength);
 
+    if (FSEQv2Reader::IsV2(hdr, fixedHeaderLength))
+    {
+        f.Close();
+        ReadFalconV2File(params);
+        return;
+    }
+
     int dataOffset = hdr[4] + (hdr[5] << 8);
     if (dataOffset < 1024) {
         f.Seek(0);
@@ -1689,6 +1697,97 @@ void FileConverter::ReadFalconFile(ConvertParameters& params)
     f.Close();
 }
 
+void FileConverter::ReadFalconV2File(ConvertParameters& params)
+{
+    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+
+    FSEQv2Reader reader;
+    if (!reader.Open(params.inp_filename))
+    {
+        logger_conversion.debug("Unable to load sequence: %s.", (const char *)params.inp_filename.c_str());
+        params.PlayerError(wxString("Unable to load sequence:\n") + params.inp_filename);
+        return;
+    }
+
+    int numChannels = reader.GetChannels();
+    int falconPeriods = reader.GetFrames();
+    wxString mf = reader.GetMediaFilename();
+
+    if (params.media_filename) {
+        *params.media_filename = mf;
+    }
+
+    if (params.read_mode == ConvertParameters::READ_MODE_LOAD_MAIN) {
+        params.xLightsFrm->SetMediaFilename(mf);
+    }
+
+    if (params.data_layer != nullptr)
+    {
+        params.data_layer->SetNumFrames(falconPeriods);
+        params.data_layer->SetNumChannels(numChannels);
+    }
+
+    if (params.read_mode == ConvertParameters::READ_MODE_HEADER_ONLY)
+    {
+        return;
+    }
+
+    if (params.read_mode == ConvertParameters::READ_MODE_LOAD_MAIN ||
+        params.read_mode == ConvertParameters::READ_MODE_IMPORT)
+    {
+        params.seq_data.init(numChannels, falconPeriods, reader.GetStepTime());
+    }
+
+    int channel_offset = 0;
+    if (params.data_layer)
+    {
+        channel_offset = params.data_layer->GetChannelOffset();
+    }
+
+    // frames come out of the file in block order so reading them in order only decompresses each block once
+    unsigned char *tmpBuf = new unsigned char[numChannels];
+    for (int frame = 0; frame < falconPeriods; frame++)
+    {
+        if (channel_offset == 0 && params.read_mode != ConvertParameters::READ_MODE_IGNORE_BLACK) {
+            if (!reader.ReadFrame(frame, &params.seq_data[frame][0], params.seq_data.NumChannels()))
+            {
+                params.PlayerError(wxString("Unable to read all event data from:\n") + params.inp_filename);
+                break;
+            }
+        }
+        else {
+            memset(tmpBuf, 0x00, numChannels);
+            if (!reader.ReadFrame(frame, tmpBuf, numChannels))
+            {
+                params.PlayerError(wxString("Unable to read all event data from:\n") + params.inp_filename);
+                break;
+            }
+
+            for (int i = 0; i < numChannels; i++)
+            {
+                int new_index = i + channel_offset;
+                if ((new_index < 0) || (new_index >= numChannels)) continue;
+                if (params.read_mode == ConvertParameters::READ_MODE_IGNORE_BLACK)
+                {
+                    if (tmpBuf[i] != 0)
+                    {
+                        params.seq_data[frame][new_index] = tmpBuf[i];
+                    }
+                }
+                else
+                {
+                    params.seq_data[frame][new_index] = tmpBuf[i];
+                }
+            }
+        }
+    }
+    delete[]tmpBuf;
+
+#ifndef NDEBUG
+    params.AppendConvertStatus(string_format(wxString("Read FSEQ v2 File SeqData.NumFrames()=%d SeqData.NumChannels()=%d"), params.seq_data.NumFrames(), params.seq_data.NumChannels()));
+#endif
+}
+
 void FileConverter::WriteFalconPiFile(ConvertParameters& params)
 {
     static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
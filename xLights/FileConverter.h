@@ -78,6 +78,7 @@ class FileConverter
         static void ReadGlediatorFile(ConvertParameters& params);
         static void ReadConductorFile(ConvertParameters& params);
         static void ReadFalconFile(ConvertParameters& params);
+        static void ReadFalconV2File(ConvertParameters& params);
         static void WriteFalconPiFile(ConvertParameters& params);
 
     
@@ -280,15 +280,15 @@ void JobPool::PushJob(Job *job)
     signal.notify_all();
 }
 
-void JobPool::Start(size_t poolSize)
+void JobPool::Start(size_t poolSize, size_t minPoolSize)
 {
     static log4cpp::Category &logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
     if (poolSize > 250) {
         poolSize = 250;
     }
     
-    if (poolSize < 20) {
-        poolSize = 20;
+    if (poolSize < minPoolSize) {
+        poolSize = minPoolSize;
     }
 
     maxNumThreads = poolSize;
@@ -47,7 +47,7 @@ public:
     
     virtual void PushJob(Job *job);
     int size() const { return (int)threads.size(); }
-    virtual void Start(size_t poolSize = 1);
+    virtual void Start(size_t poolSize = 1, size_t minPoolSize = 20);
     virtual void Stop();
     
     virtual std::string GetThreadStatus();
@@ -2227,6 +2227,7 @@ void LayoutPanel::OnPreviewModelPopup(wxCommandEvent &event)
             render_ht = render_ht / wi_ratio;
             md->GetModelScreenLocation().SetMHeight((int)render_ht);
         }
+        md->IncrementChangeCount();
         UpdatePreview();
     }
     else if (event.GetId() == ID_PREVIEW_MODEL_EXPORTXLIGHTSMODEL)
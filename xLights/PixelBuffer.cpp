@@ -84,6 +84,7 @@ void PixelBufferClass::reset(int nlayers, int timing)
         layers[x] = new LayerInfo(frame);
         layers[x]->buffer.SetFrameTimeInMs(frameTimeInMs);
         model->InitRenderBufferNodes("Default", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
+        layers[x]->buffer.UpdateNodeTable();
         layers[x]->bufferType = "Default";
         layers[x]->bufferTransform = "None";
         layers[x]->outTransitionType = "Fade";
@@ -117,6 +118,7 @@ void PixelBufferClass::InitPerModelBuffers(const ModelGroup &model, int layer, i
         RenderBuffer *buf = new RenderBuffer(frame);
         buf->SetFrameTimeInMs(timing);
         m->InitRenderBufferNodes("Default", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
+        buf->UpdateNodeTable();
         buf->InitBuffer(buf->BufferHt, buf->BufferWi, buf->BufferHt, buf->BufferWi, "None");
         layers[layer]->modelBuffers.push_back(std::unique_ptr<RenderBuffer>(buf));
     }
@@ -321,226 +323,557 @@ void PixelBufferClass::SetMixType(int layer, const std::string& MixName)
     layers[layer]->buffer.SetAllowAlphaChannel(MixTypeHandlesAlpha(MixType));
 }
 
-void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer)
+#pragma region Compositor
+// The layers are mixed a whole layer at a time. For each layer we first work out where each output pixel
+// comes from (the gather), then produce the adjusted layer colours and finally mix them into the output
+// in runs using one loop per mix type.
+
+// values for LayerGather::index that are not pixel indexes
+#define GATHER_TRANSPARENT -1 // masked or outside the layer
+#define GATHER_SKIP -2 // the layer does not contribute to this pixel
+#define GATHER_BLACK -3 // outside the layer's render buffer
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define COMPOSITOR_SSE2
+#include <emmintrin.h>
+#endif
+
+// same as asHSV().value but without the rest of the conversion
+static inline double ColorValue(const xlColor& c)
 {
-    static const int n = 0;  //increase to change the curve of the crossfade
-    
-    if (!layers[layer]->buffer.allowAlpha && layers[layer]->fadeFactor != 1.0) {
-        //need to fade the first here as we're not mixing anything
-        HSVValue hsv0 = fg.asHSV();
-        hsv0.value *= layers[layer]->fadeFactor;
-        fg = hsv0;
+    return std::max(c.red, std::max(c.green, c.blue)) / 255.0;
+}
+
+#ifdef COMPOSITOR_SSE2
+// xlColor is 4 bytes (rgba) so we can do 4 pixels at a time. All these modes leave the result opaque.
+#define COMPOSITOR_SIMD_LOOP(fg, bg, count, op) \
+    { \
+        const __m128i opaque = _mm_set1_epi32(0xFF000000); \
+        for (; i + 4 <= count; i += 4) \
+        { \
+            __m128i f = _mm_loadu_si128((const __m128i*)(fg + i)); \
+            __m128i b = _mm_loadu_si128((const __m128i*)(bg + i)); \
+            _mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(op, opaque)); \
+        } \
+    }
+#else
+#define COMPOSITOR_SIMD_LOOP(fg, bg, count, op)
+#endif
+
+static void MixAdditive(const xlColor* fg, xlColor* bg, size_t count)
+{
+    size_t i = 0;
+    COMPOSITOR_SIMD_LOOP(fg, bg, count, _mm_adds_epu8(f, b));
+    for (; i < count; i++)
+    {
+        int r = fg[i].red + bg[i].red;
+        int g = fg[i].green + bg[i].green;
+        int b = fg[i].blue + bg[i].blue;
+        if (r > 255) r = 255;
+        if (g > 255) g = 255;
+        if (b > 255) b = 255;
+        bg[i].Set(r, g, b);
     }
+}
 
-    float svthresh = layers[layer]->effectMixThreshold;
-    if (layers[layer]->effectMixVaries) {
-        //vary mix threshold gradually during effect interval -DJ
-        layers[layer]->effectMixThreshold = layers[layer]->buffer.GetEffectTimeIntervalPosition();
+static void MixSubtractive(const xlColor* fg, xlColor* bg, size_t count)
+{
+    size_t i = 0;
+    COMPOSITOR_SIMD_LOOP(fg, bg, count, _mm_subs_epu8(b, f));
+    for (; i < count; i++)
+    {
+        int r = bg[i].red - fg[i].red;
+        int g = bg[i].green - fg[i].green;
+        int b = bg[i].blue - fg[i].blue;
+        if (r < 0) r = 0;
+        if (g < 0) g = 0;
+        if (b < 0) b = 0;
+        bg[i].Set(r, g, b);
+    }
+}
+
+static void MixMin(const xlColor* fg, xlColor* bg, size_t count)
+{
+    size_t i = 0;
+    COMPOSITOR_SIMD_LOOP(fg, bg, count, _mm_min_epu8(f, b));
+    for (; i < count; i++)
+    {
+        bg[i].Set(std::min(fg[i].red, bg[i].red), std::min(fg[i].green, bg[i].green), std::min(fg[i].blue, bg[i].blue));
+    }
+}
+
+static void MixMax(const xlColor* fg, xlColor* bg, size_t count)
+{
+    size_t i = 0;
+    COMPOSITOR_SIMD_LOOP(fg, bg, count, _mm_max_epu8(f, b));
+    for (; i < count; i++)
+    {
+        bg[i].Set(std::max(fg[i].red, bg[i].red), std::max(fg[i].green, bg[i].green), std::max(fg[i].blue, bg[i].blue));
+    }
+}
+
+static inline void AdjustHSV(xlColor& color, float ha, float sa, float va)
+{
+    HSVValue hsv = color.asHSV();
+
+    if (ha != 0)
+    {
+        hsv.hue += ha;
+        if (hsv.hue < 0)
+        {
+            hsv.hue += 1.0;
+        }
+        else if (hsv.hue > 1)
+        {
+            hsv.hue -= 1.0;
+        }
+    }
+
+    if (sa != 0)
+    {
+        hsv.saturation += sa;
+        if (hsv.saturation < 0)
+        {
+            hsv.saturation = 0.0;
+        }
+        else if (hsv.saturation > 1)
+        {
+            hsv.saturation = 1.0;
+        }
+    }
+
+    if (va != 0)
+    {
+        hsv.value += va;
+        if (hsv.value < 0)
+        {
+            hsv.value = 0.0;
+        }
+        else if (hsv.value > 1)
+        {
+            hsv.value = 1.0;
+        }
+    }
+
+    unsigned char alpha = color.Alpha();
+    color = hsv;
+    color.alpha = alpha;
+}
+
+// Output sample s is node s
+void PixelBufferClass::GatherNodes(LayerInfo* layer, size_t count)
+{
+    _gather.index.resize(count);
+    _gather.x.resize(count);
+    _gather.y.resize(count);
+
+    const NodeTable &table = layer->buffer.nodeTable;
+    size_t nodes = std::min(count, table.size());
+    for (size_t s = 0; s < nodes; s++)
+    {
+        int x = table.bufX[s];
+        int y = table.bufY[s];
+        _gather.x[s] = x;
+        _gather.y[s] = y;
+
+        if (layer->isMasked(x, y)
+            || x < 0
+            || y < 0
+            || x >= layer->BufferWi
+            || y >= layer->BufferHt
+            ) {
+            _gather.index[s] = GATHER_TRANSPARENT;
+        } else if (x >= layer->buffer.BufferWi || y >= layer->buffer.BufferHt) {
+            _gather.index[s] = GATHER_BLACK;
+        } else {
+            _gather.index[s] = y * layer->buffer.BufferWi + x;
+        }
+    }
+
+    // this layer does not have these nodes
+    for (size_t s = nodes; s < count; s++)
+    {
+        _gather.index[s] = GATHER_SKIP;
+    }
+}
+
+// Output sample s is pixel s of a width wide canvas. Pixels that are nodes are skipped as they come from the node output.
+void PixelBufferClass::GatherCanvas(LayerInfo* layer, size_t count, int width, const std::vector<int>& nodeMap)
+{
+    _gather.index.resize(count);
+    _gather.x.resize(count);
+    _gather.y.resize(count);
+
+    for (size_t s = 0; s < count; s++)
+    {
+        int x = s % width;
+        int y = s / width;
+        _gather.x[s] = x;
+        _gather.y[s] = y;
+
+        if (nodeMap[s] >= 0 || x >= layer->BufferWi || y >= layer->BufferHt)
+        {
+            _gather.index[s] = GATHER_SKIP;
+        }
+        else if (layer->isMasked(x, y))
+        {
+            _gather.index[s] = GATHER_TRANSPARENT;
+        }
+        else if (x >= layer->buffer.BufferWi || y >= layer->buffer.BufferHt)
+        {
+            _gather.index[s] = GATHER_BLACK;
+        }
+        else
+        {
+            _gather.index[s] = y * layer->buffer.BufferWi + x;
+        }
+    }
+}
+
+// Fetches the gathered pixels from the layer and applies the layer colour adjustments, sparkles and brightness
+void PixelBufferClass::GetLayerColors(LayerInfo* layer, size_t count, bool sparkles)
+{
+    float ha = layer->frameHueAdjust;
+    float sa = layer->frameSaturationAdjust;
+    float va = layer->frameValueAdjust;
+    bool adjustHSV = ha != 0 || sa != 0 || va != 0;
+    sparkles = sparkles && layer->frameSparkles;
+    int sparkleModulus = 208 - layer->frameSparkleCount;
+    int b = layer->frameBrightness;
+    const xlColor* pixels = layer->buffer.pixels.empty() ? nullptr : &layer->buffer.pixels[0];
+
+    for (size_t s = 0; s < count; s++)
+    {
+        int index = _gather.index[s];
+        if (index == GATHER_SKIP) continue;
+
+        xlColor& color = _layerColors[s];
+        if (index == GATHER_TRANSPARENT)
+        {
+            color.Set(0, 0, 0, 0);
+        }
+        else if (index == GATHER_BLACK)
+        {
+            color = xlBLACK;
+        }
+        else
+        {
+            color = pixels[index];
+        }
+
+        if (adjustHSV)
+        {
+            AdjustHSV(color, ha, sa, va);
+        }
+
+        if (sparkles && color != xlBLACK)
+        {
+            // the node table holds each node's sparkle position so it must advance there to move on next frame
+            unsigned short &sparkle = layers[0]->buffer.nodeTable.sparkle[s];
+            switch (sparkle % sparkleModulus)
+            {
+            case 1:
+            case 7:
+                // too dim
+                //color.Set("#444444");
+                break;
+            case 2:
+            case 6:
+                color.Set(0x88, 0x88, 0x88);
+                break;
+            case 3:
+            case 5:
+                color.Set(0xbb, 0xbb, 0xbb);
+                break;
+            case 4:
+                color.Set(255, 255, 255);
+                break;
+            default:
+                break;
+            }
+            sparkle++;
+        }
+
+        if (layer->contrast != 0) {
+            //contrast is not 0, can handle brightness change at same time
+            HSVValue hsv = color.asHSV();
+            hsv.value = hsv.value * ((double)b / 100.0);
+
+            // Apply Contrast
+            if (hsv.value < 0.5)
+            {
+                // reduce brightness when below 0.5 in the V value or increase if > 0.5
+                hsv.value = hsv.value - (hsv.value* ((double)layer->contrast / 100.0));
+            }
+            else
+            {
+                hsv.value = hsv.value + (hsv.value* ((double)layer->contrast / 100.0));
+            }
+
+            if (hsv.value < 0.0) hsv.value = 0.0;
+            if (hsv.value > 1.0) hsv.value = 1.0;
+            unsigned char alpha = color.Alpha();
+            color = hsv;
+            color.alpha = alpha;
+        } else if (b != 100) {
+            //just brightness
+            float ba = b;
+            ba /= 100.0f;
+            float f = color.red * ba;
+            color.red = std::min((int)f, 255);
+            f = color.green * ba;
+            color.green = std::min((int)f, 255);
+            f = color.blue * ba;
+            color.blue = std::min((int)f, 255);
+        }
     }
-    if (layers[layer]->effectMixThreshold < 0) {
-        layers[layer]->effectMixThreshold = 0;
+}
+
+// Mixes count layer colours (fg) onto the output so far (bg) ... all of which already have a lower layer in them
+void PixelBufferClass::MixRun(LayerInfo* layer, xlColor* fg, xlColor* bg, const int* x, const int* y, size_t count, float threshold)
+{
+    static const int n = 0;  //increase to change the curve of the crossfade
+
+    if (!layer->buffer.allowAlpha && layer->fadeFactor != 1.0) {
+        //need to fade the first here as we're not mixing anything
+        for (size_t i = 0; i < count; i++)
+        {
+            HSVValue hsv0 = fg[i].asHSV();
+            hsv0.value *= layer->fadeFactor;
+            fg[i] = hsv0;
+        }
     }
 
-    switch (layers[layer]->mixType)
+    switch (layer->mixType)
     {
     case Mix_Normal:
-        fg.alpha = fg.alpha * layers[layer]->fadeFactor * (1.0 - layers[layer]->effectMixThreshold);
-        bg.AlphaBlendForgroundOnto(fg);
+        for (size_t i = 0; i < count; i++)
+        {
+            fg[i].alpha = fg[i].alpha * layer->fadeFactor * (1.0 - threshold);
+            bg[i].AlphaBlendForgroundOnto(fg[i]);
+        }
         break;
     case Mix_Effect1:
     case Mix_Effect2:
     {
         double emt, emtNot;
-        if (!layers[layer]->effectMixVaries) {
-            emt = layers[layer]->effectMixThreshold;
+        if (!layer->effectMixVaries) {
+            emt = threshold;
             if ((emt > 0.000001) && (emt < 0.99999)) {
-                emtNot = 1-layers[layer]->effectMixThreshold;
+                emtNot = 1 - threshold;
                 //make cross-fade linear
                 emt = cos((M_PI/4)*(pow(2*emt-1,2*n+1)+1));
                 emtNot = cos((M_PI/4)*(pow(2*emtNot-1,2*n+1)+1));
             } else {
-                emtNot = layers[layer]->effectMixThreshold;
-                emt = 1 - layers[layer]->effectMixThreshold;
+                emtNot = threshold;
+                emt = 1 - threshold;
             }
         } else {
-            emt = layers[layer]->effectMixThreshold;
-            emtNot = 1-layers[layer]->effectMixThreshold;
+            emt = threshold;
+            emtNot = 1 - threshold;
         }
 
-        if (layers[layer]->mixType == Mix_Effect2) {
-            fg.Set(fg.Red()*(emtNot),fg.Green()*(emtNot), fg.Blue()*(emtNot));
-            bg.Set(bg.Red()*(emt),bg.Green()*(emt), bg.Blue()*(emt));
-        } else {
-            fg.Set(fg.Red()*(emt),fg.Green()*(emt), fg.Blue()*(emt));
-            bg.Set(bg.Red()*(emtNot),bg.Green()*(emtNot), bg.Blue()*(emtNot));
+        double fgFactor = layer->mixType == Mix_Effect2 ? emtNot : emt;
+        double bgFactor = layer->mixType == Mix_Effect2 ? emt : emtNot;
+        for (size_t i = 0; i < count; i++)
+        {
+            fg[i].Set(fg[i].Red()*(fgFactor), fg[i].Green()*(fgFactor), fg[i].Blue()*(fgFactor));
+            bg[i].Set(bg[i].Red()*(bgFactor), bg[i].Green()*(bgFactor), bg[i].Blue()*(bgFactor));
+            bg[i].Set(fg[i].Red()+bg[i].Red(), fg[i].Green()+bg[i].Green(), fg[i].Blue()+bg[i].Blue());
         }
-        bg.Set(fg.Red()+bg.Red(), fg.Green()+bg.Green(), fg.Blue()+bg.Blue());
         break;
     }
     case Mix_Mask1:
-    {
         // first masks second
-        HSVValue hsv0 = fg.asHSV();
-        if (hsv0.value > layers[layer]->effectMixThreshold) {
-            bg.Set(0, 0, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (ColorValue(fg[i]) > threshold) {
+                bg[i].Set(0, 0, 0);
+            }
         }
         break;
-    }
     case Mix_Mask2:
-    {
         // second masks first
-        HSVValue hsv1 = bg.asHSV();
-        if (hsv1.value <= layers[layer]->effectMixThreshold) {
-            bg = fg;
-        } else {
-            bg.Set(0, 0, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (ColorValue(bg[i]) <= threshold) {
+                bg[i] = fg[i];
+            } else {
+                bg[i].Set(0, 0, 0);
+            }
         }
         break;
-    }
     case Mix_Unmask1:
-    {
         // first unmasks second
-        HSVValue hsv0 = fg.asHSV();
-        HSVValue hsv1 = bg.asHSV();
-        if (hsv0.value > layers[layer]->effectMixThreshold) {
-            // if effect 1 is non black
-            hsv1.value = hsv0.value;
-            bg = hsv1;
-        } else {
-            bg.Set(0, 0, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            HSVValue hsv0 = fg[i].asHSV();
+            if (hsv0.value > threshold) {
+                // if effect 1 is non black
+                HSVValue hsv1 = bg[i].asHSV();
+                hsv1.value = hsv0.value;
+                bg[i] = hsv1;
+            } else {
+                bg[i].Set(0, 0, 0);
+            }
         }
         break;
-    }
     case Mix_Unmask2:
-    {
         // second unmasks first
-        HSVValue hsv0 = fg.asHSV();
-        HSVValue hsv1 = bg.asHSV();
-        if (hsv1.value > layers[layer]->effectMixThreshold) {
-            // if effect 2 is non black
-            hsv0.value = hsv1.value;
-            bg = hsv0;
-        } else {
-            bg.Set(0, 0, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            HSVValue hsv1 = bg[i].asHSV();
+            if (hsv1.value > threshold) {
+                // if effect 2 is non black
+                HSVValue hsv0 = fg[i].asHSV();
+                hsv0.value = hsv1.value;
+                bg[i] = hsv0;
+            } else {
+                bg[i].Set(0, 0, 0);
+            }
         }
         break;
-    }
     case Mix_Shadow_1on2:
-    {
         // Effect 1 shadows onto effect 2
-        HSVValue hsv0 = fg.asHSV();
-        HSVValue hsv1 = bg.asHSV();
-        //   if (hsv0.value > effectMixThreshold[layer]) {
-        // if effect 1 is non black
-        //  to shadow we will shift the hue on the primary layer using the hue and brightness from the
-        //  other layer
-        if(hsv0.value>0.0) hsv1.hue = hsv1.hue + (hsv0.value*(hsv1.hue-hsv0.hue))/5.0;
-        // hsv1.value = hsv0.value;
-        //hsv1.saturation = hsv0.saturation;
-        bg = hsv1;
-        //   }
+        for (size_t i = 0; i < count; i++)
+        {
+            HSVValue hsv0 = fg[i].asHSV();
+            HSVValue hsv1 = bg[i].asHSV();
+            //  to shadow we will shift the hue on the primary layer using the hue and brightness from the
+            //  other layer
+            if(hsv0.value>0.0) hsv1.hue = hsv1.hue + (hsv0.value*(hsv1.hue-hsv0.hue))/5.0;
+            bg[i] = hsv1;
+        }
         break;
-    }
     case Mix_Shadow_2on1:
-    {
         // Effect 2 shadows onto effect 1
-        HSVValue hsv0 = fg.asHSV();
-        HSVValue hsv1 = bg.asHSV();
-        // if effect 1 is non black
-        if(hsv1.value>0.0) {
-            hsv0.hue = hsv0.hue + (hsv1.value*(hsv0.hue-hsv1.hue))/2.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            HSVValue hsv0 = fg[i].asHSV();
+            HSVValue hsv1 = bg[i].asHSV();
+            // if effect 1 is non black
+            if(hsv1.value>0.0) {
+                hsv0.hue = hsv0.hue + (hsv1.value*(hsv0.hue-hsv1.hue))/2.0;
+            }
+            bg[i] = hsv0;
         }
-        bg = hsv0;
         break;
-    }
     case Mix_Layered:
-    {
-        HSVValue hsv1 = bg.asHSV();
-        if (hsv1.value <= layers[layer]->effectMixThreshold) {
-            bg = fg;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (ColorValue(bg[i]) <= threshold) {
+                bg[i] = fg[i];
+            }
         }
         break;
-    }
     case Mix_Average:
         // only average when both colors are non-black
-        if (bg == xlBLACK) {
-            bg = fg;
-        } else if (fg != xlBLACK) {
-            bg.Set( (fg.Red()+bg.Red())/2, (fg.Green()+bg.Green())/2, (fg.Blue()+bg.Blue())/2 );
+        for (size_t i = 0; i < count; i++)
+        {
+            if (bg[i] == xlBLACK) {
+                bg[i] = fg[i];
+            } else if (fg[i] != xlBLACK) {
+                bg[i].Set((fg[i].Red()+bg[i].Red())/2, (fg[i].Green()+bg[i].Green())/2, (fg[i].Blue()+bg[i].Blue())/2);
+            }
         }
         break;
     case Mix_BottomTop:
-        bg = y < layers[layer]->BufferHt/2 ? fg : bg;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (y[i] < layer->BufferHt/2) bg[i] = fg[i];
+        }
         break;
     case Mix_LeftRight:
-        bg = x < layers[layer]->BufferWi/2 ? fg : bg;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (x[i] < layer->BufferWi/2) bg[i] = fg[i];
+        }
         break;
     case Mix_1_reveals_2:
-    {
-        HSVValue hsv0 = fg.asHSV();
-        bg = hsv0.value > layers[layer]->effectMixThreshold ? fg : bg; // if effect 1 is non black
+        for (size_t i = 0; i < count; i++)
+        {
+            if (ColorValue(fg[i]) > threshold) bg[i] = fg[i]; // if effect 1 is non black
+        }
         break;
-    }
     case Mix_2_reveals_1:
-    {
-        HSVValue hsv1 = bg.asHSV();
-        bg = hsv1.value > layers[layer]->effectMixThreshold ? bg : fg; // if effect 2 is non black
-        break;
-    }
-    case Mix_Additive:
+        for (size_t i = 0; i < count; i++)
         {
-            int r = fg.red + bg.red;
-            int g = fg.green + bg.green;
-            int b = fg.blue + bg.blue;
-            if (r > 255) r = 255;
-            if (g > 255) g = 255;
-            if (b > 255) b = 255;
-            bg.Set(r, g, b);
+            if (ColorValue(bg[i]) <= threshold) bg[i] = fg[i]; // if effect 2 is non black
         }
         break;
+    case Mix_Additive:
+        MixAdditive(fg, bg, count);
+        break;
     case Mix_Subtractive:
-        {
-            int r = bg.red - fg.red;
-            int g = bg.green - fg.green;
-            int b = bg.blue - fg.blue;
-            if (r < 0) r = 0;
-            if (g < 0) g = 0;
-            if (b < 0) b = 0;
-            bg.Set(r, g, b);
-        }
+        MixSubtractive(fg, bg, count);
         break;
-
     case Mix_Min:
-        {
-            int r = std::min(fg.red, bg.red);
-            int g = std::min(fg.green, bg.green);
-            int b = std::min(fg.blue, bg.blue);
-            bg.Set(r, g, b);
-        }
+        MixMin(fg, bg, count);
         break;
     case Mix_Max:
-        {
-            int r = std::max(fg.red, bg.red);
-            int g = std::max(fg.green, bg.green);
-            int b = std::max(fg.blue, bg.blue);
-            bg.Set(r, g, b);
-        }
+        MixMax(fg, bg, count);
         break;
     }
-    if (layers[layer]->effectMixVaries)
+}
+
+// Mixes the layer colours into the output. Samples this is the first layer for are faded or blended onto black,
+// the rest are mixed in runs.
+void PixelBufferClass::MixLayerColors(LayerInfo* layer, size_t count, std::vector<xlColor>& out)
+{
+    float threshold = layer->effectMixThreshold;
+    if (layer->effectMixVaries) {
+        //vary mix threshold gradually during effect interval -DJ
+        threshold = layer->buffer.GetEffectTimeIntervalPosition();
+    }
+    if (threshold < 0) {
+        threshold = 0;
+    }
+
+    size_t s = 0;
+    while (s < count)
     {
-        layers[layer]->effectMixThreshold = svthresh; //put it back afterwards in case next row didn't change it
+        if (_gather.index[s] == GATHER_SKIP)
+        {
+            s++;
+        }
+        else if (!_mixStarted[s])
+        {
+            xlColor& color = _layerColors[s];
+            if (layer->fadeFactor != 1.0) {
+                //need to fade the first here as we're not mixing anything
+                HSVValue hsv = color.asHSV();
+                hsv.value *= layer->fadeFactor;
+                if (color.alpha != 255) {
+                    hsv.value *= color.alpha;
+                    hsv.value /= 255.0f;
+                }
+                out[s] = hsv;
+            } else {
+                out[s].AlphaBlendForgroundOnto(color);
+            }
+            _mixStarted[s] = 1;
+            s++;
+        }
+        else
+        {
+            size_t end = s + 1;
+            while (end < count && _gather.index[end] != GATHER_SKIP && _mixStarted[end])
+            {
+                end++;
+            }
+            MixRun(layer, &_layerColors[s], &out[s], &_gather.x[s], &_gather.y[s], end - s, threshold);
+            s = end;
+        }
     }
 }
 
-void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod)
+// Mixes all the valid layers, top layer first. nodeMap is null when mixing nodes, otherwise the canvas
+// pixel to node map for a width wide canvas.
+void PixelBufferClass::MixLayers(const std::vector<bool>& validLayers, size_t count, int width, const std::vector<int>* nodeMap, std::vector<xlColor>& out)
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    unsigned short &sparkle = layers[0]->buffer.Nodes[node]->sparkle;
-    int cnt = 0;
-    c = xlBLACK;
-    xlColor color;
+    out.assign(count, xlBLACK);
+    _mixStarted.assign(count, 0);
+    _layerColors.resize(count);
 
     for (int layer = numLayers - 1; layer >= 0; layer--)
     {
@@ -548,418 +881,60 @@ void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<boo
         {
             auto thelayer = layers[layer];
 
-            // TEMPORARY - THIS SHOULD BE REMOVED BUT I WANT TO SEE WHAT IS CAUSING SOME RANDOM CRASHES - KW - 2017.7
-            if (thelayer == nullptr)
+            if (nodeMap == nullptr)
             {
-                logger_base.crit("PixelBufferClass::GetMixedColor thelayer is nullptr ... this is going to crash.");
-            }
-
-            if (node >= thelayer->buffer.Nodes.size())
-            {
-                //logger_base.crit("PixelBufferClass::GetMixedColor thelayer->buffer.Nodes does not contain node %d as it is only %d in size ... this was going to crash.", node, thelayer->buffer.Nodes.size());
+                GatherNodes(thelayer, count);
             }
             else
             {
-                int effStartPer, effEndPer;
-                thelayer->buffer.GetEffectPeriods(effStartPer, effEndPer);
-                float offset = ((float)(EffectPeriod - effStartPer)) / ((float)(effEndPer - effStartPer));
-                offset = std::min(offset, 1.0f);
-
-                auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
-                int x = coord.bufX;
-                int y = coord.bufY;
-
-                if (thelayer->isMasked(x, y)
-                    || x < 0
-                    || y < 0
-                    || x >= thelayer->BufferWi
-                    || y >= thelayer->BufferHt
-                    ) {
-                    color.Set(0, 0, 0, 0);
-                } else {
-                    thelayer->buffer.GetPixel(x, y, color);
-                }
-
-                float ha;
-                if (thelayer->HueAdjustValueCurve.IsActive())
-                {
-                    ha = thelayer->HueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    ha = (float)thelayer->hueadjust / 100.0;
-                }
-                float sa;
-                if (thelayer->SaturationAdjustValueCurve.IsActive())
-                {
-                    sa = thelayer->SaturationAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    sa = (float)thelayer->saturationadjust / 100.0;
-                }
-                
-                float va;
-                if (thelayer->ValueAdjustValueCurve.IsActive())
-                {
-                    va = thelayer->ValueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    va = (float)thelayer->valueadjust / 100.0;
-                }
-                
-                // adjust for HSV adjustments
-                if (ha != 0 || sa != 0 || va != 0) {
-                    HSVValue hsv = color.asHSV();
-
-                    if (ha != 0)
-                    {
-                        hsv.hue += ha;
-                        if (hsv.hue < 0)
-                        {
-                            hsv.hue += 1.0;
-                        }
-                        else if (hsv.hue > 1)
-                        {
-                            hsv.hue -= 1.0;
-                        }
-                    }
-
-                    if (sa != 0)
-                    {
-                        hsv.saturation += sa;
-                        if (hsv.saturation < 0)
-                        {
-                            hsv.saturation = 0.0;
-                        }
-                        else if (hsv.saturation > 1)
-                        {
-                            hsv.saturation = 1.0;
-                        }
-                    }
-
-                    if (va != 0)
-                    {
-                        hsv.value += va;
-                        if (hsv.value < 0)
-                        {
-                            hsv.value = 0.0;
-                        }
-                        else if (hsv.value > 1)
-                        {
-                            hsv.value = 1.0;
-                        }
-                    }
-
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                }
-
-                // add sparkles
-                if (color != xlBLACK &&
-                    (thelayer->music_sparkle_count ||
-                        thelayer->sparkle_count > 0 ||
-                        thelayer->SparklesValueCurve.IsActive())
-                    )
-                {
-                    int sc = thelayer->sparkle_count;
-                    if (thelayer->SparklesValueCurve.IsActive())
-                    {
-                        sc = (int)thelayer->SparklesValueCurve.GetOutputValueAt(offset);
-                    }
-
-                    if (thelayer->music_sparkle_count &&
-                        thelayer->buffer.GetMedia() != nullptr)
-                    {
-                        float f = 0.0;
-                        std::list<float>* pf = thelayer->buffer.GetMedia()->GetFrameData(thelayer->buffer.curPeriod, FRAMEDATA_HIGH, "");
-                        if (pf != nullptr)
-                        {
-                            f = *pf->begin();
-                        }
-                        sc = (int)((float)sc * f);
-                    }
-                    switch (sparkle % (208 - sc))
-                    {
-                    case 1:
-                    case 7:
-                        // too dim
-                        //color.Set("#444444");
-                        break;
-                    case 2:
-                    case 6:
-                        color.Set(0x88, 0x88, 0x88);
-                        break;
-                    case 3:
-                    case 5:
-                        color.Set(0xbb, 0xbb, 0xbb);
-                        break;
-                    case 4:
-                        color.Set(255, 255, 255);
-                        break;
-                    default:
-                        break;
-                    }
-                    sparkle++;
-                }
-                int b;
-                if (thelayer->BrightnessValueCurve.IsActive())
-                {
-                    b = (int)thelayer->BrightnessValueCurve.GetOutputValueAt(offset);
-                }
-                else
-                {
-                    b = thelayer->brightness;
-                }
-                if (thelayer->contrast != 0) {
-                    //contrast is not 0, can handle brightness change at same time
-                    HSVValue hsv = color.asHSV();
-                    hsv.value = hsv.value * ((double)b / 100.0);
-
-                    // Apply Contrast
-                    if (hsv.value < 0.5)
-                    {
-                        // reduce brightness when below 0.5 in the V value or increase if > 0.5
-                        hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
-                    else
-                    {
-                        hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
-
-                    if (hsv.value < 0.0) hsv.value = 0.0;
-                    if (hsv.value > 1.0) hsv.value = 1.0;
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                } else if (b != 100) {
-                    //just brightness
-                    float ba = b;
-                    ba /= 100.0f;
-                    float f = color.red * ba;
-                    color.red = std::min((int)f, 255);
-                    f = color.green * ba;
-                    color.green = std::min((int)f, 255);
-                    f = color.blue * ba;
-                    color.blue = std::min((int)f, 255);
-                }
-
-                if (cnt > 0) {
-                    mixColors(x, y, color, c, layer);
-                } else if (thelayer->fadeFactor != 1.0) {
-                    //need to fade the first here as we're not mixing anything
-                    HSVValue hsv = color.asHSV();
-                    hsv.value *= thelayer->fadeFactor;
-                    if (color.alpha != 255) {
-                        hsv.value *= color.alpha;
-                        hsv.value /= 255.0f;
-                    }
-                    c = hsv;
-                } else {
-                    c.AlphaBlendForgroundOnto(color);
-                }
-
-                cnt++;
+                GatherCanvas(thelayer, count, width, *nodeMap);
             }
+            GetLayerColors(thelayer, count, nodeMap == nullptr);
+            MixLayerColors(thelayer, count, out);
         }
     }
 }
 
-void PixelBufferClass::GetMixedColor(int x, int y, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod)
+void PixelBufferClass::CalcCanvasOutput(RenderBuffer& rb, const std::vector<bool>& validLayers)
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    // If this coordinate maps to a node use the node function as nodes have some special stuff going on ... like sparkles
-    int i = 0;
-    for (auto it = layers[0]->buffer.Nodes.begin(); it != layers[0]->buffer.Nodes.end(); ++it)
-    {
-        if ((*it)->Coords[0].bufX == x && (*it)->Coords[0].bufY == y)
+    int width = rb.BufferWi;
+    int height = rb.BufferHt;
+    size_t count = (size_t)width * height;
+    if (count == 0 || rb.pixels.size() < count) return;
+
+    // pixels that are nodes take the node colour so they get the sparkles ... the first node at a pixel wins
+    _canvasNodeMap.assign(count, -1);
+    const NodeTable &nodes = layers[0]->buffer.nodeTable;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int x = nodes.bufX[i];
+        int y = nodes.bufY[i];
+        if (x >= 0 && x < width && y >= 0 && y < height && _canvasNodeMap[y * width + x] == -1)
         {
-            GetMixedColor(i, c, validLayers, EffectPeriod);
-            return;
+            _canvasNodeMap[y * width + x] = i;
         }
-        i++;
     }
 
-    int cnt = 0;
-    c = xlBLACK;
-    xlColor color;
+    MixLayers(validLayers, count, width, &_canvasNodeMap, _canvasColors);
 
-    for (int layer = numLayers - 1; layer >= 0; layer--)
+    for (size_t s = 0; s < count; s++)
     {
-        if (validLayers[layer])
+        int node = _canvasNodeMap[s];
+        if (node < 0)
         {
-            auto thelayer = layers[layer];
-
-            // TEMPORARY - THIS SHOULD BE REMOVED BUT I WANT TO SEE WHAT IS CAUSING SOME RANDOM CRASHES - KW - 2017.7
-            if (thelayer == nullptr)
-            {
-                logger_base.crit("PixelBufferClass::GetMixedColor thelayer is nullptr ... this is going to crash.");
-            }
-
-            if (x >= thelayer->BufferWi || y >= thelayer->BufferHt)
-            {
-                // out of bounds
-            }
-            else
-            {
-                int effStartPer, effEndPer;
-                thelayer->buffer.GetEffectPeriods(effStartPer, effEndPer);
-                float offset = ((float)(EffectPeriod - effStartPer)) / ((float)(effEndPer - effStartPer));
-                offset = std::min(offset, 1.0f);
-
-                if (thelayer->isMasked(x, y)
-                    || x < 0
-                    || y < 0
-                    || x >= thelayer->BufferWi
-                    || y >= thelayer->BufferHt
-                    ) {
-                    color.Set(0, 0, 0, 0);
-                } else {
-                    thelayer->buffer.GetPixel(x, y, color);
-                }
-                
-                float ha;
-                if (thelayer->HueAdjustValueCurve.IsActive())
-                {
-                    ha = thelayer->HueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    ha = (float)thelayer->hueadjust / 100.0;
-                }
-                float sa;
-                if (thelayer->SaturationAdjustValueCurve.IsActive())
-                {
-                    sa = thelayer->SaturationAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    sa = (float)thelayer->saturationadjust / 100.0;
-                }
-                
-                float va;
-                if (thelayer->ValueAdjustValueCurve.IsActive())
-                {
-                    va = thelayer->ValueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
-                }
-                else
-                {
-                    va = (float)thelayer->valueadjust / 100.0;
-                }
-                
-                // adjust for HSV adjustments
-                if (ha != 0 || sa != 0 || va != 0) {
-                    HSVValue hsv = color.asHSV();
-
-                    if (ha != 0)
-                    {
-                        hsv.hue += ha;
-                        if (hsv.hue < 0)
-                        {
-                            hsv.hue += 1.0;
-                        }
-                        else if (hsv.hue > 1)
-                        {
-                            hsv.hue -= 1.0;
-                        }
-                    }
-
-                    if (sa != 0)
-                    {
-                        hsv.saturation += sa;
-                        if (hsv.saturation < 0)
-                        {
-                            hsv.saturation = 0.0;
-                        }
-                        else if (hsv.saturation > 1)
-                        {
-                            hsv.saturation = 1.0;
-                        }
-                    }
-
-                    if (va != 0)
-                    {
-                        hsv.value += va;
-                        if (hsv.value < 0)
-                        {
-                            hsv.value = 0.0;
-                        }
-                        else if (hsv.value > 1)
-                        {
-                            hsv.value = 1.0;
-                        }
-                    }
-
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                }
-
-                int b;
-                if (thelayer->BrightnessValueCurve.IsActive())
-                {
-                    b = (int)thelayer->BrightnessValueCurve.GetOutputValueAt(offset);
-                }
-                else
-                {
-                    b = thelayer->brightness;
-                }
-                if (thelayer->contrast != 0) {
-                    //contrast is not 0, can handle brightness change at same time
-                    HSVValue hsv = color.asHSV();
-                    hsv.value = hsv.value * ((double)b / 100.0);
-
-                    // Apply Contrast
-                    if (hsv.value < 0.5)
-                    {
-                        // reduce brightness when below 0.5 in the V value or increase if > 0.5
-                        hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
-                    else
-                    {
-                        hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
-
-                    if (hsv.value < 0.0) hsv.value = 0.0;
-                    if (hsv.value > 1.0) hsv.value = 1.0;
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                } else if (b != 100) {
-                    //just brightness
-                    float ba = b;
-                    ba /= 100.0f;
-                    float f = color.red * ba;
-                    color.red = std::min((int)f, 255);
-                    f = color.green * ba;
-                    color.green = std::min((int)f, 255);
-                    f = color.blue * ba;
-                    color.blue = std::min((int)f, 255);
-                }
-
-                if (cnt > 0) {
-                    mixColors(x, y, color, c, layer);
-                } else if (thelayer->fadeFactor != 1.0) {
-                    //need to fade the first here as we're not mixing anything
-                    HSVValue hsv = color.asHSV();
-                    hsv.value *= thelayer->fadeFactor;
-                    if (color.alpha != 255) {
-                        hsv.value *= color.alpha;
-                        hsv.value /= 255.0f;
-                    }
-                    c = hsv;
-                } else {
-                    c.AlphaBlendForgroundOnto(color);
-                }
-
-                cnt++;
-            }
+            rb.pixels[s] = _canvasColors[s];
+        }
+        else if (node < (int)_nodeColors.size())
+        {
+            rb.pixels[s] = _nodeColors[node];
+        }
+        else
+        {
+            rb.pixels[s] = xlBLACK;
         }
     }
 }
+#pragma endregion Compositor
 
 //http://blog.ivank.net/fastest-gaussian-blur.html
 static void boxesForGauss(int d, int n, std::vector<float> &boxes)  // standard deviation, number of boxes
@@ -1021,17 +996,24 @@ static void boxesForGauss(int d, int n, std::vector<float> &boxes)  // standard
     }
 }
 
-#define RED(a, b) a[(b)*4]
-#define GREEN(a, b) a[(b)*4 + 1]
-#define BLUE(a, b) a[(b)*4 + 2]
-#define ALPHA(a, b) a[(b)*4 + 3]
-static inline void SET(float *ar, int idx, float r, float g, float b, float a) {
-    idx *= 4;
-    ar[idx++] = r;
-    ar[idx++] = g;
-    ar[idx++] = b;
-    ar[idx] = a;
-}
+// Each pixel is 4 floats (red, green, blue, alpha) so the box passes work a whole pixel at a time.
+// The SSE2 version does exactly the same float operations as the scalar one so the results match.
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+typedef __m128 BlurPixel;
+static inline BlurPixel BlurLoad(const float *a, int idx) { return _mm_loadu_ps(a + idx * 4); }
+static inline void BlurStore(float *a, int idx, BlurPixel p) { _mm_storeu_ps(a + idx * 4, p); }
+static inline BlurPixel BlurAdd(BlurPixel a, BlurPixel b) { return _mm_add_ps(a, b); }
+static inline BlurPixel BlurSub(BlurPixel a, BlurPixel b) { return _mm_sub_ps(a, b); }
+static inline BlurPixel BlurScale(BlurPixel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+struct BlurPixel { float c[4]; };
+static inline BlurPixel BlurLoad(const float *a, int idx) { BlurPixel p; memcpy(p.c, a + idx * 4, sizeof(p.c)); return p; }
+static inline void BlurStore(float *a, int idx, BlurPixel p) { memcpy(a + idx * 4, p.c, sizeof(p.c)); }
+static inline BlurPixel BlurAdd(BlurPixel a, BlurPixel b) { for (int i = 0; i < 4; i++) a.c[i] += b.c[i]; return a; }
+static inline BlurPixel BlurSub(BlurPixel a, BlurPixel b) { for (int i = 0; i < 4; i++) a.c[i] -= b.c[i]; return a; }
+static inline BlurPixel BlurScale(BlurPixel a, float s) { for (int i = 0; i < 4; i++) a.c[i] *= s; return a; }
+#endif
 
 static void boxBlurH_4 (const float  * const scl, float *tcl, int w, int h, float r) {
     float iarr = 1.0f / (r+r+1.0f);
@@ -1043,60 +1025,38 @@ static void boxBlurH_4 (const float  * const scl, float *tcl, int w, int h, floa
         int fvIdx = ti;
         int lvIdx = ti+w-1;
 
-        float valr = (r+1.0) * RED(scl,fvIdx);
-        float valg = (r+1.0) * GREEN(scl,fvIdx);
-        float valb = (r+1.0) * BLUE(scl,fvIdx);
-        float vala = (r+1.0) * ALPHA(scl,fvIdx);
-
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
+        BlurPixel fv = BlurLoad(scl, fvIdx);
+        BlurPixel lv = BlurLoad(scl, lvIdx);
+        BlurPixel val = BlurScale(fv, r+1.0f);
 
         for (int j=0; j<r; j++) {
             int idx = j < w ? ti+j : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
+            val = BlurAdd(val, BlurLoad(scl, idx));
         }
         for (int j=0  ; j<=r ; j++) {
             int idx = ri <= maxri ? ri++ : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
+            val = BlurAdd(val, BlurSub(BlurLoad(scl, idx), fv));
 
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
                 ti++;
             }
         }
         for (int j=r+1; j<w-r; j++) {
             int c = ri <= maxri ? ri++ : lvIdx;
             int c2 = li <= maxri ? li++ : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
+            val = BlurAdd(val, BlurSub(BlurLoad(scl, c), BlurLoad(scl, c2)));
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
                 ti++;
             }
         }
 
         for (int j=w-r; j<w  ; j++) {
             int c2 = li <= maxri ? li++: lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
+            val = BlurAdd(val, BlurSub(lv, BlurLoad(scl, c2)));
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
                 ti++;
             }
         }
@@ -1115,35 +1075,19 @@ static void boxBlurT_4 (const float * const scl, float *tcl, int w, int h, float
         int fvIdx = ti;
         int lvIdx = ti+w*(h-1);
 
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
-
-        float valr = (r+1)*fvRed;
-        float valg = (r+1)*fvGreen;
-        float valb = (r+1)*fvBlue;
-        float vala = (r+1)*fvAlpha;
+        BlurPixel fv = BlurLoad(scl, fvIdx);
+        BlurPixel lv = BlurLoad(scl, lvIdx);
+        BlurPixel val = BlurScale(fv, r+1);
 
         for(int j=0; j<r; j++) {
             int idx = j < w ? ti+j*w : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
+            val = BlurAdd(val, BlurLoad(scl, idx));
         }
         for(int j=0  ; j<=r ; j++) {
             int idx = ri <= maxri ? ri : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
+            val = BlurAdd(val, BlurSub(BlurLoad(scl, idx), fv));
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
             }
             ri+=w;
             ti+=w;
@@ -1151,23 +1095,17 @@ static void boxBlurT_4 (const float * const scl, float *tcl, int w, int h, float
         for(int j=r+1; j<h-r; j++) {
             int c = ri <= maxri ? ri : lvIdx;
             int c2 = li <= maxri ? li : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
+            val = BlurAdd(val, BlurSub(BlurLoad(scl, c), BlurLoad(scl, c2)));
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
             }
             li+=w; ri+=w; ti+=w;
         }
         for(int j=h-r; j<h  ; j++) {
             int c2 = li <= maxri ? li : lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
+            val = BlurAdd(val, BlurSub(lv, BlurLoad(scl, c2)));
             if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+                BlurStore(tcl, ti, BlurScale(val, iarr));
             }
             li += w;
             ti += w;
@@ -1213,8 +1151,10 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
         return;
     } else if (b > 2 && layer->BufferWi > 6 && layer->BufferHt > 6) {
         int pixCount = layer->buffer.pixels.size();
-        float * input = new float[pixCount * 4];
-        float * tmp = new float[pixCount * 4];
+        layer->blurInput.resize(pixCount * 4);
+        layer->blurOutput.resize(pixCount * 4);
+        float * input = &layer->blurInput[0];
+        float * tmp = &layer->blurOutput[0];
         for (int x = 0; x < pixCount; x++) {
             const xlColor &c = layer->buffer.pixels[x];
             input[x * 4] = c.red;
@@ -1230,8 +1170,6 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
                                         roundInt(tmp[x*4 + 2]),
                                         roundInt(tmp[x*4 + 3]));
         }
-        delete [] input;
-        delete [] tmp;
     } else {
         int d;
         int u;
@@ -1245,35 +1183,98 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
             d = (b - 1) / 2;
             u = (b - 1) / 2;
         }
-        RenderBuffer orig(layer->buffer);
-        for (int x = 0; x < layer->BufferWi; x++)
+
+        // Average over the box x-d..x+u, y-d..y+u clipped to the buffer. This is done as a running sum
+        // along each row followed by a running sum down each column of those so the cost does not
+        // depend on the box size.
+        int w = layer->BufferWi;
+        int h = layer->BufferHt;
+        xlColor* pixels = &layer->buffer.pixels[0];
+        layer->blurSums.resize(w * h * 4);
+        int* rows = &layer->blurSums[0];
+
+        for (int y = 0; y < h; y++)
         {
-            for (int y = 0; y < layer->BufferHt; y++)
+            const xlColor* row = pixels + y * w;
+            int* sums = rows + y * w * 4;
+            int r = 0;
+            int g = 0;
+            int b2 = 0;
+            int a = 0;
+            for (int i = 0; i < std::min(u, w - 1) + 1; i++)
             {
-                int r = 0;
-                int g = 0;
-                int b2 = 0;
-                int a = 0;
-                int sm = 0;
-                for (int i = x - d; i <= x + u; i++)
+                r += row[i].red;
+                g += row[i].green;
+                b2 += row[i].blue;
+                a += row[i].alpha;
+            }
+            for (int x = 0; x < w; x++)
+            {
+                sums[x * 4] = r;
+                sums[x * 4 + 1] = g;
+                sums[x * 4 + 2] = b2;
+                sums[x * 4 + 3] = a;
+
+                // slide the box one pixel to the right
+                int out = x - d;
+                if (out >= 0)
                 {
-                    if (i >= 0 && i < layer->BufferWi)
-                    {
-                        for (int j = y - d; j <= y + u; j++)
-                        {
-                            if (j >=0 && j < layer->BufferHt)
-                            {
-                                const xlColor &c = orig.GetPixel(i, j);
-                                r += c.red;
-                                g += c.green;
-                                b2 += c.blue;
-                                a += c.alpha;
-                                ++sm;
-                            }
-                        }
-                    }
+                    r -= row[out].red;
+                    g -= row[out].green;
+                    b2 -= row[out].blue;
+                    a -= row[out].alpha;
+                }
+                int in = x + u + 1;
+                if (in < w)
+                {
+                    r += row[in].red;
+                    g += row[in].green;
+                    b2 += row[in].blue;
+                    a += row[in].alpha;
+                }
+            }
+        }
+
+        for (int x = 0; x < w; x++)
+        {
+            const int* col = rows + x * 4;
+            int cols = std::min(x + u, w - 1) - std::max(x - d, 0) + 1;
+            int r = 0;
+            int g = 0;
+            int b2 = 0;
+            int a = 0;
+            for (int j = 0; j < std::min(u, h - 1) + 1; j++)
+            {
+                const int* c = col + j * w * 4;
+                r += c[0];
+                g += c[1];
+                b2 += c[2];
+                a += c[3];
+            }
+            for (int y = 0; y < h; y++)
+            {
+                int sm = cols * (std::min(y + u, h - 1) - std::max(y - d, 0) + 1);
+                pixels[y * w + x].Set(r / sm, g / sm, b2 / sm, a / sm);
+
+                // slide the box one pixel up
+                int out = y - d;
+                if (out >= 0)
+                {
+                    const int* c = col + out * w * 4;
+                    r -= c[0];
+                    g -= c[1];
+                    b2 -= c[2];
+                    a -= c[3];
+                }
+                int in = y + u + 1;
+                if (in < h)
+                {
+                    const int* c = col + in * w * 4;
+                    r += c[0];
+                    g += c[1];
+                    b2 += c[2];
+                    a += c[3];
                 }
-                layer->buffer.SetPixel(x, y, xlColor(r/sm, g/sm, b2/sm, a/sm));
             }
         }
     }
@@ -1358,6 +1359,7 @@ void ComputeValueCurve(const std::string& valueCurve, ValueCurve& theValueCurve,
 
     theValueCurve.SetDivisor(divisor);
     theValueCurve.Deserialise(valueCurve);
+    theValueCurve.Bake();
 }
 
 // Works out the maximum buffer size reached based on a subbuffer - this may be larger than the model size but never less than the model size
@@ -1385,6 +1387,7 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
             v[0].Replace("yyz", "Max");
             ValueCurve vc(v[0].ToStdString());
             vc.SetLimits(-100, 200);
+            vc.Bake();
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float val = vc.GetOutputValueAt((float)i / VCITERATIONS);
@@ -1399,6 +1402,7 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
             v[2].Replace("yyz", "Max");
             ValueCurve vc(v[2].ToStdString());
             vc.SetLimits(-100, 200);
+            vc.Bake();
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float val = vc.GetOutputValueAt((float)i / VCITERATIONS);
@@ -1415,6 +1419,7 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
             v[1].Replace("yyz", "Max");
             ValueCurve vc(v[1].ToStdString());
             vc.SetLimits(-100, 200);
+            vc.Bake();
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float val = vc.GetOutputValueAt((float)i / VCITERATIONS);
@@ -1429,6 +1434,7 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
             v[3].Replace("yyz", "Max");
             ValueCurve vc(v[3].ToStdString());
             vc.SetLimits(-100, 200);
+            vc.Bake();
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float val = vc.GetOutputValueAt((float)i / VCITERATIONS);
@@ -1654,6 +1660,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
         }
         
         ComputeSubBuffer(subBuffer, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt, 0);
+        inf->buffer.UpdateNodeTable();
 
         // save away the full model buffer size ... some effects need to know this
         ComputeMaxBuffer(subBuffer, inf->BufferHt, inf->BufferWi, inf->ModelBufferHt, inf->ModelBufferWi);
@@ -1704,6 +1711,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
                 int bw, bh;
                 (*it)->Nodes.clear();
                 gp->Models()[cnt]->InitRenderBufferNodes(ntype, transform, (*it)->Nodes, bw, bh);
+                (*it)->UpdateNodeTable();
                 if (bw == 0) bw = 1; // zero sized buffers are a problem
                 if (bh == 0) bh = 1;
                 (*it)->InitBuffer(bh, bw, bh, bw, transform);
@@ -1737,11 +1745,13 @@ void PixelBufferClass::MergeBuffersForLayer(int layer) {
         //get all the data
         xlColor color;
         int nc = 0;
+        const NodeTable &layerNodes = layers[layer]->buffer.nodeTable;
         for (auto it = layers[layer]->modelBuffers.begin(); it != layers[layer]->modelBuffers.end(); ++it) {
-            for (auto node = (*it)->Nodes.begin(); node != (*it)->Nodes.end(); ++node, nc++) {
-                (*it)->GetPixel((*node)->Coords[0].bufX, (*node)->Coords[0].bufY, color);
-                for (auto coord = layers[layer]->buffer.Nodes[nc]->Coords.begin(); coord != layers[layer]->buffer.Nodes[nc]->Coords.end(); coord++) {
-                    layers[layer]->buffer.SetPixel(coord->bufX, coord->bufY, color);
+            const NodeTable &modelNodes = (*it)->nodeTable;
+            for (size_t node = 0; node < modelNodes.size(); ++node, nc++) {
+                (*it)->GetPixel(modelNodes.bufX[node], modelNodes.bufY[node], color);
+                for (unsigned int c = layerNodes.coordStart[nc]; c < layerNodes.coordStart[nc + 1]; c++) {
+                    layers[layer]->buffer.SetPixel(layerNodes.coordX[c], layerNodes.coordY[c], color);
                 }
             }
         }
@@ -1785,9 +1795,11 @@ void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &
 
     if (layers[0] != nullptr) // I dont like this ... it should never be null
     {
-        for (auto &n : layers[0]->buffer.Nodes) {
-            size_t start = n->ActChan;
+        const NodeTable &table = layers[0]->buffer.nodeTable;
+        for (size_t i = 0; i < table.size(); i++) {
+            size_t start = table.actChan[i];
             if (IsInRange(restrictRange, start)) {
+                auto &n = layers[0]->buffer.Nodes[i];
                 if (n->model != nullptr) // nor this
                 {
                     DimmingCurve *curve = n->model->modelDimmingCurve;
@@ -1808,8 +1820,10 @@ void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &
 void PixelBufferClass::SetColors(int layer, const unsigned char *fdata)
 {
     xlColor color;
-    for (auto &n : layers[layer]->buffer.Nodes) {
-        size_t start = n->ActChan;
+    const NodeTable &table = layers[layer]->buffer.nodeTable;
+    for (size_t i = 0; i < table.size(); i++) {
+        auto &n = layers[layer]->buffer.Nodes[i];
+        size_t start = table.actChan[i];
         
         n->SetFromChannels(&fdata[start]);
         n->GetColor(color);
@@ -1818,9 +1832,9 @@ void PixelBufferClass::SetColors(int layer, const unsigned char *fdata)
         if (curve != nullptr) {
             curve->reverse(color);
         }
-        for (auto &a : n->Coords) {
-            layers[layer]->buffer.SetPixel(a.bufX,
-                                           a.bufY,
+        for (unsigned int c = table.coordStart[i]; c < table.coordStart[i + 1]; c++) {
+            layers[layer]->buffer.SetPixel(table.coordX[c],
+                                           table.coordY[c],
                                            color);
 
         }
@@ -2058,6 +2072,7 @@ void PixelBufferClass::PrepareVariableSubBuffer(int EffectPeriod, int layer)
     layers[layer]->buffer.Nodes.clear();
     model->InitRenderBufferNodes(type, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
     ComputeSubBuffer(subBuffer, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt, offset);
+    layers[layer]->buffer.UpdateNodeTable();
     layers[layer]->buffer.BufferWi = layers[layer]->BufferWi;
     layers[layer]->buffer.BufferHt = layers[layer]->BufferHt;
     
@@ -2067,7 +2082,6 @@ void PixelBufferClass::PrepareVariableSubBuffer(int EffectPeriod, int layer)
 
 void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & validLayers)
 {
-    xlColor color;
     int curStep;
 
     // blur all the layers if necessary ... before the merge?
@@ -2087,6 +2101,9 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
             Blur(layers[layer], offset);
         }
         RotoZoom(layers[layer], offset);
+
+        // these dont change across the frame so work them out once rather than for every node
+        layers[layer]->calculateFrameAdjustments(offset);
     }
 
     for(int ii=0; ii < numLayers; ii++)
@@ -2139,23 +2156,19 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
 
     // layer calculation and map to output
     size_t NodeCount = layers[0]->buffer.Nodes.size();
+    MixLayers(validLayers, NodeCount, 0, nullptr, _nodeColors);
+    const NodeTable &table = layers[0]->buffer.nodeTable;
     for(size_t i = 0; i < NodeCount; i++)
     {
-        if (!layers[0]->buffer.Nodes[i]->IsVisible())
+        if (!table.IsVisible(i))
         {
             // unmapped pixel - set to black
             layers[0]->buffer.Nodes[i]->SetColor(xlBLACK);
         }
         else
         {
-            // get blend of two effects
-            GetMixedColor(i,
-                          color,
-                          validLayers, EffectPeriod);
-
-
             // set color for physical output
-            layers[0]->buffer.Nodes[i]->SetColor(color);
+            layers[0]->buffer.Nodes[i]->SetColor(_nodeColors[i]);
         }
     }
 }
@@ -2652,6 +2665,63 @@ void PixelBufferClass::LayerInfo::createSlideBarsMask(bool out) {
     }
 }
 
+void PixelBufferClass::LayerInfo::calculateFrameAdjustments(float offset)
+{
+    if (HueAdjustValueCurve.IsActive())
+    {
+        frameHueAdjust = HueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
+    }
+    else
+    {
+        frameHueAdjust = (float)hueadjust / 100.0;
+    }
+
+    if (SaturationAdjustValueCurve.IsActive())
+    {
+        frameSaturationAdjust = SaturationAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
+    }
+    else
+    {
+        frameSaturationAdjust = (float)saturationadjust / 100.0;
+    }
+
+    if (ValueAdjustValueCurve.IsActive())
+    {
+        frameValueAdjust = ValueAdjustValueCurve.GetOutputValueAt(offset) / 100.0;
+    }
+    else
+    {
+        frameValueAdjust = (float)valueadjust / 100.0;
+    }
+
+    if (BrightnessValueCurve.IsActive())
+    {
+        frameBrightness = (int)BrightnessValueCurve.GetOutputValueAt(offset);
+    }
+    else
+    {
+        frameBrightness = brightness;
+    }
+
+    frameSparkles = music_sparkle_count || sparkle_count > 0 || SparklesValueCurve.IsActive();
+    frameSparkleCount = sparkle_count;
+    if (SparklesValueCurve.IsActive())
+    {
+        frameSparkleCount = (int)SparklesValueCurve.GetOutputValueAt(offset);
+    }
+
+    if (music_sparkle_count && buffer.GetMedia() != nullptr)
+    {
+        float f = 0.0;
+        AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+        if (pf.IsValid())
+        {
+            f = pf[0];
+        }
+        frameSparkleCount = (int)((float)frameSparkleCount * f);
+    }
+}
+
 void PixelBufferClass::LayerInfo::calculateMask(bool isFirstFrame) {
     bool hasMask = false;
     if (inMaskFactor < 1.0) {
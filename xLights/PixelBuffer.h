@@ -102,6 +102,11 @@ private:
             fadeInSteps = fadeOutSteps = 0;
             inTransitionAdjust = outTransitionAdjust = 0;
             inTransitionReverse = outTransitionReverse = false;
+
+            frameHueAdjust = frameSaturationAdjust = frameValueAdjust = 0.0f;
+            frameBrightness = 100;
+            frameSparkles = false;
+            frameSparkleCount = 0;
         }
         RenderBuffer buffer;
         std::string bufferType;
@@ -145,6 +150,10 @@ private:
         int sparkle_count;
         bool music_sparkle_count;
 		int blur;
+        // scratch space for Blur so it does not allocate every frame
+        std::vector<float> blurInput;
+        std::vector<float> blurOutput;
+        std::vector<int> blurSums;
         int rotation;
         int xrotation;
         int yrotation;
@@ -182,6 +191,15 @@ private:
         bool usingModelBuffers;
         std::vector<std::unique_ptr<RenderBuffer>> modelBuffers;
 
+        // value curves evaluated for the current frame by CalcOutput
+        float frameHueAdjust;
+        float frameSaturationAdjust;
+        float frameValueAdjust;
+        int frameBrightness;
+        bool frameSparkles;
+        int frameSparkleCount;
+        void calculateFrameAdjustments(float offset);
+
         std::vector<uint8_t> mask;
         void calculateMask(bool isFirstFrame);
         void calculateMask(const std::string &type, bool mode, bool isFirstFrame);
@@ -207,15 +225,33 @@ private:
 
     int CurrentLayer;
 
+    // where each output pixel comes from in the layer being mixed, rebuilt for each layer each frame
+    class LayerGather {
+    public:
+        std::vector<int> index; // index into the layer pixels or one of the GATHER_ values
+        std::vector<int> x;
+        std::vector<int> y;
+    };
+    LayerGather _gather;
+    std::vector<xlColor> _layerColors;
+    std::vector<uint8_t> _mixStarted;
+    std::vector<xlColor> _nodeColors;
+    std::vector<xlColor> _canvasColors;
+    std::vector<int> _canvasNodeMap;
+
+    void GatherNodes(LayerInfo* layer, size_t count);
+    void GatherCanvas(LayerInfo* layer, size_t count, int width, const std::vector<int>& nodeMap);
+    void GetLayerColors(LayerInfo* layer, size_t count, bool sparkles);
     //both fg and bg may be modified, bg will contain the new, mixed color to be the bg for the next mix
-    void mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer);
+    void MixRun(LayerInfo* layer, xlColor* fg, xlColor* bg, const int* x, const int* y, size_t count, float threshold);
+    void MixLayerColors(LayerInfo* layer, size_t count, std::vector<xlColor>& out);
+    void MixLayers(const std::vector<bool>& validLayers, size_t count, int width, const std::vector<int>* nodeMap, std::vector<xlColor>& out);
     void reset(int layers, int timing);
 	void Blur(LayerInfo* layer, float offset);
     void RotoZoom(LayerInfo* layer, float offset);
     void RotateX(LayerInfo* layer, float offset);
     void RotateY(LayerInfo* layer, float offset);
     void RotateZAndZoom(LayerInfo* layer, float offset);
-    void GetMixedColor(int node, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod);
 
     std::string modelName;
     std::string lastBufferType;
@@ -225,7 +261,6 @@ private:
     SingleLineModel *ssModel;
     xLightsFrame *frame;
 public:
-    void GetMixedColor(int x, int y, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod);
     void GetNodeChannelValues(size_t nodenum, unsigned char *buf);
     void SetNodeChannelValues(size_t nodenum, const unsigned char *buf);
     xlColor GetNodeColor(size_t nodenum) const;
@@ -267,6 +302,8 @@ public:
     void SetTimes(int layer, int startTime, int endTime);
 
     void CalcOutput(int EffectPeriod, const std::vector<bool> &validLayers);
+    // mixes the valid layers into every pixel of rb, CalcOutput must have been called for the frame first
+    void CalcCanvasOutput(RenderBuffer& rb, const std::vector<bool> &validLayers);
     void SetColors(int layer, const unsigned char *fdata);    
     void GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange);
 };
@@ -11,8 +11,12 @@
 #include "xLightsXmlFile.h"
 #include "RenderCommandEvent.h"
 #include <map>
+#include <list>
+#include <algorithm>
 #include <memory>
 #include "effects/RenderableEffect.h"
+#include "effects/ImageCache.h"
+#include "effects/VideoFrameCache.h"
 #include "RenderProgressDialog.h"
 #include "SeqExportDialog.h"
 #include "RenderUtils.h"
@@ -47,6 +51,8 @@ public:
         currentEffectIdxs.resize(l);
         settingsMaps.resize(l);
         effectStates.resize(l);
+        cacheItems.resize(l);
+        cacheHits.resize(l);
         validLayers.resize(l + 1); //extra one for the blending layer
     }
 
@@ -58,6 +64,8 @@ public:
     std::vector<int> currentEffectIdxs;
     std::vector<SettingsMap> settingsMaps;
     std::vector<bool> effectStates;
+    std::vector<std::shared_ptr<RenderCacheItem>> cacheItems;
+    std::vector<bool> cacheHits;
     std::vector<bool> validLayers;
 };
 
@@ -110,14 +118,6 @@ public:
         nextSignal.notify_all();
     }
 
-    int waitForFrame(int frame) {
-        std::unique_lock<std::mutex> lock(nextLock);
-        while (frame > previousFrameDone) {
-            nextSignal.wait_for(lock, std::chrono::milliseconds(10));
-        }
-        return previousFrameDone;
-    }
-
     bool checkIfDone(int frame, int timeout = 5) {
         std::unique_lock<std::mutex> lock(nextLock);
         return previousFrameDone >= frame;
@@ -214,10 +214,11 @@ public:
 
 class RenderJob: public Job, public NextRenderer {
 public:
-    RenderJob(ModelElement *row, SequenceData &data, xLightsFrame *xframe, bool zeroBased = false)
-        : Job(), NextRenderer(), rowToRender(row), seqData(&data), xLights(xframe),
+    RenderJob(ModelElement *row, SequenceData &data, xLightsFrame *xframe, JobPool *pool, bool zeroBased = false)
+        : Job(), NextRenderer(), rowToRender(row), seqData(&data), xLights(xframe), jobPool(pool),
             gauge(nullptr), currentFrame(0), renderLog(log4cpp::Category::getInstance(std::string("log_render"))),
-            supportsModelBlending(false), abort(false), statusMap(nullptr)
+            supportsModelBlending(false), abort(false), statusMap(nullptr),
+            renderState(RENDER_STATE_NEW), parkedForFrame(-1), nextFrame(0), maxFrameBeforeCheck(-1), origChangeCount(0), parkChangeCount(0), calcOutputUS(0), calcOutputFrames(0)
     {
         name = "";
         if (row != nullptr) {
@@ -236,7 +237,8 @@ public:
                             static const std::string CHOICE_BufferStyle("B_CHOICE_BufferStyle");
                             static const std::string DEFAULT("Default");
                             static const std::string PER_MODEL("Per Model");
-                            const std::string &bt = layer->GetEffect(e)->GetSettings().Get(CHOICE_BufferStyle, DEFAULT);
+                            const Effect *effect = layer->GetEffect(e);
+                            const std::string &bt = effect->GetSettings().Get(CHOICE_BufferStyle, DEFAULT);
                             if (bt.compare(0, 9, PER_MODEL) == 0) {
                                 perModelEffects = true;
                             }
@@ -501,6 +503,10 @@ public:
         wxStopWatch sw;
         bool effectsToUpdate = false;
         int numLayers = el->GetEffectLayerCount();
+        if (numLayers > info.numLayers) {
+            // layers were added while we were parked, they will be picked up by the next render
+            numLayers = info.numLayers;
+        }
 
         for (int layer = 0; layer < info.validLayers.size(); ++layer) {
             info.validLayers[layer] = false;
@@ -515,6 +521,8 @@ public:
                 SetInializingStatus(frame, layer, strand);
                 initialize(layer, frame, ef, info.settingsMaps[layer], buffer);
                 info.effectStates[layer] = true;
+                info.cacheItems[layer] = getCacheItem(layer, frame, ef, info.settingsMaps[layer], buffer, strand);
+                info.cacheHits[layer] = info.cacheItems[layer] != nullptr && info.cacheItems[layer]->IsComplete();
             }
 
             if (buffer->IsVariableSubBuffer(layer))
@@ -564,19 +572,24 @@ public:
                 buffer->CalcOutput(frame, vl);
 
                 // Now copy the result into the current layer
-                for (int y = 0; y < rb.BufferHt; y++)
-                {
-                    for (int x = 0; x < rb.BufferWi; x++)
-                    {
-                        xlColor c = xlBLACK;
-                        buffer->GetMixedColor(x, y, c, vl, frame);
-                        rb.SetPixel(x, y, c);
-                    }
-                }
+                buffer->CalcCanvasOutput(rb, vl);
             }
 
-            info.validLayers[layer] = xLights->RenderEffectFromMap(ef, layer, frame, info.settingsMaps[layer], *buffer, b, true, &renderEvent);
-            info.effectStates[layer] = b;
+            // Effects carry state from frame to frame so a cached effect is only used if every frame
+            // is there, otherwise it is rendered from the start and the missing frames are added.
+            RenderCacheItem *cacheItem = info.cacheItems[layer].get();
+            RenderBuffer &layerBuffer = buffer->BufferForLayer(layer, -1);
+            bool valid = false;
+            if (cacheItem != nullptr && info.cacheHits[layer] && xLights->GetRenderCache()->GetFrame(cacheItem, frame, layerBuffer.pixels, valid)) {
+                buffer->SetLayer(layer, frame, false);
+                info.validLayers[layer] = valid;
+            } else {
+                info.validLayers[layer] = xLights->RenderEffectFromMap(ef, layer, frame, info.settingsMaps[layer], *buffer, b, true, &renderEvent);
+                info.effectStates[layer] = b;
+                if (cacheItem != nullptr) {
+                    xLights->GetRenderCache()->AddFrame(cacheItem, frame, layerBuffer.pixels, info.validLayers[layer]);
+                }
+            }
             effectsToUpdate |= info.validLayers[layer];
         }
 
@@ -586,8 +599,18 @@ public:
                 buffer->SetColors(numLayers, &((*seqData)[frame][0]));
                 info.validLayers[numLayers] = true;
             }
-            buffer->CalcOutput(frame, info.validLayers);
-            buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+            // only time the output calculation when the render log will show it, this can only be set at start time
+            static bool timeCalcOutput = renderLog.isPriorityEnabled(log4cpp::Priority::DEBUG);
+            if (timeCalcOutput) {
+                wxStopWatch calcsw;
+                buffer->CalcOutput(frame, info.validLayers);
+                buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                calcOutputUS += calcsw.TimeInMicro().ToLong();
+                calcOutputFrames++;
+            } else {
+                buffer->CalcOutput(frame, info.validLayers);
+                buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+            }
         }
 
         if (sw.Time() > 500)
@@ -599,169 +622,223 @@ public:
         return effectsToUpdate;
     }
 
+    // Process is called once per time slice.  When the next frame depends on a model that
+    // has not rendered it yet the job parks itself and returns the worker thread to the pool.
+    // It is queued again by setPreviousFrameDone once the frame becomes available.
     virtual void Process() override {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-        SetGenericStatus("Initializing rendering thread for %s", 0);
-        int maxFrameBeforeCheck = -1;
-        int origChangeCount;
-        int ss, es;
+        if (renderState == RENDER_STATE_NEW) {
+            SetGenericStatus("Initializing rendering thread for %s", 0);
+            if (!ClaimRow()) {
+                // another job is rendering this row, it will hand the row to us when it is done
+                return;
+            }
+        }
 
-        rowToRender->IncWaitCount();
         std::unique_lock<std::recursive_mutex> lock(rowToRender->GetRenderLock());
-        rowToRender->DecWaitCount();
-        SetGenericStatus("Got lock on rendering thread for %s", 0);
-
-        rowToRender->GetAndResetDirtyRange(origChangeCount, ss, es);
-        if (ss != -1) {
-            //expand to cover the whole dirty range
-            ss = ss / seqData->FrameTime();
-            if (ss < 0) {
-                ss = 0;
-            }
-            es = es / seqData->FrameTime();
-            if (es > seqData->NumFrames()) {
-                es = seqData->NumFrames();
+        if (renderState == RENDER_STATE_OWNS_ROW) {
+            SetGenericStatus("Got lock on rendering thread for %s", 0);
+            int ss, es;
+            rowToRender->GetAndResetDirtyRange(origChangeCount, ss, es);
+            if (ss != -1) {
+                //expand to cover the whole dirty range
+                ss = ss / seqData->FrameTime();
+                if (ss < 0) {
+                    ss = 0;
+                }
+                es = es / seqData->FrameTime();
+                if (es > seqData->NumFrames()) {
+                    es = seqData->NumFrames();
+                }
+                if (ss < startFrame) {
+                    startFrame = ss;
+                }
+                if (es > endFrame) {
+                    endFrame = es;
+                }
             }
-            if (ss < startFrame) {
-                startFrame = ss;
+            if (startFrame < 0) startFrame = 0;
+            if (endFrame > seqData->NumFrames()) endFrame = seqData->NumFrames() - 1;
+
+            mainModelInfo.resize(numLayers);
+            nextFrame = startFrame;
+            renderState = RENDER_STATE_FRAMES;
+
+            try {
+                //for (int layer = 0; layer < numLayers; ++layer) {
+                for (int layer = numLayers - 1; layer >= 0; --layer) {
+                    wxString msg = wxString::Format("Finding starting effect for %s, layer %d and startFrame %d", name, layer, startFrame) + PrintStatusMap();
+                    SetStatus(msg);
+                    mainModelInfo.currentEffects[layer] = findEffectForFrame(layer, startFrame, mainModelInfo.currentEffectIdxs[layer]);
+                    msg = wxString::Format("Initializing starting effect for %s, layer %d and startFrame %d", name, layer, startFrame) + PrintStatusMap();
+                    SetStatus(msg);
+                    initialize(layer, startFrame, mainModelInfo.currentEffects[layer], mainModelInfo.settingsMaps[layer], mainBuffer);
+                    mainModelInfo.effectStates[layer] = true;
+                    mainModelInfo.cacheItems[layer] = getCacheItem(layer, startFrame, mainModelInfo.currentEffects[layer], mainModelInfo.settingsMaps[layer], mainBuffer, -1);
+                    mainModelInfo.cacheHits[layer] = mainModelInfo.cacheItems[layer] != nullptr && mainModelInfo.cacheItems[layer]->IsComplete();
+                }
+            } catch ( std::exception &ex) {
+                printf("Caught an exception %s", ex.what());
+                renderLog.error("Caught an exception on rendering thread: " + std::string(ex.what()));
+                logger_base.error("Caught an exception on rendering thread: %s", ex.what());
+                renderState = RENDER_STATE_FINISHING;
+            } catch ( ... ) {
+                printf("Caught an unknown exception");
+                renderLog.error("Caught an unknown exception on rendering thread.");
+                logger_base.error("Caught an unknown exception on rendering thread.");
+                renderState = RENDER_STATE_FINISHING;
             }
-            if (es > endFrame) {
-                endFrame = es;
+        } else if (renderState == RENDER_STATE_FRAMES) {
+            if (parkTimer.Time() > 500) {
+                renderLog.info("Model %s rendering frame %d waited %dms waiting for other models to finish.", (const char *)name.c_str(), nextFrame, parkTimer.Time());
             }
+            CheckRowAfterPark(nextFrame);
         }
-        if (startFrame < 0) startFrame = 0;
-        if (endFrame > seqData->NumFrames()) endFrame = seqData->NumFrames() - 1;
-
-        EffectLayerInfo mainModelInfo(numLayers);
-        std::map<SNPair, Effect*> nodeEffects;
-        std::map<SNPair, SettingsMap> nodeSettingsMaps;
-        std::map<SNPair, bool> nodeEffectStates;
-        std::map<SNPair, int> nodeEffectIdxs;
-
-        try {
-            //for (int layer = 0; layer < numLayers; ++layer) {
-            for (int layer = numLayers - 1; layer >= 0; --layer) {
-                wxString msg = wxString::Format("Finding starting effect for %s, layer %d and startFrame %d", name, layer, startFrame) + PrintStatusMap();
-                SetStatus(msg);
-                mainModelInfo.currentEffects[layer] = findEffectForFrame(layer, startFrame, mainModelInfo.currentEffectIdxs[layer]);
-                msg = wxString::Format("Initializing starting effect for %s, layer %d and startFrame %d", name, layer, startFrame) + PrintStatusMap();
-                SetStatus(msg);
-                initialize(layer, startFrame, mainModelInfo.currentEffects[layer], mainModelInfo.settingsMaps[layer], mainBuffer);
-                mainModelInfo.effectStates[layer] = true;
-            }
 
-            for (int frame = startFrame; frame <= endFrame; ++frame) {
-                currentFrame = frame;
-                SetGenericStatus("%s: Starting frame %d " + PrintStatusMap(), frame, true);
+        if (renderState == RENDER_STATE_FRAMES) {
+            try {
+                for (; nextFrame <= endFrame; ++nextFrame) {
+                    int frame = nextFrame;
+                    currentFrame = frame;
+                    SetGenericStatus("%s: Starting frame %d " + PrintStatusMap(), frame, true);
 
-                if (abort) {
-                    break;
-                }
-
-                if (!HasNext() &&
-                        (origChangeCount != rowToRender->getChangeCount()
-                         || rowToRender->GetWaitCount())) {
-                    //we're bailing out but make sure this range is reconsidered
-                    rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
-                    break;
-                }
-                //make sure we can do this frame
-                if (frame >= maxFrameBeforeCheck) {
-                    wxStopWatch sw;
-                    maxFrameBeforeCheck = waitForFrame(frame);
+                    if (abort) {
+                        break;
+                    }
 
-                    if (sw.Time() > 500)
-                    {
-                        renderLog.info("Model %s rendering frame %d waited %dms waiting for other models to finish.", (const char *)(mainModelInfo.element != nullptr) ? mainModelInfo.element->GetName().c_str() : "", frame, sw.Time());
+                    if (!HasNext() &&
+                            (origChangeCount != rowToRender->getChangeCount()
+                             || rowToRender->GetWaitCount() > 1)) {
+                        //we're bailing out but make sure this range is reconsidered
+                        rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
+                        break;
                     }
-                }
-                bool cleared = ProcessFrame(frame, rowToRender, mainModelInfo, mainBuffer, -1, supportsModelBlending);
-                if (!subModelInfos.empty()) {
-                    for (auto a = subModelInfos.begin(); a != subModelInfos.end(); ++a) {
-                        EffectLayerInfo *info = *a;
-                        cleared |= ProcessFrame(frame, info->element, *info, info->buffer.get(), info->strand, supportsModelBlending ? true : cleared);
+                    //make sure we can do this frame
+                    if (frame >= maxFrameBeforeCheck) {
+                        if (!checkIfDone(frame)) {
+                            parkChangeCount = rowToRender->getChangeCount();
+                            lock.unlock();
+                            if (Park(frame)) {
+                                // we may be running on another thread already, don't touch anything
+                                return;
+                            }
+                            lock.lock();
+                            CheckRowAfterPark(frame);
+                        }
+                        maxFrameBeforeCheck = GetPreviousFrameDone();
                     }
-                }
-                if (!nodeBuffers.empty()) {
-                    for (std::map<SNPair, PixelBufferClassPtr>::iterator it = nodeBuffers.begin(); it != nodeBuffers.end(); ++it) {
-                        SNPair node = it->first;
-                        PixelBufferClass *buffer = it->second.get();
-
-                        if (buffer == nullptr)
-                        {
-                            logger_base.crit("RenderJob::Process PixelBufferPointer is null ... this is going to crash.");
+                    bool cleared = ProcessFrame(frame, rowToRender, mainModelInfo, mainBuffer, -1, supportsModelBlending);
+                    if (!subModelInfos.empty()) {
+                        for (auto a = subModelInfos.begin(); a != subModelInfos.end(); ++a) {
+                            EffectLayerInfo *info = *a;
+                            cleared |= ProcessFrame(frame, info->element, *info, info->buffer.get(), info->strand, supportsModelBlending ? true : cleared);
                         }
+                    }
+                    if (!nodeBuffers.empty()) {
+                        for (std::map<SNPair, PixelBufferClassPtr>::iterator it = nodeBuffers.begin(); it != nodeBuffers.end(); ++it) {
+                            SNPair node = it->first;
+                            PixelBufferClass *buffer = it->second.get();
 
-                        int strand = node.strand;
-                        int inode = node.node;
-                        StrandElement *slayer = rowToRender->GetStrand(strand);
-                        if (slayer == nullptr) {
-                            //deleted strand
-                            continue;
-                        }
-                        EffectLayer *nlayer = slayer->GetNodeLayer(inode, false);
-                        if (nlayer == nullptr) {
-                            //deleted node
-                            continue;
-                        }
+                            if (buffer == nullptr)
+                            {
+                                logger_base.crit("RenderJob::Process PixelBufferPointer is null ... this is going to crash.");
+                            }
 
-                        Effect *el = findEffectForFrame(nlayer, frame, nodeEffectIdxs[node]);
-                        if (el != nodeEffects[node] || frame == startFrame) {
-                            nodeEffects[node] = el;
-                            SetInializingStatus(frame, -1, strand, inode);
-                            initialize(0, frame, el, nodeSettingsMaps[node], buffer);
-                            nodeEffectStates[node] = true;
-                        }
-                        bool persist=buffer->IsPersistent(0);
-                        if (!persist || nodeEffects[node] == nullptr || nodeEffects[node]->GetEffectIndex() == -1) {
-                            buffer->Clear(0);
-                        }
+                            int strand = node.strand;
+                            int inode = node.node;
+                            StrandElement *slayer = rowToRender->GetStrand(strand);
+                            if (slayer == nullptr) {
+                                //deleted strand
+                                continue;
+                            }
+                            EffectLayer *nlayer = slayer->GetNodeLayer(inode, false);
+                            if (nlayer == nullptr) {
+                                //deleted node
+                                continue;
+                            }
+
+                            Effect *el = findEffectForFrame(nlayer, frame, nodeEffectIdxs[node]);
+                            if (el != nodeEffects[node] || frame == startFrame) {
+                                nodeEffects[node] = el;
+                                SetInializingStatus(frame, -1, strand, inode);
+                                initialize(0, frame, el, nodeSettingsMaps[node], buffer);
+                                nodeEffectStates[node] = true;
+                            }
+                            bool persist=buffer->IsPersistent(0);
+                            if (!persist || nodeEffects[node] == nullptr || nodeEffects[node]->GetEffectIndex() == -1) {
+                                buffer->Clear(0);
+                            }
 
-                        SetRenderingStatus(frame, &nodeSettingsMaps[node], -1, strand, inode, cleared);
-                        if (xLights->RenderEffectFromMap(el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent)) {
-                            SetCalOutputStatus(frame, strand, inode);
-                            //copy to output
-                            std::vector<bool> valid(2, true);
-                            buffer->SetColors(1, &((*seqData)[frame][0]));
-                            buffer->CalcOutput(frame, valid);
-                            buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                            SetRenderingStatus(frame, &nodeSettingsMaps[node], -1, strand, inode, cleared);
+                            if (xLights->RenderEffectFromMap(el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent)) {
+                                SetCalOutputStatus(frame, strand, inode);
+                                //copy to output
+                                std::vector<bool> valid(2, true);
+                                buffer->SetColors(1, &((*seqData)[frame][0]));
+                                buffer->CalcOutput(frame, valid);
+                                buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                            }
                         }
                     }
+                    //mainBuffer->ApplyDimmingCurves(&((*seqData)[frame][0]));
+                    if (HasNext()) {
+                        SetGenericStatus("%s: Notifying next renderer of frame %d done", frame);
+                        FrameDone(frame);
+                    }
                 }
-                //mainBuffer->ApplyDimmingCurves(&((*seqData)[frame][0]));
-                if (HasNext()) {
-                    SetGenericStatus("%s: Notifying next renderer of frame %d done", frame);
-                    FrameDone(frame);
-                }
+            } catch ( std::exception &ex) {
+                printf("Caught an exception %s", ex.what());
+                renderLog.error("Caught an exception on rendering thread: " + std::string(ex.what()));
+                logger_base.error("Caught an exception on rendering thread: %s", ex.what());
+            } catch ( ... ) {
+                printf("Caught an unknown exception");
+                renderLog.error("Caught an unknown exception on rendering thread.");
+                logger_base.error("Caught an unknown exception on rendering thread.");
             }
-        } catch ( std::exception &ex) {
-            printf("Caught an exception %s", ex.what());
-			renderLog.error("Caught an exception on rendering thread: " + std::string(ex.what()));
-            logger_base.error("Caught an exception on rendering thread: %s", ex.what());
-		} catch ( ... ) {
-            printf("Caught an unknown exception");
-			renderLog.error("Caught an unknown exception on rendering thread.");
-            logger_base.error("Caught an unknown exception on rendering thread.");
+            renderState = RENDER_STATE_FINISHING;
         }
+
         if (HasNext()) {
             //make sure the previous has told us we're at the end.  If we return before waiting, the previous
             //may try sending the END_OF_RENDER_FRAME to us and we'll have been deleted
             SetGenericStatus("%s: Waiting on previous renderer for final frame", 0);
-            waitForFrame(END_OF_RENDER_FRAME);
+            lock.unlock();
+            if (Park(END_OF_RENDER_FRAME)) {
+                return;
+            }
+            lock.lock();
+        }
+        rowToRender->CleanupAfterRender();
+        lock.unlock();
+        ReleaseRow();
 
+        if (HasNext()) {
             //let the next know we're done
             SetGenericStatus("%s: Notifying next renderer of final frame", 0);
-            FrameDone(END_OF_RENDER_FRAME);
             xLights->CallAfter(&xLightsFrame::SetStatusText, wxString("Done Rendering " + rowToRender->GetModelName()), 0);
+            FrameDone(END_OF_RENDER_FRAME);
         } else {
             xLights->CallAfter(&xLightsFrame::RenderDone);
         }
-        rowToRender->CleanupAfterRender();
-        currentFrame = END_OF_RENDER_FRAME;
+        if (calcOutputFrames > 0) {
+            renderLog.debug("Model %s output calculation averaged %ldus per frame over %d frames.", (const char *)name.c_str(), calcOutputUS / calcOutputFrames, calcOutputFrames);
+        }
+        renderLog.debug("Rendering thread exiting.");
         //printf("Done rendering %lx (next %lx)\n", (unsigned long)this, (unsigned long)next);
-		renderLog.debug("Rendering thread exiting.");
-	}
+        currentFrame = END_OF_RENDER_FRAME;
+    }
+
+    virtual void setPreviousFrameDone(int i) override {
+        std::unique_lock<std::mutex> lock(nextLock);
+        previousFrameDone = i;
+        nextSignal.notify_all();
+        if (parkedForFrame != -1 && previousFrameDone >= parkedForFrame) {
+            parkedForFrame = -1;
+            lock.unlock();
+            jobPool->PushJob(this);
+        }
+    }
 
     void AbortRender() {
         std::unique_lock<std::mutex> lock(nextLock);
@@ -789,6 +866,46 @@ private:
         }
     }
 
+    std::shared_ptr<RenderCacheItem> getCacheItem(int layer, int frame, Effect *el, const SettingsMap &settingsMap, PixelBufferClass *buffer, int strand) {
+        RenderCache *cache = xLights->GetRenderCache();
+        if (!cache->IsEnabled() || el == nullptr || el->GetEffectIndex() == -1) {
+            return nullptr;
+        }
+
+        // canvas layers include the layers below them, persistent layers start from whatever the previous
+        // effect left behind, per model buffers keep their own pixels and variable sub buffers change size
+        // from frame to frame
+        if (buffer->IsCanvasMix(layer) || buffer->IsPersistent(layer) || buffer->IsVariableSubBuffer(layer) || buffer->BufferCountForLayer(layer) != 1) {
+            return nullptr;
+        }
+
+        RenderableEffect *reff = xLights->GetEffectManager().GetEffect(el->GetEffectIndex());
+        if (reff == nullptr || !reff->CanCacheRender(el, settingsMap)) {
+            return nullptr;
+        }
+
+        // the frames the effect is found for by findEffectForFrame
+        int frameTime = seqData->FrameTime();
+        int effStart = (el->GetStartTimeMS() + frameTime - 1) / frameTime;
+        int effEnd = (el->GetEndTimeMS() + frameTime - 1) / frameTime;
+
+        std::string mediaFile;
+        if (xLightsFrame::CurrentSeqXmlFile != nullptr) {
+            mediaFile = xLightsFrame::CurrentSeqXmlFile->GetMediaFile().ToStdString();
+        }
+
+        RenderBuffer &rb = buffer->BufferForLayer(layer, -1);
+        std::string key = RenderCache::GetKey(buffer->GetModel(), rb.nodeTable, strand, layer, el, settingsMap, rb.BufferWi, rb.BufferHt, frameTime, mediaFile);
+        std::shared_ptr<RenderCacheItem> item = cache->GetItem(key, effStart, effEnd - effStart);
+
+        // starting part way through the effect its state is not what it would have been so the frames
+        // we render cannot be added ... only an item that is already complete can be used
+        if (item != nullptr && frame > effStart && !item->IsComplete()) {
+            return nullptr;
+        }
+        return item;
+    }
+
     Effect *findEffectForFrame(EffectLayer* layer, int frame, int &lastIdx) {
         if (layer == nullptr) {
             return nullptr;
@@ -814,8 +931,95 @@ private:
                          SettingsMap& settingsMap) {
         settingsMap.clear();
         effect->CopySettingsMap(settingsMap, true);
+
+        // parse the settings now rather than every frame
+        settingsMap.Compile();
+    }
+
+    // Only one job may render a row at a time.  Jobs for a row that is already being rendered
+    // are queued behind the active one and handed the row when it is released.
+    bool ClaimRow() {
+        std::unique_lock<std::mutex> lock(rowOwnersLock);
+        std::list<RenderJob*> &owners = rowOwners[rowToRender];
+        owners.push_back(this);
+        rowToRender->IncWaitCount();
+        if (owners.front() == this) {
+            renderState = RENDER_STATE_OWNS_ROW;
+            return true;
+        }
+        SetGenericStatus("%s: Waiting for previous render of this model to finish", 0);
+        renderState = RENDER_STATE_WAITING_FOR_ROW;
+        return false;
+    }
+
+    void ReleaseRow() {
+        std::unique_lock<std::mutex> lock(rowOwnersLock);
+        std::list<RenderJob*> &owners = rowOwners[rowToRender];
+        owners.remove(this);
+        rowToRender->DecWaitCount();
+        if (owners.empty()) {
+            rowOwners.erase(rowToRender);
+        } else {
+            RenderJob *next = owners.front();
+            next->renderState = RENDER_STATE_OWNS_ROW;
+            next->jobPool->PushJob(next);
+        }
+    }
+
+    // The row's render lock cannot be held while parked as the job may resume on another worker thread
+    // so the row may have been edited in the meantime. If it was, every layer's effect is looked up and
+    // initialised again so nothing renders from a layer that moved or went away, and the rest of the range
+    // is marked dirty so it is rendered again with the edit.
+    void CheckRowAfterPark(int frame) {
+        int changeCount = rowToRender->getChangeCount();
+        if (changeCount == parkChangeCount) {
+            return;
+        }
+        parkChangeCount = changeCount;
+        renderLog.debug("Model %s was changed while rendering was waiting at frame %d.", (const char *)name.c_str(), frame);
+
+        rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
+        ResetLayerEffects(mainModelInfo);
+        for (auto info : subModelInfos) {
+            ResetLayerEffects(*info);
+        }
+        for (auto &it : nodeEffects) {
+            it.second = nullptr;
+        }
+        for (auto &it : nodeEffectIdxs) {
+            it.second = 0;
+        }
+    }
+
+    void ResetLayerEffects(EffectLayerInfo &info) {
+        for (int layer = 0; layer < info.numLayers; ++layer) {
+            info.currentEffects[layer] = nullptr;
+            info.currentEffectIdxs[layer] = 0;
+            info.cacheItems[layer] = nullptr;
+            info.cacheHits[layer] = false;
+        }
+    }
+
+    // Returns true if the job has been parked waiting on frame and will be
+    // re-queued once the previous renderers have got that far
+    bool Park(int frame) {
+        std::unique_lock<std::mutex> lock(nextLock);
+        if (previousFrameDone >= frame) {
+            return false;
+        }
+        parkTimer.Start();
+        parkedForFrame = frame;
+        return true;
     }
 
+    enum {
+        RENDER_STATE_NEW,
+        RENDER_STATE_WAITING_FOR_ROW,
+        RENDER_STATE_OWNS_ROW,
+        RENDER_STATE_FRAMES,
+        RENDER_STATE_FINISHING
+    };
+
     ModelElement *rowToRender;
     std::string name;
     int startFrame;
@@ -823,6 +1027,7 @@ private:
     PixelBufferClass *mainBuffer;
     int numLayers;
     xLightsFrame *xLights;
+    JobPool *jobPool;
     SequenceData *seqData;
     std::vector<bool> rangeRestriction;
     bool supportsModelBlending;
@@ -846,8 +1051,30 @@ private:
     std::vector<EffectLayerInfo *> subModelInfos;
 
     std::map<SNPair, PixelBufferClassPtr> nodeBuffers;
+
+    //state carried between time slices
+    volatile int renderState;
+    int parkedForFrame;
+    wxStopWatch parkTimer;
+    int nextFrame;
+    int maxFrameBeforeCheck;
+    int origChangeCount;
+    int parkChangeCount;
+    long calcOutputUS; // time spent blending layers into the model output, only measured and logged when the render log is at debug
+    int calcOutputFrames;
+    EffectLayerInfo mainModelInfo;
+    std::map<SNPair, Effect*> nodeEffects;
+    std::map<SNPair, SettingsMap> nodeSettingsMaps;
+    std::map<SNPair, bool> nodeEffectStates;
+    std::map<SNPair, int> nodeEffectIdxs;
+
+    static std::mutex rowOwnersLock;
+    static std::map<ModelElement*, std::list<RenderJob*>> rowOwners;
 };
 
+std::mutex RenderJob::rowOwnersLock;
+std::map<ModelElement*, std::list<RenderJob*>> RenderJob::rowOwners;
+
 
 IMPLEMENT_DYNAMIC_CLASS(RenderCommandEvent, wxCommandEvent)
 IMPLEMENT_DYNAMIC_CLASS(SelectedEffectChangedEvent, wxCommandEvent)
@@ -1057,6 +1284,12 @@ void xLightsFrame::UpdateRenderStatus() {
 
 void xLightsFrame::RenderDone()
 {
+    ImageCache::GetCache().LogStats();
+    VideoFrameCache::GetCache().LogStats();
+
+    // pictures stay cached for the next render, they are bounded by the memory budget and dropped when the sequence closes.
+    // The open video readers hold the video files open so let those go
+    VideoFrameCache::GetCache().Purge();
     mainSequencer->PanelEffectGrid->Refresh();
 }
 
@@ -1133,6 +1366,44 @@ public:
     Model *model;
 };
 
+class RowChannelRange {
+public:
+    RowChannelRange(unsigned int s, unsigned int e, int r) : start(s), end(e), row(r) {}
+
+    bool operator<(const RowChannelRange &r) const {
+        return start < r.start;
+    }
+
+    unsigned int start;
+    unsigned int end;
+    int row;
+};
+
+// Wires up the render dependencies so each row waits on every earlier row that writes to
+// any of the same channels.  The channel ranges of all the rows are swept in start channel
+// order keeping the ranges that are still open keyed by their end channel, so the cost is
+// O(ranges log ranges) plus the number of overlaps rather than one std::set per channel.
+static int AddRenderDependencies(std::vector<RowChannelRange> &ranges, RenderJob **jobs, AggregatorRenderer **aggregators) {
+    int edges = 0;
+    std::sort(ranges.begin(), ranges.end());
+    std::multimap<unsigned int, const RowChannelRange*> open;
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        while (!open.empty() && open.begin()->first < it->start) {
+            open.erase(open.begin());
+        }
+        for (auto o = open.begin(); o != open.end(); ++o) {
+            int first = std::min(o->second->row, it->row);
+            int second = std::max(o->second->row, it->row);
+            if (first != second && jobs[first]->addNext(aggregators[second])) {
+                aggregators[second]->incNumAggregated();
+                ++edges;
+            }
+        }
+        open.insert(std::make_pair(it->end, &(*it)));
+    }
+    return edges;
+}
+
 void xLightsFrame::RenderTree::Clear() {
     for (auto it = data.begin(); it != data.end(); ++it) {
         delete *it;
@@ -1217,7 +1488,11 @@ void xLightsFrame::Render(std::list<Model*> models, std::list<Model *> &restrict
     int numRows = models.size();
     RenderJob **jobs = new RenderJob*[numRows];
     AggregatorRenderer **aggregators = new AggregatorRenderer*[numRows];
-    std::vector<std::set<int>> channelMaps(SeqData.NumChannels());
+    std::vector<RowChannelRange> channelRanges;
+    std::map<Model*, RenderTreeData*> treeData;
+    for (auto it = renderTree.data.begin(); it != renderTree.data.end(); ++it) {
+        treeData[(*it)->model] = *it;
+    }
 
     size_t row = 0;
     for (auto it = models.begin(); it != models.end(); ++it, ++row) {
@@ -1243,7 +1518,7 @@ void xLightsFrame::Render(std::list<Model*> models, std::list<Model *> &restrict
                 bool hasEffects = HasEffects(me);
                 bool isRestricted = std::find(restrictToModels.begin(), restrictToModels.end(), *it) != restrictToModels.end();
                 if (hasEffects || (isRestricted && clear)) {
-                    RenderJob *job = new RenderJob(me, SeqData, this, false);
+                    RenderJob *job = new RenderJob(me, SeqData, this, &jobPool, false);
 
                     if (job == nullptr)
                     {
@@ -1263,22 +1538,17 @@ void xLightsFrame::Render(std::list<Model*> models, std::list<Model *> &restrict
 
                     jobs[row] = job;
                     aggregators[row]->addNext(job);
-                    size_t cn = buffer->GetChanCountPerNode();
-                    for (int node = 0; node < buffer->GetNodeCount(); ++node) {
-                        int start = buffer->NodeStartChannel(node);
-                        for (int c = 0; c < cn; ++c) {
-                            int cnum = start + c;
-                            if (cnum < SeqData.NumChannels()) {
-                                for (auto i = channelMaps[cnum].begin(); i != channelMaps[cnum].end(); ++i) {
-                                    int idx = *i;
-                                    if (idx != row) {
-                                        if (jobs[idx]->addNext(aggregators[row])) {
-                                            aggregators[row]->incNumAggregated();
-                                        }
-                                    }
-                                }
-                                channelMaps[cnum].insert(row);
-                            }
+
+                    auto td = treeData.find(*it);
+                    std::unique_ptr<RenderTreeData> tmpData;
+                    if (td == treeData.end()) {
+                        tmpData.reset(new RenderTreeData(*it));
+                    }
+                    const std::list<NodeRange> &modelRanges = td == treeData.end() ? tmpData->ranges : td->second->ranges;
+                    for (auto r = modelRanges.begin(); r != modelRanges.end(); ++r) {
+                        if (r->start < SeqData.NumChannels()) {
+                            unsigned int end = std::min(r->end, (unsigned int)SeqData.NumChannels() - 1);
+                            channelRanges.push_back(RowChannelRange(r->start, end, row));
                         }
                     }
                 }
@@ -1286,9 +1556,10 @@ void xLightsFrame::Render(std::list<Model*> models, std::list<Model *> &restrict
         }
     }
 
-    logger_render.debug("Aggregators created.");
-
-    channelMaps.clear();
+    wxStopWatch depsw;
+    int edges = AddRenderDependencies(channelRanges, jobs, aggregators);
+    logger_render.debug("Aggregators created. %d dependencies found across %d channel ranges in %ldms.", edges, (int)channelRanges.size(), depsw.Time());
+    channelRanges.clear();
     RenderProgressDialog *renderProgressDialog = nullptr;
     if (progressDialog) {
         renderProgressDialog = new RenderProgressDialog(this);
@@ -1678,7 +1949,7 @@ void xLightsFrame::ExportModel(wxCommandEvent &command) {
 
         NextRenderer wait;
         Element * el = mSequenceElements.GetElement(model);
-        RenderJob *job = new RenderJob(dynamic_cast<ModelElement*>(el), SeqData, this, true);
+        RenderJob *job = new RenderJob(dynamic_cast<ModelElement*>(el), SeqData, this, &jobPool, true);
         SequenceData *data = job->createExportBuffer();
         int cpn = job->getBuffer()->GetChanCountPerNode();
 
@@ -838,9 +838,9 @@ void RenderBuffer::SetPixel(int x, int y, const HSVValue& hsv, bool wrap)
     }
 }
 void RenderBuffer::SetNodePixel(int nodeNum, const xlColor &color) {
-    if (nodeNum < Nodes.size()) {
-        for (auto &a : Nodes[nodeNum]->Coords) {
-            SetPixel(a.bufX, a.bufY, color);
+    if (nodeNum < nodeTable.size()) {
+        for (unsigned int c = nodeTable.coordStart[nodeNum]; c < nodeTable.coordStart[nodeNum + 1]; c++) {
+            SetPixel(nodeTable.coordX[c], nodeTable.coordY[c], color);
         }
     }
 }
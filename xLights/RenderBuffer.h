@@ -493,6 +493,9 @@ public:
 private:
     friend class PixelBufferClass;
     std::vector<NodeBaseClassPtr> Nodes;
+    NodeTable nodeTable;
+    // must be called after anything changes Nodes
+    void UpdateNodeTable() { nodeTable.Build(Nodes); }
     PathDrawingContext *_pathDrawingContext;
     TextDrawingContext *_textDrawingContext;
 };
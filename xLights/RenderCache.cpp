@@ -0,0 +1,412 @@
+#include "RenderCache.h"
+#include "sequencer/Effect.h"
+#include "models/Model.h"
+#include "models/Node.h"
+#include "UtilClasses.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/dir.h>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <log4cpp/Category.hh>
+
+#define RENDERCACHE_MISSING 0
+#define RENDERCACHE_VALID 1
+#define RENDERCACHE_INVALID 2 // the effect rendered nothing for this frame
+
+#define RENDERCACHE_FILE_MAGIC "xLRC"
+#define RENDERCACHE_FILE_VERSION 1
+#define RENDERCACHE_FILE_EXT "xlrc"
+#define RENDERCACHE_DEFAULT_MB 1024
+// saved items not used for this long are deleted, then the oldest until the folder is under the size limit
+#define RENDERCACHE_FILE_MAX_DAYS 30
+#define RENDERCACHE_FOLDER_MAX_MB 4096
+
+#pragma region RenderCacheItem
+RenderCacheItem::RenderCacheItem(const std::string& key, int startFrame, int frames)
+{
+    _key = key;
+    _startFrame = startFrame;
+    _frames.resize(frames);
+    _state.resize(frames, RENDERCACHE_MISSING);
+    _bytes = 0;
+    _framesDone = 0;
+    _cached = true;
+}
+
+bool RenderCacheItem::Load(const std::string& filename)
+{
+    wxFile f;
+    if (!f.Open(filename)) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t keyLen = 0;
+    if (f.Read(magic, sizeof(magic)) != sizeof(magic) || strncmp(magic, RENDERCACHE_FILE_MAGIC, sizeof(magic)) != 0) return false;
+    if (f.Read(&version, sizeof(version)) != sizeof(version) || version != RENDERCACHE_FILE_VERSION) return false;
+    if (f.Read(&keyLen, sizeof(keyLen)) != sizeof(keyLen) || keyLen != _key.size()) return false;
+
+    // the filename is only a hash of the key so check it really is this item
+    std::string key(keyLen, ' ');
+    if (f.Read(&key[0], keyLen) != keyLen || key != _key) return false;
+
+    int32_t startFrame = 0;
+    uint32_t frames = 0;
+    if (f.Read(&startFrame, sizeof(startFrame)) != sizeof(startFrame) || startFrame != _startFrame) return false;
+    if (f.Read(&frames, sizeof(frames)) != sizeof(frames) || frames != _frames.size()) return false;
+
+    for (size_t i = 0; i < _frames.size(); i++)
+    {
+        uint8_t state = 0;
+        uint32_t pixels = 0;
+        if (f.Read(&state, sizeof(state)) != sizeof(state)) return false;
+        if (f.Read(&pixels, sizeof(pixels)) != sizeof(pixels)) return false;
+        _frames[i].resize(pixels);
+        if (pixels > 0 && f.Read(&_frames[i][0], pixels * sizeof(xlColor)) != pixels * sizeof(xlColor)) return false;
+        _state[i] = state;
+        _bytes += pixels * sizeof(xlColor);
+    }
+    _framesDone = _frames.size();
+
+    return true;
+}
+
+bool RenderCacheItem::Save(const std::string& filename) const
+{
+    // write to a temporary file so a partly written item is never loaded
+    std::string tmp = filename + ".tmp";
+    wxFile f;
+    if (!f.Create(tmp, true)) return false;
+
+    uint32_t version = RENDERCACHE_FILE_VERSION;
+    uint32_t keyLen = _key.size();
+    int32_t startFrame = _startFrame;
+    uint32_t frames = _frames.size();
+    bool ok = f.Write(RENDERCACHE_FILE_MAGIC, 4) == 4 &&
+        f.Write(&version, sizeof(version)) == sizeof(version) &&
+        f.Write(&keyLen, sizeof(keyLen)) == sizeof(keyLen) &&
+        f.Write(_key.c_str(), keyLen) == keyLen &&
+        f.Write(&startFrame, sizeof(startFrame)) == sizeof(startFrame) &&
+        f.Write(&frames, sizeof(frames)) == sizeof(frames);
+
+    for (size_t i = 0; ok && i < _frames.size(); i++)
+    {
+        uint8_t state = _state[i];
+        uint32_t pixels = _frames[i].size();
+        ok = f.Write(&state, sizeof(state)) == sizeof(state) &&
+            f.Write(&pixels, sizeof(pixels)) == sizeof(pixels) &&
+            (pixels == 0 || f.Write(&_frames[i][0], pixels * sizeof(xlColor)) == pixels * sizeof(xlColor));
+    }
+    f.Close();
+
+    if (!ok || !wxRenameFile(tmp, filename, true))
+    {
+        wxRemoveFile(tmp);
+        return false;
+    }
+    return true;
+}
+#pragma endregion RenderCacheItem
+
+#pragma region RenderCache
+RenderCache::RenderCache()
+{
+    _bytes = 0;
+    _maxBytes = (size_t)RENDERCACHE_DEFAULT_MB * 1024 * 1024;
+    _enabled = false;
+}
+
+void RenderCache::Enable(bool enabled)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _enabled = enabled;
+    logger_base.debug("Render cache %s.", enabled ? "enabled" : "disabled");
+    if (!enabled)
+    {
+        Purge();
+    }
+}
+
+void RenderCache::SetMaxMemoryMB(int mb)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (mb < 1) mb = 1;
+    _maxBytes = (size_t)mb * 1024 * 1024;
+    Evict(0, nullptr);
+}
+
+void RenderCache::SetFolder(const std::string& folder)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _folder = "";
+    if (folder != "")
+    {
+        if (!wxDirExists(folder) && !wxMkdir(folder))
+        {
+            logger_base.warn("Unable to create render cache folder %s. Render cache will not be saved.", (const char *)folder.c_str());
+            return;
+        }
+        _folder = folder;
+        logger_base.debug("Render cache saved in %s.", (const char *)folder.c_str());
+        PruneFolder();
+    }
+}
+
+class RenderCacheFile
+{
+public:
+    std::string filename;
+    wxDateTime modified;
+    wxULongLong size;
+};
+
+void RenderCache::PruneFolder()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxArrayString files;
+    wxDir::GetAllFiles(_folder, &files, "*." RENDERCACHE_FILE_EXT "*", wxDIR_FILES);
+
+    wxDateTime cutoff = wxDateTime::Now() - wxDateSpan::Days(RENDERCACHE_FILE_MAX_DAYS);
+    std::vector<RenderCacheFile> keep;
+    wxULongLong total = 0;
+    int deleted = 0;
+    for (auto it = files.begin(); it != files.end(); ++it)
+    {
+        wxFileName fn(*it);
+        RenderCacheFile f;
+        f.filename = it->ToStdString();
+        f.modified = fn.GetModificationTime();
+        f.size = fn.GetSize();
+
+        // an old .tmp file is a save that never finished
+        bool stale = !f.modified.IsValid() || f.modified < cutoff;
+        if (fn.GetExt() != RENDERCACHE_FILE_EXT)
+        {
+            stale = stale || f.modified < wxDateTime::Now() - wxTimeSpan::Hour();
+        }
+        if (stale)
+        {
+            if (wxRemoveFile(*it)) deleted++;
+        }
+        else if (fn.GetExt() == RENDERCACHE_FILE_EXT)
+        {
+            keep.push_back(f);
+            total += f.size;
+        }
+    }
+
+    std::sort(keep.begin(), keep.end(), [](const RenderCacheFile& a, const RenderCacheFile& b) { return a.modified < b.modified; });
+    wxULongLong max = (wxULongLong)RENDERCACHE_FOLDER_MAX_MB * 1024 * 1024;
+    for (auto it = keep.begin(); it != keep.end() && total > max; ++it)
+    {
+        if (wxRemoveFile(it->filename)) deleted++;
+        total -= it->size;
+    }
+
+    if (deleted > 0)
+    {
+        logger_base.debug("Render cache deleted %d old files from %s.", deleted, (const char *)_folder.c_str());
+    }
+}
+
+void RenderCache::Purge()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    for (auto it = _items.begin(); it != _items.end(); ++it)
+    {
+        it->second->_cached = false;
+    }
+    _items.clear();
+    _lru.clear();
+    _bytes = 0;
+}
+
+std::string RenderCache::GetFilename(const std::string& key) const
+{
+    if (_folder == "") return "";
+    return wxString::Format("%s%c%016llx.%s", _folder, wxFileName::GetPathSeparator(), (unsigned long long)std::hash<std::string>()(key), RENDERCACHE_FILE_EXT).ToStdString();
+}
+
+// a media file is identified by its name, size and when it was last changed
+static std::string GetFileStamp(const std::string& filename)
+{
+    if (filename == "" || !wxFile::Exists(filename)) return filename;
+
+    wxFileName fn(filename);
+    return wxString::Format("%s@%s:%s", filename, fn.GetModificationTime().FormatISOCombined(), fn.GetSize().ToString()).ToStdString();
+}
+
+// the parts of the model an effect's output depends on ... how it is drawn, its colour and where each node sits in the buffer
+static std::string GetModelStamp(const Model* model, const NodeTable& nodes)
+{
+    size_t hash = nodes.size();
+    std::hash<unsigned int> hasher;
+    auto combine = [&hash, &hasher](unsigned int v) { hash ^= hasher(v) + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        combine(nodes.coordStart[n + 1] - nodes.coordStart[n]);
+    }
+    for (size_t c = 0; c < nodes.coordX.size(); c++)
+    {
+        combine(((unsigned int)nodes.coordX[c] << 16) | nodes.coordY[c]);
+    }
+
+    xlColor mask = model->GetNodeMaskColor(0);
+    return wxString::Format("%s|%s|%02x%02x%02x|%d|%016llx", model->GetDisplayAs(), model->GetStringType(), mask.red, mask.green, mask.blue,
+        (int)nodes.size(), (unsigned long long)hash).ToStdString();
+}
+
+std::string RenderCache::GetKey(const Model* model, const NodeTable& nodes, int strand, int layer, Effect* effect, const SettingsMap& settings, int bufferWi, int bufferHt, int frameTimeMS, const std::string& mediaFile)
+{
+    std::string key = wxString::Format("%s|%d|%d|%s|%d|%d|%d|%dx%d|", model->GetFullName(), strand, layer, effect->GetEffectName(),
+        effect->GetStartTimeMS(), effect->GetEndTimeMS(), frameTimeMS, bufferWi, bufferHt).ToStdString();
+    key += GetModelStamp(model, nodes);
+    key += "|";
+    key += effect->GetSettingsAsString();
+    key += "|";
+    key += effect->GetPaletteAsString();
+    key += "|";
+    key += GetFileStamp(mediaFile);
+
+    for (auto it = settings.begin(); it != settings.end(); ++it)
+    {
+        if (it->first.find("FILEPICKER") != std::string::npos)
+        {
+            key += "|";
+            key += GetFileStamp(it->second);
+        }
+    }
+
+    return key;
+}
+
+void RenderCache::Touch(RenderCacheItem* item)
+{
+    if (_lru.front() != item)
+    {
+        _lru.remove(item);
+        _lru.push_front(item);
+    }
+}
+
+void RenderCache::Remove(RenderCacheItem* item)
+{
+    _lru.remove(item);
+    _bytes -= item->_bytes;
+    item->_cached = false;
+    _items.erase(item->_key);
+}
+
+// drop the least recently used items until there is room for needed more bytes
+void RenderCache::Evict(size_t needed, const RenderCacheItem* keep)
+{
+    while (_bytes + needed > _maxBytes && !_lru.empty())
+    {
+        RenderCacheItem* item = _lru.back();
+        if (item == keep)
+        {
+            if (_lru.size() == 1) break;
+            item = *std::next(_lru.rbegin());
+        }
+        Remove(item);
+    }
+}
+
+std::shared_ptr<RenderCacheItem> RenderCache::GetItem(const std::string& key, int startFrame, int frames)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_enabled || frames <= 0) return nullptr;
+
+    std::unique_lock<std::mutex> lock(_lock);
+
+    auto it = _items.find(key);
+    if (it != _items.end())
+    {
+        Touch(it->second.get());
+        return it->second;
+    }
+
+    std::shared_ptr<RenderCacheItem> item = std::make_shared<RenderCacheItem>(key, startFrame, frames);
+    std::string filename = GetFilename(key);
+    if (filename != "" && wxFile::Exists(filename))
+    {
+        if (!item->Load(filename))
+        {
+            logger_base.warn("Render cache file %s could not be loaded.", (const char *)filename.c_str());
+            item = std::make_shared<RenderCacheItem>(key, startFrame, frames);
+        }
+        else
+        {
+            Evict(item->_bytes, nullptr);
+            _bytes += item->_bytes;
+
+            // pruning deletes the files that have not been used for longest
+            wxFileName(filename).Touch();
+        }
+    }
+
+    _items[key] = item;
+    _lru.push_front(item.get());
+    return item;
+}
+
+bool RenderCache::GetFrame(RenderCacheItem* item, int frame, std::vector<xlColor>& pixels, bool& valid)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    int f = frame - item->_startFrame;
+    if (f < 0 || f >= (int)item->_frames.size() || item->_state[f] == RENDERCACHE_MISSING) return false;
+
+    // the buffer size can change frame to frame with a value curve driven sub buffer
+    if (item->_frames[f].size() != pixels.size()) return false;
+
+    std::copy(item->_frames[f].begin(), item->_frames[f].end(), pixels.begin());
+    valid = item->_state[f] == RENDERCACHE_VALID;
+    return true;
+}
+
+void RenderCache::AddFrame(RenderCacheItem* item, int frame, const std::vector<xlColor>& pixels, bool valid)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::string filename;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        int f = frame - item->_startFrame;
+        // frames are never replaced so a complete item does not change
+        if (!item->_cached || f < 0 || f >= (int)item->_frames.size() || item->_state[f] != RENDERCACHE_MISSING) return;
+
+        size_t bytes = pixels.size() * sizeof(xlColor);
+        Evict(bytes, item);
+        if (_bytes + bytes > _maxBytes)
+        {
+            // this item alone is bigger than the cache
+            Remove(item);
+            return;
+        }
+
+        item->_frames[f] = pixels;
+        item->_state[f] = valid ? RENDERCACHE_VALID : RENDERCACHE_INVALID;
+        item->_framesDone++;
+        item->_bytes += bytes;
+        _bytes += bytes;
+
+        if (!item->IsComplete()) return;
+        filename = GetFilename(item->_key);
+    }
+
+    if (filename != "" && !item->Save(filename))
+    {
+        logger_base.warn("Render cache file %s could not be saved.", (const char *)filename.c_str());
+    }
+}
+
+#pragma endregion RenderCache
@@ -0,0 +1,88 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "Color.h"
+
+class Effect;
+class SettingsMap;
+class Model;
+class NodeTable;
+
+// The rendered layer buffer for every frame of one effect. Frames are stored before any layer
+// blending, blur or roto-zoom so restoring one is the same as having run the effect for that frame.
+class RenderCacheItem
+{
+    friend class RenderCache;
+
+    std::string _key;
+    int _startFrame;
+    std::vector<std::vector<xlColor>> _frames;
+    std::vector<uint8_t> _state; // RENDERCACHE_ values
+    size_t _bytes;
+    size_t _framesDone;
+    bool _cached; // false once evicted from the cache
+
+    bool Load(const std::string& filename);
+    bool Save(const std::string& filename) const;
+
+public:
+    RenderCacheItem(const std::string& key, int startFrame, int frames);
+    virtual ~RenderCacheItem() {}
+
+    const std::string& GetKey() const { return _key; }
+    bool IsComplete() const { return _framesDone == _frames.size(); }
+};
+
+// Content addressed cache of rendered effects.
+//
+// An item's key covers everything the effect's output depends on ... the effect settings and
+// palette, its time range, the buffer size, the model's node layout and any media files it reads ...
+// so an effect that has not changed is found again even if the effects around it have been edited.
+// Items are dropped least recently used first once the memory limit is reached. If a folder is set
+// complete items are also written there so they survive reopening the sequence, old files are
+// pruned when the folder is set.
+class RenderCache
+{
+    std::mutex _lock;
+    std::map<std::string, std::shared_ptr<RenderCacheItem>> _items;
+    std::list<RenderCacheItem*> _lru; // most recently used at the front
+    size_t _bytes;
+    size_t _maxBytes;
+    bool _enabled;
+    std::string _folder;
+
+    void Touch(RenderCacheItem* item);
+    void Evict(size_t needed, const RenderCacheItem* keep);
+    void Remove(RenderCacheItem* item);
+    std::string GetFilename(const std::string& key) const;
+    void PruneFolder();
+
+public:
+    RenderCache();
+    virtual ~RenderCache() {}
+
+    void Enable(bool enabled);
+    bool IsEnabled() const { return _enabled; }
+    void SetMaxMemoryMB(int mb);
+    // folder to persist the cache in, blank to only cache in memory
+    void SetFolder(const std::string& folder);
+    void Purge();
+
+    static std::string GetKey(const Model* model, const NodeTable& nodes, int strand, int layer, Effect* effect, const SettingsMap& settings, int bufferWi, int bufferHt, int frameTimeMS, const std::string& mediaFile);
+
+    // the item for this key, loading it from disk if it is persisted, null if caching is off
+    std::shared_ptr<RenderCacheItem> GetItem(const std::string& key, int startFrame, int frames);
+
+    // copies a cached frame into the pixels, false if the frame is not cached
+    bool GetFrame(RenderCacheItem* item, int frame, std::vector<xlColor>& pixels, bool& valid);
+    void AddFrame(RenderCacheItem* item, int frame, const std::vector<xlColor>& pixels, bool valid);
+};
+
+#endif
@@ -16,6 +16,8 @@
 #include "HousePreviewPanel.h"
 #include "FontManager.h"
 #include "SequenceVideoPanel.h"
+#include "effects/ImageCache.h"
+#include "effects/VideoFrameCache.h"
 
 #include <wx/wfstream.h>
 #include <wx/zipstrm.h>
@@ -585,6 +587,10 @@ bool xLightsFrame::CloseSequence()
 
     mainSequencer->PanelWaveForm->CloseMedia();
     SeqData.init(0,0,50);
+
+    // let go of the decoded pictures and video and the files the video readers hold open
+    ImageCache::GetCache().Purge();
+    VideoFrameCache::GetCache().Purge();
     EnableSequenceControls(true);  // let it re-evaluate menu state
     SetStatusText("");
     SetStatusText(CurrentDir, true);
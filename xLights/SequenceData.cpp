@@ -9,9 +9,18 @@
 
 #include "SequenceData.h"
 #include <wx/wx.h>
+#include <wx/filename.h>
 #include <log4cpp/Category.hh>
 #include "UtilFunctions.h"
 
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 const unsigned char FrameData::_constzero = 0;
 
 SequenceData::SequenceData() {
@@ -21,25 +30,113 @@ SequenceData::SequenceData() {
     _numChannels = 0;
     _bytesPerFrame = 0;
     _frameTime = 50;
+    _memoryMapped = false;
+#ifdef __WXMSW__
+    _mapFile = INVALID_HANDLE_VALUE;
+    _mapHandle = nullptr;
+#else
+    _mapFile = -1;
+#endif
+    _mapSize = 0;
 }
 
 SequenceData::~SequenceData() {
-    if (_data != nullptr) {
-        free(_data);
-    }
+    FreeData();
     if (_invalidData != nullptr) {
         free(_invalidData);
     }
 }
 
-void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4) {
+void SequenceData::FreeData() {
+    if (_data == nullptr) {
+        return;
+    }
+    if (!_memoryMapped) {
+        free(_data);
+        _data = nullptr;
+        return;
+    }
+#ifdef __WXMSW__
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapHandle);
+    CloseHandle(_mapFile); // file was opened delete on close
+    _mapHandle = nullptr;
+    _mapFile = INVALID_HANDLE_VALUE;
+#else
+    munmap(_data, _mapSize);
+    close(_mapFile);
+    _mapFile = -1;
+#endif
+    _data = nullptr;
+    _mapSize = 0;
+    _memoryMapped = false;
+}
 
+unsigned char *SequenceData::AllocMapped(size_t sz) {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    if (_data != nullptr) {
-        free(_data);
-        _data = nullptr;
+    wxString fn = wxFileName::CreateTempFileName("xLightsSeqData");
+    if (fn == "") {
+        logger_base.error("Unable to create temp file for frame data.");
+        return nullptr;
     }
+
+    unsigned char *data = nullptr;
+#ifdef __WXMSW__
+    HANDLE file = CreateFileW(fn.wc_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        logger_base.error("Unable to open temp file %s for frame data.", (const char *)fn.c_str());
+        wxRemoveFile(fn);
+        return nullptr;
+    }
+    HANDLE map = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)sz >> 32), (DWORD)(sz & 0xFFFFFFFF), nullptr);
+    if (map != nullptr) {
+        data = (unsigned char *)MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, sz);
+    }
+    if (data == nullptr) {
+        logger_base.error("Unable to map temp file %s for frame data. Error %d.", (const char *)fn.c_str(), (int)GetLastError());
+        if (map != nullptr) {
+            CloseHandle(map);
+        }
+        CloseHandle(file);
+        return nullptr;
+    }
+    _mapFile = file;
+    _mapHandle = map;
+#else
+    int fd = open(fn.c_str(), O_RDWR);
+    // the file stays around until we close it but is cleaned up even if we crash
+    unlink(fn.c_str());
+    if (fd == -1) {
+        logger_base.error("Unable to open temp file %s for frame data.", (const char *)fn.c_str());
+        return nullptr;
+    }
+    // sparse file, pages are zero until written
+    if (ftruncate(fd, sz) == 0) {
+        void *p = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            data = (unsigned char *)p;
+        }
+    }
+    if (data == nullptr) {
+        logger_base.error("Unable to map temp file %s for frame data.", (const char *)fn.c_str());
+        close(fd);
+        return nullptr;
+    }
+    _mapFile = fd;
+#endif
+    _mapSize = sz;
+    _memoryMapped = true;
+    logger_base.debug("Frame data memory mapped to temp file %s.", (const char *)fn.c_str());
+    return data;
+}
+
+void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4) {
+
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    FreeData();
     if (_invalidData != nullptr) {
         free(_invalidData);
         _invalidData = nullptr;
@@ -62,7 +159,20 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
         //size_t sz = tmp;
         //wxASSERT((unsigned long)sz == tmp); // if this fails then we are asking for more memory than the system can address
         size_t sz = (size_t)_bytesPerFrame * (size_t)_numFrames;
-        _data = (unsigned char *)calloc(1, sz);
+
+        // if the frame data would take more than half of the free memory back it with a temp file
+        // so the OS can page it rather than us running the machine out of memory
+        wxMemorySize freeMem = wxGetFreeMemory();
+        if (freeMem != -1 && wxMemorySize(sz) > freeMem / 2) {
+            _data = AllocMapped(sz);
+        }
+        if (_data == nullptr) {
+            _data = (unsigned char *)calloc(1, sz);
+        }
+        if (_data == nullptr) {
+            logger_base.warn("Unable to allocate %ld bytes for frame data, trying a memory mapped temp file.", sz);
+            _data = AllocMapped(sz);
+        }
         wxASSERT(_data != nullptr); // if this fails then we have a memory allocation error
         if (_data == nullptr)
         {
@@ -73,7 +183,7 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
         }
         else
         {
-            logger_base.debug("Memory allocated for frame data. Frames=%d, Channels=%d, Memory=%ld.", _numFrames, _numChannels, sz);
+            logger_base.debug("Memory allocated for frame data. Frames=%d, Channels=%d, Memory=%ld, Mapped=%s.", _numFrames, _numChannels, sz, _memoryMapped ? "Yes" : "No");
         }
     }
     else
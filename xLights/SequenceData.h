@@ -57,6 +57,7 @@ public:
     unsigned int NumFrames() const { return _numFrames;}
     unsigned int FrameTime() const { return _frameTime;}
     bool IsValidData() const { return _data != nullptr; }
+    bool IsMemoryMapped() const { return _memoryMapped; }
 
     // encodes contents of SeqData in channel order
     wxString base64_encode();
@@ -64,7 +65,20 @@ public:
 private:
     SequenceData(const SequenceData&);  //make sure we cannot "copy" these
     SequenceData &operator=(const SequenceData& rgb);
-    
+
+    // the frame data can either be on the heap or in a memory mapped temp file which lets the OS page
+    // it out to disk rather than fail the allocation when it does not fit in memory
+    unsigned char *AllocMapped(size_t sz);
+    void FreeData();
+
+    bool _memoryMapped;
+#ifdef __WXMSW__
+    void *_mapFile;
+    void *_mapHandle;
+#else
+    int _mapFile;
+#endif
+    size_t _mapSize;
     unsigned char *_invalidData;
     unsigned char *_data;
     unsigned int _bytesPerFrame;
@@ -15,6 +15,7 @@
 #include "xLightsMain.h"
 #include "ConvertDialog.h"
 #include "FileConverter.h"
+#include "FSEQv2.h"
 
 #include <wx/msgdlg.h>
 #include "UtilFunctions.h"
@@ -492,7 +493,7 @@ void FRAMECLASS WriteLcbFile(const wxString& filename, long numChans, long numPe
 
         int lastEndTime = 0;
         for (int eidx = 0; eidx < layer.GetEffectCount(); eidx++) {
-            Effect *eff = layer.GetEffect(eidx);
+            const Effect *eff = layer.GetEffect(eidx);
             if (eff->GetStartTimeMS() != lastEndTime) {
                 //off from last effect to start of this effect
                 if (ver == 1) {
@@ -1199,8 +1200,80 @@ void FRAMECLASS ReadXlightsFile(const wxString& FileName, wxString *mediaFilenam
     f.Close();
 }
 
+void FRAMECLASS WriteFalconPiV2File(const wxString& filename)
+{
+    FSEQv2Writer writer(SeqData.NumChannels(), SeqData.NumFrames(), SeqData.FrameTime());
+    writer.SetMediaFilename(mediaFilename.ToStdString());
+
+    // only store the channels that are on in at least one frame, gaps shorter than a universe are not worth a range
+    unsigned int numChannels = SeqData.NumChannels();
+    std::vector<unsigned char> used(numChannels, 0);
+    for (unsigned int frame = 0; frame < SeqData.NumFrames(); frame++)
+    {
+        const unsigned char* data = &SeqData[frame][0];
+        for (unsigned int ch = 0; ch < numChannels; ch++)
+        {
+            used[ch] |= data[ch];
+        }
+    }
+    if (numChannels > 0)
+    {
+        // keep the last channel so readers still see the full channel count
+        used[numChannels - 1] = 1;
+    }
+
+    std::vector<FSEQv2Range> ranges;
+    for (unsigned int ch = 0; ch < numChannels; ch++)
+    {
+        if (used[ch] == 0) continue;
+
+        if (!ranges.empty() && ch - (ranges.back().start + ranges.back().count) < 512)
+        {
+            ranges.back().count = ch - ranges.back().start + 1;
+        }
+        else
+        {
+            ranges.push_back(FSEQv2Range(ch, 1));
+        }
+    }
+
+    // one range from channel 1 is the whole frame and too many ranges wont fit in the header so write those in full
+    if (ranges.size() <= FSEQ_V2_MAX_RANGES && !(ranges.size() == 1 && ranges.front().start == 0))
+    {
+        for (auto it = ranges.begin(); it != ranges.end(); ++it)
+        {
+            writer.AddSparseRange(it->start, it->count);
+        }
+    }
+
+    if (!writer.Open(filename))
+    {
+        ConversionError(wxString("Unable to create file: ") + filename);
+        return;
+    }
+
+    for (unsigned int frame = 0; frame < SeqData.NumFrames(); frame++)
+    {
+        if (!writer.AddFrame(&SeqData[frame][0]))
+        {
+            break;
+        }
+    }
+
+    if (!writer.Close())
+    {
+        ConversionError(wxString("Error writing compressed sequence file: ") + filename);
+    }
+}
+
 void FRAMECLASS WriteFalconPiFile(const wxString& filename)
 {
+    if (_compressedFSEQ)
+    {
+        WriteFalconPiV2File(filename);
+        return;
+    }
+
     wxUint8 vMinor = 0;
     wxUint8 vMajor = 1;
     wxUint16 fixedHeaderLength = 28;
@@ -18,6 +18,8 @@
 
 #include "LayoutPanel.h"
 #include "xLightsXmlFile.h"
+#include "effects/ImageCache.h"
+#include "effects/VideoFrameCache.h"
 #include "controllers/FPP.h"
 #include "controllers/Falcon.h"
 #include "controllers/Pixlite16.h"
@@ -236,6 +238,12 @@ bool xLightsFrame::SetDir(const wxString& newdir)
     CurrentDir=newdir;
     showDirectory=newdir;
 
+    // cached effects can depend on files in the show folder
+    _renderCache.Purge();
+    ImageCache::GetCache().Purge();
+    VideoFrameCache::GetCache().Purge();
+    SetRenderCacheFolder();
+
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("Show directory set to : %s.", (const char *)showDirectory.c_str());
 
@@ -4,6 +4,10 @@
 #include <map>
 #include <string>
 #include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <memory>
 
 
 class MapStringString: public std::map<std::string,std::string> {
@@ -182,17 +186,161 @@ private:
     static const std::string EMPTY_STRING;
 };
 
+// A setting parsed once into each of the types it may be read as. The parsing matches stoi/stof/stod
+// so a value that would have thrown gives the caller's default.
+class SettingValue {
+public:
+    SettingValue(const std::string &value) {
+        const char *str = value.c_str();
+        char *end = nullptr;
+
+        errno = 0;
+        long l = strtol(str, &end, 10);
+        isInt = !value.empty() && end != str && errno != ERANGE && l >= INT_MIN && l <= INT_MAX;
+        intValue = isInt ? (int)l : 0;
+
+        errno = 0;
+        floatValue = strtof(str, &end);
+        isFloat = !value.empty() && end != str && errno != ERANGE;
+
+        errno = 0;
+        doubleValue = strtod(str, &end);
+        isDouble = !value.empty() && end != str && errno != ERANGE;
+
+        boolValue = value.length() >= 1 && value.at(0) == '1';
+    }
+
+    int intValue;
+    float floatValue;
+    double doubleValue;
+    bool boolValue;
+    bool isInt;
+    bool isFloat;
+    bool isDouble;
+};
+
+class ValueCurve;
+
+// A value curve parsed once for rendering and the limits it was parsed with
+class CompiledValueCurve {
+public:
+    std::shared_ptr<ValueCurve> curve;
+    float min;
+    float max;
+    int divisor;
+    bool divided;
+};
+
 class SettingsMap: public MapStringString {
 public:
-    SettingsMap(): MapStringString() {
+    SettingsMap(): MapStringString(), compiled(false) {
     }
     virtual ~SettingsMap() {}
 
     virtual void RemapKey(std::string &n, std::string &value) {
         RemapChangedSettingKey(n, value);
     }
+
+    // Parses every setting up front so the numeric getters the effects call every frame are a lookup
+    // rather than a string conversion. Changes made through operator[] afterwards are not seen by
+    // the getters until Compile is called again.
+    void Compile() {
+        values.clear();
+        valueCurves.clear();
+        for (const_iterator it = begin(); it != end(); ++it) {
+            values.emplace(it->first, SettingValue(it->second));
+        }
+        compiled = true;
+    }
+    bool IsCompiled() const { return compiled; }
+
+    // Value curves parsed by the effects while rendering. These are only kept while compiled.
+    CompiledValueCurve *GetCompiledValueCurve(const std::string &key) {
+        auto it = valueCurves.find(key);
+        return it == valueCurves.end() ? nullptr : &it->second;
+    }
+    void SetCompiledValueCurve(const std::string &key, const CompiledValueCurve &vc) {
+        if (compiled) valueCurves[key] = vc;
+    }
+
+    void clear() {
+        Uncompile();
+        MapStringString::clear();
+    }
+    void Parse(const std::string &str) {
+        Uncompile();
+        MapStringString::Parse(str);
+    }
+    size_type erase(const char *ckey) {
+        Uncompile();
+        return MapStringString::erase(ckey);
+    }
+    size_type erase(const std::string &key) {
+        Uncompile();
+        return MapStringString::erase(key);
+    }
+
+    int GetInt(const std::string &key, const int def = 0) const {
+        if (!compiled) return MapStringString::GetInt(key, def);
+        const SettingValue *v = Find(key);
+        return (v == nullptr || !v->isInt) ? def : v->intValue;
+    }
+    int GetInt(const char *ckey, const int def = 0) const {
+        if (!compiled) return MapStringString::GetInt(ckey, def);
+        const SettingValue *v = Find(ckey);
+        return (v == nullptr || !v->isInt) ? def : v->intValue;
+    }
+    float GetFloat(const std::string &key, const float def = 0.0) const {
+        if (!compiled) return MapStringString::GetFloat(key, def);
+        const SettingValue *v = Find(key);
+        return (v == nullptr || !v->isFloat) ? def : v->floatValue;
+    }
+    float GetFloat(const char *ckey, const float &def = 0.0) const {
+        if (!compiled) return MapStringString::GetFloat(ckey, def);
+        const SettingValue *v = Find(ckey);
+        return (v == nullptr || !v->isFloat) ? def : v->floatValue;
+    }
+    double GetDouble(const std::string &key, const double def = 0.0) const {
+        if (!compiled) return MapStringString::GetDouble(key, def);
+        const SettingValue *v = Find(key);
+        return (v == nullptr || !v->isDouble) ? def : v->doubleValue;
+    }
+    double GetDouble(const char *ckey, const double &def = 0.0) const {
+        if (!compiled) return MapStringString::GetDouble(ckey, def);
+        const SettingValue *v = Find(ckey);
+        return (v == nullptr || !v->isDouble) ? def : v->doubleValue;
+    }
+    bool GetBool(const std::string &key, const bool def = false) const {
+        if (!compiled) return MapStringString::GetBool(key, def);
+        const SettingValue *v = Find(key);
+        return v == nullptr ? def : v->boolValue;
+    }
+    bool GetBool(const char *ckey, const bool def = false) const {
+        if (!compiled) return MapStringString::GetBool(ckey, def);
+        const SettingValue *v = Find(ckey);
+        return v == nullptr ? def : v->boolValue;
+    }
+
 private:
     static void RemapChangedSettingKey(std::string &n,  std::string &value);
+
+    // std::less<> lets us look up a const char * key without building a std::string
+    template <typename K>
+    const SettingValue *Find(const K &key) const {
+        auto it = values.find(key);
+        return it == values.end() ? nullptr : &it->second;
+    }
+    void Uncompile() {
+        if (compiled) {
+            values.clear();
+            valueCurves.clear();
+            compiled = false;
+        }
+    }
+
+    std::map<std::string, SettingValue, std::less<>> values;
+    std::map<std::string, CompiledValueCurve> valueCurves;
+    bool compiled;
 };
 
 
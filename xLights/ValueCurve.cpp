@@ -384,6 +384,7 @@ void ValueCurve::GetRangeParm4(const std::string& type, float& low, float &high)
 
 void ValueCurve::Reverse()
 {
+    ClearBake();
     if (_type == "Custom")
     {
         for (auto it = _values.begin(); it != _values.end(); ++it)
@@ -582,6 +583,7 @@ void ValueCurve::FixChangedScale(float newmin, float newmax, int divisor)
 
 void ValueCurve::ConvertChangedScale(float newmin, float newmax)
 {
+    ClearBake();
     if (newmin == _min && newmax == _max) return;
 
     float newrange = newmax - newmin;
@@ -608,6 +610,7 @@ void ValueCurve::ConvertChangedScale(float newmin, float newmax)
 
 void ValueCurve::RenderType()
 {
+    ClearBake();
     // dont render if we dont know our limits
     if (_min == MINVOIDF || _max == MAXVOIDF || _divisor == MAXVOID) return;
 
@@ -1076,6 +1079,7 @@ ValueCurve::ValueCurve(const std::string& s)
 
 void ValueCurve::Deserialise(const std::string& s, bool holdminmax)
 {
+    ClearBake();
     if (s == "")
     {
         SetDefault(0, 100);
@@ -1325,48 +1329,32 @@ float ValueCurve::GetOutputValueAtDivided(float offset)
     return (_min + (_max - _min) * GetValueAt(offset)) / _divisor;
 }
 
-float ValueCurve::GetValueAt(float offset)
+float ValueCurve::InterpolateValue(const vcSortablePoint& last, const vcSortablePoint* next, float lastY, float offset) const
 {
     float res = 0.0f;
 
-    if (_values.size() < 2) return 1.0f;
-    if (!_active) return 1.0f;
-
-    if (offset < 0.0f) offset = 0.0;
-    if (offset > 1.0f) offset = 1.0;
-
-    vcSortablePoint last = _values.front();
-    auto it = _values.begin();
-    ++it;
-
-    while (it != _values.end() && it->x < offset)
-    {
-        last = *it;
-        ++it;
-    }
-
-    if (it == _values.end())
+    if (next == nullptr)
     {
-        res = _values.back().y;
+        res = lastY;
     }
-    else if (it->x == last.x)
+    else if (next->x == last.x)
     {
         // this should not be possible
-        res = it->y;
+        res = next->y;
     }
     else
     {
-        if (it->x == offset)
+        if (next->x == offset)
         {
-            res = it->y;
+            res = next->y;
         }
-        else if (it->IsWrapped())
+        else if (next->wrapped)
         {
-            res = it->y;
+            res = next->y;
         }
         else
         {
-            res = last.y + (it->y - last.y) * (offset - last.x) / (it->x - last.x);
+            res = last.y + (next->y - last.y) * (offset - last.x) / (next->x - last.x);
         }
     }
 
@@ -1382,6 +1370,60 @@ float ValueCurve::GetValueAt(float offset)
     return res;
 }
 
+void ValueCurve::Bake()
+{
+    ClearBake();
+
+    if (_values.size() < 2) return;
+
+    _bakedValues.assign(_values.begin(), _values.end());
+
+    // all points sit on the 1/VC_X_POINTS grid so starting the search at the first point not below
+    // the offset's grid step leaves at most a step or two to walk. The small margin keeps this safe
+    // against float rounding of the offset.
+    size_t i = 1;
+    for (int step = 0; step <= VC_X_POINTS; step++)
+    {
+        float from = (float)step / VC_X_POINTS - 0.001f;
+        while (i < _bakedValues.size() && _bakedValues[i].x < from)
+        {
+            i++;
+        }
+        _bakedIndex.push_back(i);
+    }
+}
+
+float ValueCurve::GetValueAt(float offset)
+{
+    if (_values.size() < 2) return 1.0f;
+    if (!_active) return 1.0f;
+
+    if (offset < 0.0f) offset = 0.0;
+    if (offset > 1.0f) offset = 1.0;
+
+    if (IsBaked())
+    {
+        size_t i = _bakedIndex[(int)(offset * VC_X_POINTS)];
+        while (i < _bakedValues.size() && _bakedValues[i].x < offset)
+        {
+            i++;
+        }
+        return InterpolateValue(_bakedValues[i - 1], i == _bakedValues.size() ? nullptr : &_bakedValues[i], _bakedValues.back().y, offset);
+    }
+
+    vcSortablePoint last = _values.front();
+    auto it = _values.begin();
+    ++it;
+
+    while (it != _values.end() && it->x < offset)
+    {
+        last = *it;
+        ++it;
+    }
+
+    return InterpolateValue(last, it == _values.end() ? nullptr : &(*it), _values.back().y, offset);
+}
+
 bool ValueCurve::IsSetPoint(float offset)
 {
     auto it = _values.begin();
@@ -1399,6 +1441,7 @@ bool ValueCurve::IsSetPoint(float offset)
 
 void ValueCurve::DeletePoint(float offset)
 {
+    ClearBake();
     if (GetPointCount() > 2)
     {
         auto it = _values.begin();
@@ -1416,6 +1459,7 @@ void ValueCurve::DeletePoint(float offset)
 
 void ValueCurve::RemoveExcessCustomPoints()
 {
+    ClearBake();
     // go through list and remove middle points where 3 in a row have the same value
     auto it1 = _values.begin();
     auto it2 = it1;
@@ -1444,6 +1488,7 @@ void ValueCurve::RemoveExcessCustomPoints()
 
 void ValueCurve::SetValueAt(float offset, float value)
 {
+    ClearBake();
     auto it = _values.begin();
     while (it != _values.end() && *it <= offset)
     {
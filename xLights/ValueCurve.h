@@ -4,6 +4,7 @@
 #include <wx/position.h>
 #include <string>
 #include <list>
+#include <vector>
 
 #define MINVOID -91234
 #define MAXVOID 91234
@@ -81,7 +82,13 @@ class ValueCurve
     bool _wrap;
     bool _realValues;
 
+    // a copy of _values and for each 1/VC_X_POINTS step of the offset the first point at or after it
+    std::vector<vcSortablePoint> _bakedValues;
+    std::vector<size_t> _bakedIndex;
+
     void RenderType();
+    void ClearBake() { _bakedValues.clear(); _bakedIndex.clear(); }
+    float InterpolateValue(const vcSortablePoint& last, const vcSortablePoint* next, float lastY, float offset) const;
     void SetSerialisedValue(std::string k, std::string s);
     float SafeParameter(size_t p, float v);
     float Safe01(float v);
@@ -110,6 +117,10 @@ public:
     void SetLimits(float min, float max) { _min = min; _max = max; }
     void FixScale(int scale);
     float GetValueAt(float offset);
+    // Indexes the points so GetValueAt no longer walks the list ... call once the curve is set up for
+    // rendering. Any change to the curve discards the index.
+    void Bake();
+    bool IsBaked() const { return !_bakedIndex.empty(); }
     float GetOutputValueAt(float offset);
     float GetOutputValueAtDivided(float offset);
     float GetOutputValue(float offset);
@@ -6,8 +6,42 @@
 #undef min
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <wx/filename.h>
 
+// Decodes frames ahead of the reader's position on a job pool thread
+class VideoPrefetchJob : public Job
+{
+    std::function<void()> _fn;
+
+public:
+    VideoPrefetchJob(std::function<void()> fn) : _fn(fn) {}
+    virtual ~VideoPrefetchJob() {};
+    virtual void Process() override { _fn(); }
+    virtual std::string GetStatus() override { return ""; }
+    virtual bool DeleteWhenComplete() override { return true; }
+    virtual const std::string GetName() const override { return "VideoPrefetch"; }
+};
+
+static AVFrame* AllocScaledFrame(int width, int height)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->width = width;
+    frame->height = height;
+    frame->linesize[0] = width * 3;
+    frame->data[0] = (uint8_t *)av_malloc(width * height * 3 * sizeof(uint8_t));
+    return frame;
+}
+
+static void FreeScaledFrame(AVFrame* frame)
+{
+    if (frame->data[0] != nullptr)
+    {
+        av_free(frame->data[0]);
+    }
+    av_free(frame);
+}
+
 VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheight, bool keepaspectratio, bool usenativeresolution/*false*/)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -24,6 +58,15 @@ VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheigh
 	_swsCtx = nullptr;
     _dtspersec = 1;
     _frames = 0;
+    _prefetchFrames = 0;
+    _prefetchPos = 0;
+    _prefetchRunning = false;
+    _prefetchStop = false;
+    _prefetchEnd = false;
+    av_init_packet(&_packet);
+    _packet.data = nullptr;
+    _packet.size = 0;
+    _packetRemaining = _packet;
 
 	av_register_all();
 
@@ -53,8 +96,10 @@ VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheigh
     _videoStream->discard = AVDISCARD_NONE;
 	_codecContext = _videoStream->codec;
 
-    _codecContext->active_thread_type = FF_THREAD_FRAME;
-    _codecContext->thread_count = 1;
+    // let the decoder use as many threads as it likes ... frame threading holds back the last few frames
+    // until it is flushed which ReadFrame does at the end of the file
+    _codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    _codecContext->thread_count = 0;
 	if (avcodec_open2(_codecContext, cdc, nullptr) != 0)
 	{
         logger_base.error("VideoReader: Couldn't open the context with the decoder in " + filename);
@@ -147,11 +192,7 @@ VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheigh
         logger_base.warn("Attempts to determine length of video have not been successful. Problems ahead.");
 	}
 
-	_dstFrame = av_frame_alloc();
-	_dstFrame->width = _width;
-	_dstFrame->height = _height;
-	_dstFrame->linesize[0] = _width * 3;
-	_dstFrame->data[0] = (uint8_t *)av_malloc(_width * _height * 3 * sizeof(uint8_t));
+	_dstFrame = AllocScaledFrame(_width, _height);
 
     _srcFrame = av_frame_alloc();
     _srcFrame->pkt_pts = 0;
@@ -160,7 +201,6 @@ VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheigh
                              _codecContext->pix_fmt, _width, _height, _pixelFmt, SWS_BICUBIC, nullptr,
                              nullptr, nullptr);
 
-    av_init_packet(&_packet);
 	_valid = true;
 
     logger_base.info("Video loaded: " + filename);
@@ -194,6 +234,17 @@ static int DTStoMS(int64_t dts , int dtspersec)
 }
 
 int VideoReader::GetPos()
+{
+    if (_prefetchFrames > 0)
+    {
+        std::unique_lock<std::mutex> lock(_prefetchLock);
+        return _prefetchPos;
+    }
+    return GetDecodedPos();
+}
+
+// the position of the last frame out of the decoder which is ahead of GetPos when prefetching
+int VideoReader::GetDecodedPos()
 {
     return DTStoMS(_srcFrame->pkt_dts, _dtspersec);
 }
@@ -222,6 +273,14 @@ bool VideoReader::IsVideoFile(const std::string& filename)
 
 VideoReader::~VideoReader()
 {
+    StopPrefetch();
+    for (auto it = _freeFrames.begin(); it != _freeFrames.end(); ++it)
+    {
+        FreeScaledFrame(*it);
+    }
+    _freeFrames.clear();
+    av_packet_unref(&_packet);
+
     if (_swsCtx != nullptr) {
         sws_freeContext(_swsCtx);
         _swsCtx = nullptr;
@@ -233,11 +292,7 @@ VideoReader::~VideoReader()
     }
 	if (_dstFrame != nullptr)
 	{
-		if (_dstFrame->data[0] != nullptr)
-		{
-			av_free(_dstFrame->data[0]);
-		}
-		av_free(_dstFrame);
+		FreeScaledFrame(_dstFrame);
 		_dstFrame = nullptr;
 	}
 	if (_codecContext != nullptr)
@@ -252,6 +307,54 @@ VideoReader::~VideoReader()
 	}
 }
 
+// Decodes until the next frame is in _srcFrame. False once there are no more frames.
+bool VideoReader::ReadFrame()
+{
+    while (true)
+    {
+        if (_packetRemaining.size <= 0)
+        {
+            av_packet_unref(&_packet);
+            if (av_read_frame(_formatContext, &_packet) < 0)
+            {
+                // at the end of the file an empty packet gets back any frames the decoder threads are holding
+                AVPacket empty;
+                av_init_packet(&empty);
+                empty.data = nullptr;
+                empty.size = 0;
+                int frameFinished = 0;
+                avcodec_decode_video2(_codecContext, _srcFrame, &frameFinished, &empty);
+                return frameFinished != 0;
+            }
+
+            // Is this a packet from the video stream?
+            if (_packet.stream_index != _streamIndex)
+            {
+                continue;
+            }
+            _packetRemaining = _packet;
+        }
+
+        // Decode video frame
+        int frameFinished = 0;
+        int ret = avcodec_decode_video2(_codecContext, _srcFrame, &frameFinished, &_packetRemaining);
+        if (ret >= 0) {
+            ret = FFMIN(ret, _packetRemaining.size); /* guard against bogus return values */
+            _packetRemaining.data += ret;
+            _packetRemaining.size -= ret;
+        }
+        else {
+            _packetRemaining.size = 0;
+        }
+
+        // Did we get a video frame?
+        if (frameFinished)
+        {
+            return true;
+        }
+    }
+}
+
 void VideoReader::Seek(int timestampMS)
 {
 	// we have to be valid
@@ -259,6 +362,11 @@ void VideoReader::Seek(int timestampMS)
 	{
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         //logger_base.info("       VideoReader: Seeking to %d ms.", timestampMS);
+
+        // the decoder is ours until we start prefetching again
+        StopPrefetch();
+        _packetRemaining.size = 0;
+
         if (timestampMS < _lengthMS)
 		{
 			_atEnd = false;
@@ -269,6 +377,7 @@ void VideoReader::Seek(int timestampMS)
 			_atEnd = true;
             avcodec_flush_buffers(_codecContext);
             av_seek_frame(_formatContext, _streamIndex, MStoDTS(_lengthMS, _dtspersec), AVSEEK_FLAG_FRAME);
+            _prefetchPos = GetDecodedPos();
             return;
 		}
 
@@ -281,55 +390,152 @@ void VideoReader::Seek(int timestampMS)
 		
         int currenttime = -999999;
 
-        AVPacket pkt2;
         // Stop seeking 100ms before where we need ... that way we can read up to the frame we need
-        while (currenttime < timestampMS - 100 && av_read_frame(_formatContext, &_packet) >= 0)
+        while (currenttime < timestampMS - 100 && ReadFrame())
 		{
+            currenttime = GetDecodedPos();
 
-			// Is this a packet from the video stream?
-			if (_packet.stream_index == _streamIndex)
-			{
-				// Decode video frame
-                pkt2 = _packet;
-                while (pkt2.size) {
-                    int frameFinished = 0;
-                    int ret = avcodec_decode_video2(_codecContext, _srcFrame, &frameFinished,
-                        &pkt2);
-
-                    // Did we get a video frame?
-                    if (frameFinished)
-                    {
-                        currenttime = GetPos();
-
-                        // only prepare the image if we are close to the desired frame
-                        if (currenttime / _frames >= (timestampMS / _frames) - 2)
-                        {
+            // only prepare the image if we are close to the desired frame
+            if (currenttime / _frames >= (timestampMS / _frames) - 2)
+            {
 #ifdef VIDEO_EXTRALOGGING
-                            logger_base.debug("Seek video %s decoding frame %d.", (const char *)_filename.c_str(), currenttime);
+                logger_base.debug("Seek video %s decoding frame %d.", (const char *)_filename.c_str(), currenttime);
 #endif
 
-                            sws_scale(_swsCtx, _srcFrame->data, _srcFrame->linesize, 0,
-                                _codecContext->height, _dstFrame->data,
-                                _dstFrame->linesize);
-                        }
-                    }
-                    if (ret >= 0) {
-                        ret = FFMIN(ret, pkt2.size); /* guard against bogus return values */
-                        pkt2.data += ret;
-                        pkt2.size -= ret;
-                    }
-                    else {
-                        pkt2.size = 0;
-                    }
-                }
+                sws_scale(_swsCtx, _srcFrame->data, _srcFrame->linesize, 0,
+                    _codecContext->height, _dstFrame->data,
+                    _dstFrame->linesize);
             }
-
-			// Free the packet that was allocated by av_read_frame
-			av_packet_unref(&_packet);
 		}
+        _prefetchPos = GetDecodedPos();
 	}
 }
 
+void VideoReader::EnablePrefetch(int frames)
+{
+    if (!_valid) return;
+
+    std::unique_lock<std::mutex> lock(_prefetchLock);
+    _prefetchFrames = std::max(frames, 1);
+    _prefetchPos = GetDecodedPos();
+}
+
+// Queues a job to top up the prefetched frames if one is not already running. Must hold _prefetchLock.
+void VideoReader::StartPrefetch()
+{
+    if (_prefetchRunning || _prefetchEnd || (int)_prefetched.size() >= _prefetchFrames) return;
+
+    _prefetchRunning = true;
+    _prefetchPool.PushJob(new VideoPrefetchJob([this]() { PrefetchFrames(); }));
+}
+
+// Waits for any prefetch job to finish and drops the frames it decoded
+void VideoReader::StopPrefetch()
+{
+    std::unique_lock<std::mutex> lock(_prefetchLock);
+    _prefetchStop = true;
+    _prefetchSignal.wait(lock, [this]() { return !_prefetchRunning; });
+    _prefetchStop = false;
+    _prefetchEnd = false;
+
+    for (auto it = _prefetched.begin(); it != _prefetched.end(); ++it)
+    {
+        _freeFrames.push_back(it->second);
+    }
+    _prefetched.clear();
+}
+
+// Runs on the job pool ... decodes and scales frames until the queue is full. The decoder is only
+// touched without holding the lock so the renderer can take frames while the next one is decoded.
+void VideoReader::PrefetchFrames()
+{
+    std::unique_lock<std::mutex> lock(_prefetchLock);
+    while (!_prefetchStop && !_prefetchEnd && (int)_prefetched.size() < _prefetchFrames)
+    {
+        AVFrame* frame;
+        if (_freeFrames.empty())
+        {
+            frame = AllocScaledFrame(_width, _height);
+        }
+        else
+        {
+            frame = _freeFrames.front();
+            _freeFrames.pop_front();
+        }
+        lock.unlock();
+
+        bool decoded = ReadFrame();
+        int pos = 0;
+        if (decoded)
+        {
+            pos = GetDecodedPos();
+            sws_scale(_swsCtx, _srcFrame->data, _srcFrame->linesize, 0,
+                _codecContext->height, frame->data,
+                frame->linesize);
+        }
+
+        lock.lock();
+        if (!decoded)
+        {
+            _freeFrames.push_back(frame);
+            _prefetchEnd = true;
+        }
+        else
+        {
+            _prefetched.push_back(std::make_pair(pos, frame));
+            if (pos > _lengthMS)
+            {
+                _prefetchEnd = true;
+            }
+        }
+        _prefetchSignal.notify_all();
+    }
+    _prefetchRunning = false;
+    _prefetchSignal.notify_all();
+}
+
+// The prefetching equivalent of reading frames until we pass the requested time
+AVFrame* VideoReader::GetPrefetchedFrame(int timestampMS, int gracetime)
+{
+    // If the caller is after an old frame we have to seek first
+    if (GetPos() > timestampMS + gracetime)
+    {
+#ifdef VIDEO_EXTRALOGGING
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        logger_base.debug("Video %s seeking back from %d to %d.", (const char *)_filename.c_str(), GetPos(), timestampMS);
+#endif
+        Seek(timestampMS);
+    }
+
+    std::unique_lock<std::mutex> lock(_prefetchLock);
+    while (_prefetchPos <= timestampMS && _prefetchPos <= _lengthMS)
+    {
+        if (_prefetched.empty())
+        {
+            if (_prefetchEnd) break;
+
+            StartPrefetch();
+            _prefetchSignal.wait(lock, [this]() { return !_prefetched.empty() || !_prefetchRunning; });
+            continue;
+        }
+
+        _freeFrames.push_back(_dstFrame);
+        _dstFrame = _prefetched.front().second;
+        _prefetchPos = _prefetched.front().first;
+        _prefetched.pop_front();
+    }
+
+    // keep decoding while the caller renders this frame
+    StartPrefetch();
+
+    if (_dstFrame->data[0] == nullptr || _prefetchPos > _lengthMS)
+    {
+        _atEnd = true;
+        return nullptr;
+    }
+    return _dstFrame;
+}
+
 AVFrame* VideoReader::GetNextFrame(int timestampMS, int gracetime)
 {
     if (!_valid)
@@ -343,75 +549,43 @@ AVFrame* VideoReader::GetNextFrame(int timestampMS, int gracetime)
         return nullptr;
     }
 
+    if (_prefetchFrames > 0)
+    {
+        return GetPrefetchedFrame(timestampMS, gracetime);
+    }
+
 #ifdef VIDEO_EXTRALOGGING
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("Video %s getting frame %d.", (const char *)_filename.c_str(), timestampMS);
 #endif
 
     // If the caller is after an old frame we have to seek first
-    int currenttime = GetPos();
+    int currenttime = GetDecodedPos();
     if (currenttime > timestampMS + gracetime)
     {
 #ifdef VIDEO_EXTRALOGGING
         logger_base.debug("Video %s seeking back from %d to %d.", (const char *)_filename.c_str(), currenttime, timestampMS);
 #endif
         Seek(timestampMS);
-        currenttime = GetPos();
+        currenttime = GetDecodedPos();
     }
 
-	if (timestampMS <= _lengthMS)
-	{
-		AVPacket pkt2;
+    while (currenttime <= timestampMS && currenttime <= _lengthMS && ReadFrame())
+    {
+        currenttime = GetDecodedPos();
 
-        int rc;
-		while (currenttime <= timestampMS && (rc = av_read_frame(_formatContext, &_packet)) >= 0 &&  currenttime <= _lengthMS)
-		{
-            // Is this a packet from the video stream?
-			if (_packet.stream_index == _streamIndex)
-			{
-				// Decode video frame
-                pkt2 = _packet;
-                while (pkt2.size) {
-                    int frameFinished = 0;
-                    int ret = avcodec_decode_video2(_codecContext, _srcFrame, &frameFinished,
-                                                &pkt2);
-
-                    // Did we get a video frame?
-                    if (frameFinished)
-                    {
-                        currenttime = GetPos();
-                        // only prepare the image if we are close to the desired frame
-                        if (currenttime / _frames >= (timestampMS / _frames) - 2)
-                        {
+        // only prepare the image if we are close to the desired frame
+        if (currenttime / _frames >= (timestampMS / _frames) - 2)
+        {
 #ifdef VIDEO_EXTRALOGGING
-                            logger_base.debug("Video %s decoding frame %d.", (const char *)_filename.c_str(), currenttime);
+            logger_base.debug("Video %s decoding frame %d.", (const char *)_filename.c_str(), currenttime);
 #endif
 
-                            sws_scale(_swsCtx, _srcFrame->data, _srcFrame->linesize, 0,
-                                _codecContext->height, _dstFrame->data,
-                                _dstFrame->linesize);
-                        }
-                    }
-
-                    if (ret >= 0) {
-                        ret = FFMIN(ret, pkt2.size); /* guard against bogus return values */
-                        pkt2.data += ret;
-                        pkt2.size -= ret;
-                    } else {
-                        pkt2.size = 0;
-                    }
-                }
-			}
-
-			// Free the packet that was allocated by av_read_frame
-			av_packet_unref(&_packet);
-		}
-	}
-	else
-	{
-		_atEnd = true;
-		return nullptr;
-	}
+            sws_scale(_swsCtx, _srcFrame->data, _srcFrame->linesize, 0,
+                _codecContext->height, _dstFrame->data,
+                _dstFrame->linesize);
+        }
+    }
 
 	if (_dstFrame->data[0] == nullptr || currenttime > _lengthMS)
 	{
@@ -3,6 +3,14 @@
 
 #include <string>
 #include <list>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include "JobPool.h"
+
+// how many frames VideoEffect keeps decoded ahead of the one it is rendering
+#define VIDEO_PREFETCH_FRAMES 8
 
 extern "C"
 {
@@ -20,6 +28,8 @@ public:
 	int GetLengthMS() { return _lengthMS; };
 	void Seek(int timestampMS);
 	AVFrame* GetNextFrame(int timestampMS, int gracetime = 0); // grace time is the minimum the video must be ahead before we bother to seek back to a frame
+    // decode and scale up to frames frames ahead on a background thread ... GetNextFrame then just takes them
+    void EnablePrefetch(int frames);
 	bool IsValid() { return _valid; };
 	int GetWidth() { return _width; };
 	int GetHeight() { return _height; };
@@ -28,6 +38,13 @@ public:
     std::string GetFilename() const { return _filename; }
 
 private:
+    int GetDecodedPos();
+    bool ReadFrame();
+    AVFrame* GetPrefetchedFrame(int timestampMS, int gracetime);
+    void PrefetchFrames();
+    void StartPrefetch();
+    void StopPrefetch();
+
 	bool _valid;
     int _lengthMS;
     int _dtspersec;
@@ -42,8 +59,21 @@ private:
     AVFrame* _srcFrame;
     SwsContext *_swsCtx;
     AVPacket _packet;
+    AVPacket _packetRemaining; // the part of _packet not yet decoded
 	AVPixelFormat _pixelFmt;
 	bool _atEnd;
     std::string _filename;
+
+    // background decoding
+    JobPool _prefetchPool;
+    std::mutex _prefetchLock;
+    std::condition_variable _prefetchSignal;
+    std::deque<std::pair<int, AVFrame*>> _prefetched; // scaled frames ahead of _dstFrame and their position
+    std::list<AVFrame*> _freeFrames;
+    int _prefetchFrames; // 0 if not prefetching
+    int _prefetchPos; // the position of _dstFrame
+    bool _prefetchRunning;
+    bool _prefetchStop;
+    bool _prefetchEnd;
 };
 #endif // VIDEOREADER_H
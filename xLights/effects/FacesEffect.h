@@ -15,6 +15,8 @@ class FacesEffect : public RenderableEffect
         virtual void SetPanelStatus(Model *cls) override;
         virtual void SetDefaultParameters(Model *cls) override;
         virtual void Render(Effect *effect, SettingsMap &settings, RenderBuffer &buffer) override;
+        // the output depends on the model's definition
+        virtual bool CanCacheRender(Effect *effect, const SettingsMap &settings) override { return false; }
         virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect* effect) override;
         virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff) override;
         virtual bool AppropriateOnNodes() const override { return false; }
@@ -176,10 +176,10 @@ void FireEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &
         if (buffer.GetMedia() != nullptr)
         {
             float f = 0.0;
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf.IsValid())
             {
-                f = *pf->begin();
+                f = pf[0];
             }
             HeightPct += 90 * f;
         }
@@ -20,7 +20,6 @@ class GIFImage
     bool _ok;
 	
 	void ReadFrameTimes();
-    int CalcFrameForTime(int msec, bool loop);
     wxPoint LoadRawImageFrame(wxImage& image, int frame, wxAnimationDisposal& disposal);
     void CopyImageToImage(wxImage& to, wxImage& from, wxPoint offset, bool overlay);
     void DoCreate(const std::string& filename, wxSize desiredSize);
@@ -32,6 +31,7 @@ class GIFImage
 		wxImage GetFrame(int frame);
 		wxImage GetFrameForTime(int msec, bool loop);
         int GetMSUntilNextFrame(int msec, bool loop);
+        int CalcFrameForTime(int msec, bool loop);
         std::string GetFilename() const { return _filename; }
         bool IsOk() const { return _ok; }
 
@@ -0,0 +1,258 @@
+#include "ImageCache.h"
+#include "GIFImage.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <log4cpp/Category.hh>
+
+#define IMAGECACHE_DEFAULT_MB 512
+
+ImageCache::ImageCache() : _bytes(0), _maxBytes((size_t)IMAGECACHE_DEFAULT_MB * 1024 * 1024), _hits(0), _misses(0)
+{
+}
+
+ImageCache& ImageCache::GetCache()
+{
+    static ImageCache cache;
+    return cache;
+}
+
+void ImageCache::SetMaxMemoryMB(int mb)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _maxBytes = (size_t)std::max(mb, 1) * 1024 * 1024;
+}
+
+void ImageCache::Purge()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _entries.clear();
+    _lru.clear();
+    _imageCounts.clear();
+    _movieFrameCounts.clear();
+    _bytes = 0;
+    _hits = 0;
+    _misses = 0;
+}
+
+void ImageCache::LogStats()
+{
+    static log4cpp::Category &logger_render = log4cpp::Category::getInstance(std::string("log_render"));
+
+    std::unique_lock<std::mutex> lock(_lock);
+    logger_render.debug("Image cache: %lu hits, %lu misses, %d images using %dMB of %dMB.",
+        (unsigned long)_hits, (unsigned long)_misses, (int)_entries.size(), (int)(_bytes / (1024 * 1024)), (int)(_maxBytes / (1024 * 1024)));
+
+    // each render reports its own hits and misses
+    _hits = 0;
+    _misses = 0;
+}
+
+// a changed file gets a new key so stale images are never used ... they just age out of the cache
+std::string ImageCache::GetFileKey(const std::string& filename)
+{
+    wxFileName fn(filename);
+    wxDateTime modified;
+    if (fn.FileExists() || wxDirExists(filename))
+    {
+        modified = fn.GetModificationTime();
+    }
+    return filename + "|" + (modified.IsValid() ? std::to_string(modified.GetTicks()) : std::string("0"));
+}
+
+bool ImageCache::Find(const std::string& key, Entry& entry)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) return false;
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+    entry = *it->second;
+    return true;
+}
+
+void ImageCache::Add(const Entry& entry)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    // another thread may have added it while we were loading it
+    if (_entries.find(entry.key) != _entries.end()) return;
+
+    _lru.push_front(entry);
+    _entries[entry.key] = _lru.begin();
+    _bytes += entry.bytes;
+
+    // anyone still using a dropped image keeps it until they are done with it
+    while (_bytes > _maxBytes && _lru.size() > 1)
+    {
+        _bytes -= _lru.back().bytes;
+        _entries.erase(_lru.back().key);
+        _lru.pop_back();
+    }
+}
+
+int ImageCache::GetImageCount(const std::string& filename, const std::string& fileKey)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _imageCounts.find(fileKey);
+        if (it != _imageCounts.end()) return it->second;
+    }
+
+    wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
+
+    // There seems to be a bug on linux where this function crashes occasionally
+#ifdef LINUX
+    logger_base.debug("About to count images in bitmap %s.", (const char *)filename.c_str());
+#endif
+    int imageCount = wxImage::GetImageCount(filename);
+    if (imageCount <= 0)
+    {
+        logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)filename.c_str(), imageCount);
+
+        // override it to 1
+        imageCount = 1;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _imageCounts[fileKey] = imageCount;
+    return imageCount;
+}
+
+int ImageCache::GetMovieFrameCount(const std::string& base, const std::string& extension)
+{
+    // adding or removing frames changes the folder's modification time
+    wxFileName fn(base);
+    std::string key = base + "|" + extension + "|" + GetFileKey(fn.GetPath().ToStdString());
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _movieFrameCounts.find(key);
+        if (it != _movieFrameCounts.end()) return it->second;
+    }
+
+    int frames = 1;
+    for (int frame = 1; frame <= 9999; frame++)
+    {
+        if (!wxFileExists(wxString::Format("%s-%d.%s", base.c_str(), frame, extension.c_str())))
+        {
+            break;
+        }
+        frames = frame;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _movieFrameCounts[key] = frames;
+    return frames;
+}
+
+std::shared_ptr<ImageCache::GIFDecoder> ImageCache::GetDecoder(const std::string& filename, const std::string& fileKey)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::string key = fileKey + "|gif";
+    Entry entry;
+    if (Find(key, entry)) return entry.decoder;
+
+#ifdef DEBUG_GIF
+    logger_base.debug("Preparing GIF file for reading: %s", (const char *)filename.c_str());
+#endif
+
+    wxLogNull logNo;
+    wxImage first;
+    if (!first.LoadFile(filename, wxBITMAP_TYPE_ANY, 0))
+    {
+        logger_base.error("Error loading image file: %s.", (const char *)filename.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<GIFDecoder> decoder = std::make_shared<GIFDecoder>();
+    decoder->size = first.GetSize();
+    decoder->gif.reset(new GIFImage(filename, decoder->size));
+    if (!decoder->gif->IsOk())
+    {
+        return nullptr;
+    }
+
+    entry.key = key;
+    entry.decoder = decoder;
+    entry.bytes = (size_t)decoder->size.x * decoder->size.y * 3 * GetImageCount(filename, fileKey);
+    Add(entry);
+    return decoder;
+}
+
+int ImageCache::GetFrameForTime(const std::string& filename, const std::string& fileKey, int msec, bool loop)
+{
+    std::shared_ptr<GIFDecoder> decoder = GetDecoder(filename, fileKey);
+    if (decoder == nullptr) return -1;
+
+    std::unique_lock<std::mutex> lock(decoder->lock);
+    return decoder->gif->CalcFrameForTime(msec, loop);
+}
+
+std::shared_ptr<const wxImage> ImageCache::LoadImage(const std::string& filename, const std::string& fileKey, int frame)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
+
+    if (GetImageCount(filename, fileKey) > 1)
+    {
+        std::shared_ptr<GIFDecoder> decoder = GetDecoder(filename, fileKey);
+        if (decoder == nullptr) return nullptr;
+
+        // past the end of the animation shows nothing
+        if (frame < 0) return std::make_shared<wxImage>(decoder->size);
+
+        // copy the frame so it shares nothing with the decoder's own images
+        std::unique_lock<std::mutex> lock(decoder->lock);
+        return std::make_shared<wxImage>(decoder->gif->GetFrame(frame).Copy());
+    }
+
+    std::shared_ptr<wxImage> image = std::make_shared<wxImage>();
+    if (!image->LoadFile(filename, wxBITMAP_TYPE_ANY, 0))
+    {
+        logger_base.error("Error loading image file: %s.", (const char *)filename.c_str());
+        image->Create(5, 5, true);
+    }
+    return image;
+}
+
+// every image is scaled with the default quality and any aspect ratio has already been applied by the caller to width and height
+// so the frame and size are all that distinguish one scaled copy from another
+std::shared_ptr<const wxImage> ImageCache::GetImage(const std::string& filename, const std::string& fileKey, int frame, int width, int height)
+{
+    std::string key = fileKey + "|" + std::to_string(frame) + "|" + std::to_string(width) + "x" + std::to_string(height);
+
+    Entry entry;
+    if (Find(key, entry))
+    {
+        ++_hits;
+        return entry.image;
+    }
+    ++_misses;
+
+    if (width == -1 || height == -1)
+    {
+        entry.image = LoadImage(filename, fileKey, frame);
+    }
+    else
+    {
+        std::shared_ptr<const wxImage> raw = GetImage(filename, fileKey, frame);
+        if (raw == nullptr || !raw->IsOk()) return raw;
+
+        // Scale returns a reference to the cached image if the size is unchanged so avoid it
+        if (raw->GetWidth() == width && raw->GetHeight() == height) return raw;
+
+        entry.image = std::make_shared<wxImage>(raw->Scale(width, height));
+    }
+
+    if (entry.image == nullptr) return nullptr;
+
+    entry.key = key;
+    entry.bytes = (size_t)entry.image->GetWidth() * entry.image->GetHeight() * (entry.image->HasAlpha() ? 4 : 3);
+    Add(entry);
+    return entry.image;
+}
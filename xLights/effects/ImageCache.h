@@ -0,0 +1,78 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <wx/image.h>
+
+class GIFImage;
+
+// Process wide cache of decoded pictures shared by every effect buffer that shows them.
+//
+// Images are keyed by file, modification time, frame and size so a picture used on many models is
+// only decoded and scaled once. wxImage reference counting is not thread safe so cached images are
+// never copied into another wxImage ... they are handed out as shared pointers to const images.
+// The least recently used images are dropped once the memory budget is used.
+class ImageCache
+{
+    // the decoder for an animated gif ... it builds each frame from the one before it
+    struct GIFDecoder
+    {
+        std::mutex lock;
+        std::unique_ptr<GIFImage> gif;
+        wxSize size;
+    };
+
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const wxImage> image;
+        std::shared_ptr<GIFDecoder> decoder;
+        size_t bytes;
+    };
+
+    std::mutex _lock;
+    std::list<Entry> _lru; // most recently used at the front
+    std::map<std::string, std::list<Entry>::iterator> _entries;
+    std::map<std::string, int> _imageCounts;
+    std::map<std::string, int> _movieFrameCounts;
+    size_t _bytes;
+    size_t _maxBytes;
+    std::atomic_ulong _hits;
+    std::atomic_ulong _misses;
+
+    ImageCache();
+
+    bool Find(const std::string& key, Entry& entry);
+    void Add(const Entry& entry);
+    std::shared_ptr<GIFDecoder> GetDecoder(const std::string& filename, const std::string& fileKey);
+    std::shared_ptr<const wxImage> LoadImage(const std::string& filename, const std::string& fileKey, int frame);
+
+public:
+    static ImageCache& GetCache();
+
+    void SetMaxMemoryMB(int mb);
+    void Purge();
+    // logs and then resets the hit and miss counts
+    void LogStats();
+
+    // the file name and modification time so a changed file is never mistaken for the old one.
+    // This reads the file's details so get it once when the effect is set up and pass it to the calls below.
+    static std::string GetFileKey(const std::string& filename);
+
+    // the number of frames in the picture, 1 for anything but an animated picture
+    int GetImageCount(const std::string& filename, const std::string& fileKey);
+    // the highest N where base-N.extension exists counting up from 1 ... for pictures extracted from a movie
+    int GetMovieFrameCount(const std::string& base, const std::string& extension);
+    // the frame of an animated gif to show msec into it, -1 if it has finished
+    int GetFrameForTime(const std::string& filename, const std::string& fileKey, int msec, bool loop);
+
+    // a frame of the picture scaled to width x height, at its own size if they are -1. Null if it could not be loaded.
+    std::shared_ptr<const wxImage> GetImage(const std::string& filename, const std::string& fileKey, int frame, int width = -1, int height = -1);
+};
+
+#endif
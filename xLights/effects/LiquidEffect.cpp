@@ -516,10 +516,10 @@ void LiquidEffect::Step(b2World* world, RenderBuffer &buffer, bool enabled[], in
         float audioLevel = 0.0001f;
         if (buffer.GetMedia() != nullptr)
         {
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf.IsValid())
             {
-                audioLevel = *pf->begin();
+                audioLevel = pf[0];
             }
         }
 
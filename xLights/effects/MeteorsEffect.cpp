@@ -171,10 +171,10 @@ void MeteorsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffe
     {
         if (buffer.GetMedia() != nullptr) {
             float f = 0.0;
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (pf.IsValid())
             {
-                f = *pf->begin();
+                f = pf[0];
             }
             Count = (float)Count * f;
         }
@@ -345,19 +345,14 @@ void MusicEffect::CreateEvents(RenderBuffer& buffer, std::vector<std::list<Music
     // go through each frame and extract the data i need
     for (int f = buffer.curEffStartPer; f <= buffer.curEffEndPer; f++)
     {
-        std::list<float>* pdata = buffer.GetMedia()->GetFrameData(f, FRAMEDATATYPE::FRAMEDATA_VU, "");
+        AudioFrameData pdata = buffer.GetMedia()->GetFrameData(f, FRAMEDATATYPE::FRAMEDATA_VU, "");
 
-        if (pdata != nullptr)
+        if (pdata.IsValid())
         {
-            auto pn = pdata->begin();
-
             // skip to start note
-            for (int i = 0; i < startNote; i++)
-            {
-                ++pn;
-            }
+            const float* pn = pdata.begin() + std::min((size_t)startNote, pdata.size());
 
-            for (int b = 0; b < bars && pn != pdata->end(); b++)
+            for (int b = 0; b < bars && pn != pdata.end(); b++)
             {
                 float val = 0.0;
                 for (auto n = 0; n < static_cast<int>(notesperbar); n++)
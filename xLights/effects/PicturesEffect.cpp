@@ -11,7 +11,7 @@
 #include "../models/Model.h"
 #include "../UtilFunctions.h"
 #include <log4cpp/Category.hh>
-#include "GIFImage.h"
+#include "ImageCache.h"
 
 #include <wx/regex.h>
 #include <wx/tokenzr.h>
@@ -219,22 +219,15 @@ typedef std::vector< std::pair<wxPoint, xlColor> > PixelVector;
 
 class PicturesRenderCache : public EffectRenderCache {
 public:
-    PicturesRenderCache() : imageCount(0), frame(0),  gifImage(nullptr), maxmovieframes(0) {};
-    virtual ~PicturesRenderCache()
-    {
-        if (gifImage != nullptr) {
-            delete gifImage;
-            gifImage = nullptr;
-        }
-    };
+    PicturesRenderCache() : imageCount(0), frame(0), maxmovieframes(0) {};
+    virtual ~PicturesRenderCache() {};
 
-    wxImage image;
-    wxImage rawimage;
+    // the decoded pictures are shared by all buffers in the ImageCache
     int imageCount;
     int frame;
     int maxmovieframes;
     wxString PictureName;
-    GIFImage* gifImage;
+    std::string fileKey; // looked up when the picture changes so the file is not checked every frame
     std::vector<PixelVector> PixelsByFrame;
 };
 
@@ -265,13 +258,8 @@ void PicturesEffect::LoadPixelsFromTextFile(RenderBuffer &buffer, wxFile& debug,
     wxByte rgb[3] = { 0,0,0 };
     PicturesRenderCache *cache = GetCache(buffer);
     cache->imageCount = 0;
-    wxImage &image = cache->image;
-    wxImage &rawimage = cache->rawimage;
     std::vector<PixelVector> &PixelsByFrame = cache->PixelsByFrame;
 
-    if (image.GetWidth() && image.GetHeight()) image.Clear(); //CAUTION: image must be non-empty to clear it (memory error otherwise)
-    if (rawimage.GetWidth() && rawimage.GetHeight()) rawimage.Clear(); //CAUTION: image must be non-empty to clear it (memory error otherwise)
-
     if (!cache->PictureName.CmpNoCase(filename)) { wrdebug("no change: " + filename); return; }
     if (!wxFileExists(filename)) { wrdebug("not found: " + filename); return; }
     wxTextFile f;
@@ -413,8 +401,6 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     int start_scale, int end_scale, const std::string& scale_to_fit,
     bool pixelOffsets, bool wrap_x, bool shimmer, bool loopGIF) {
 
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
     int dir = GetPicturesDirection(dirstr);
     double position = buffer.GetEffectTimeIntervalPosition(movementSpeed);
 
@@ -422,7 +408,6 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     int BufferHt = buffer.BufferHt;
     int curPeriod = buffer.curPeriod;
     int curEffStartPer = buffer.curEffStartPer;
-    int scale_image = false;
 
     wxFile f;
     if (NewPictureName2.length() == 0) return;
@@ -436,9 +421,7 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     //      ffmpeg -i XXXX.mts -s 16x50 XXXX-%d.jpg
 
     PicturesRenderCache *cache = GetCache(buffer);
-    wxImage &image = cache->image;
-    wxImage &rawimage = cache->rawimage;
-    GIFImage*& gifImage = cache->gifImage;
+    ImageCache& imageCache = ImageCache::GetCache();
     std::vector<PixelVector> &PixelsByFrame = cache->PixelsByFrame;
     int &frame = cache->frame;
 
@@ -457,20 +440,9 @@ void PicturesEffect::Render(RenderBuffer &buffer,
         {
 
             //  build the next filename. the frame counter is incrementing through all frames
-            if (buffer.needToInit) { // only once, try 10000 files to find how high is frame count
+            if (buffer.needToInit) { // only once, find how high the frame count is
                 buffer.needToInit = false;
-                cache->maxmovieframes = 1;
-                sPicture = wxString::Format("%s-%d.%s", BasePicture, frame, extension);
-                for (frame = 1; frame <= 9999; frame++)
-                {
-                    sPicture = wxString::Format("%s-%d.%s", BasePicture, frame, extension);
-                    if (wxFileExists(sPicture)) {
-                        cache->maxmovieframes = frame;
-                    }
-                    else {
-                        break;
-                    }
-                }
+                cache->maxmovieframes = imageCache.GetMovieFrameCount(BasePicture.ToStdString(), extension.ToStdString());
                 frame = 1;
             }
             else {
@@ -500,128 +472,64 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     if (NewPictureName != cache->PictureName || buffer.needToInit)
     {
         buffer.needToInit = false;
-        scale_image = true;
-
-        wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
-
-        // There seems to be a bug on linux where this function crashes occasionally
-#ifdef LINUX
-        logger_base.debug("About to count images in bitmap %s.", (const char *)NewPictureName.c_str());
-#endif
-        cache->imageCount = wxImage::GetImageCount(NewPictureName);
-        if (cache->imageCount <= 0)
-        {
-            logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)NewPictureName.c_str(), cache->imageCount);
-
-            // override it to 1
-            cache->imageCount = 1;
-        }
-
-        if (!image.LoadFile(NewPictureName, wxBITMAP_TYPE_ANY, 0))
-        {
-            logger_base.error("Error loading image file: %s.", (const char *)NewPictureName.c_str());
-            image.Create(5, 5, true);
-        }
-
-        rawimage = image;
+        cache->fileKey = ImageCache::GetFileKey(NewPictureName.ToStdString());
+        cache->imageCount = imageCache.GetImageCount(NewPictureName.ToStdString(), cache->fileKey);
         cache->PictureName = NewPictureName;
-
-        if (cache->imageCount > 1)
-        {
-#ifdef DEBUG_GIF
-            logger_base.debug("Preparing GIF file for reading: %s", (const char *)NewPictureName.c_str());
-#endif
-            if (gifImage != nullptr && gifImage->GetFilename() != NewPictureName)
-            {
-                delete gifImage;
-                gifImage = nullptr;
-            }
-            gifImage = new GIFImage(NewPictureName.ToStdString(), image.GetSize());
-
-            if (!gifImage->IsOk())
-            {
-                delete gifImage;
-                gifImage = nullptr;
-                return;
-            }
-
-            image = gifImage->GetFrame(0);
-            rawimage = image;
-        }
-
-        if (!image.IsOk())
-            return;
     }
 
+    int imageFrame = 0;
     if (cache->imageCount > 1) {
 
         //animated Gif,
-        scale_image = true;
-
         if (loopGIF)
         {
-            image = gifImage->GetFrameForTime((buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
+            imageFrame = imageCache.GetFrameForTime(NewPictureName.ToStdString(), cache->fileKey, (buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
         }
         else
         {
-            int ii = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
-            image = gifImage->GetFrame(ii);
+            imageFrame = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
         }
-
-        rawimage = image;
-
-        if (!rawimage.IsOk())
-            return;
     }
 
-    if (scale_to_fit == "No Scaling" && (start_scale != end_scale))
-    {
-        image = rawimage;
-        scale_image = true;
-    }
+    std::shared_ptr<const wxImage> rawimage = imageCache.GetImage(NewPictureName.ToStdString(), cache->fileKey, imageFrame);
+    if (rawimage == nullptr || !rawimage->IsOk())
+        return;
 
-    int imgwidth = image.GetWidth();
-    int imght = image.GetHeight();
-    int yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-    int xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+    int imgwidth = rawimage->GetWidth();
+    int imght = rawimage->GetHeight();
 
-    if (scale_to_fit == "Scale To Fit" && (BufferWi != imgwidth || BufferHt != imght))
+    if (scale_to_fit == "Scale To Fit")
     {
-        image = rawimage;
-        image.Rescale(BufferWi, BufferHt);
-        imgwidth = image.GetWidth();
-        imght = image.GetHeight();
-        yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-        xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+        imgwidth = BufferWi;
+        imght = BufferHt;
     }
     else if (scale_to_fit == "Scale Keep Aspect Ratio")
     {
-        image = rawimage;
-        float xr = (float)BufferWi / (float)image.GetWidth();
-        float yr = (float)BufferHt / (float)image.GetHeight();
+        float xr = (float)BufferWi / (float)imgwidth;
+        float yr = (float)BufferHt / (float)imght;
         float sc = std::min(xr, yr);
-        image.Rescale(image.GetWidth() * sc, image.GetHeight() * sc);
-        imgwidth = image.GetWidth();
-        imght = image.GetHeight();
-        yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-        xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+        imgwidth = std::max((int)(imgwidth * sc), 1);
+        imght = std::max((int)(imght * sc), 1);
     }
-    else
+    else if (start_scale != 100 || end_scale != 100)
     {
-        if ((start_scale != 100 || end_scale != 100) && scale_image)
-        {
-            int delta_scale = end_scale - start_scale;
-            int current_scale = start_scale + delta_scale * position;
-            imgwidth = (image.GetWidth()*current_scale) / 100;
-            imght = (image.GetHeight()*current_scale) / 100;
-            imgwidth = std::max(imgwidth, 1);
-            imght = std::max(imght, 1);
-            image.Rescale(imgwidth, imght);
-            yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-            xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
-        }
+        int delta_scale = end_scale - start_scale;
+        int current_scale = start_scale + delta_scale * position;
+        imgwidth = (imgwidth*current_scale) / 100;
+        imght = (imght*current_scale) / 100;
+        imgwidth = std::max(imgwidth, 1);
+        imght = std::max(imght, 1);
     }
 
+    // the cached image is shared with other threads so it must only be read
+    std::shared_ptr<const wxImage> scaledimage = imageCache.GetImage(NewPictureName.ToStdString(), cache->fileKey, imageFrame, imgwidth, imght);
+    if (scaledimage == nullptr || !scaledimage->IsOk())
+        return;
+    const wxImage& image = *scaledimage;
+
+    int yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
+    int xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+
     int waveX = 0;
     int waveW = 0;
     int waveN = 0; //location of first wave, height adjust, width, wave# -DJ
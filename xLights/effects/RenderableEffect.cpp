@@ -792,6 +792,20 @@ void RenderableEffect::SetRadioValue(wxRadioButton *r) {
     r->ProcessWindowEvent(evt);
 }
 
+bool RenderableEffect::CanCacheRender(Effect *effect, const SettingsMap &settings)
+{
+    // effects driven by a timing track change when the track does so they cant be cached
+    for (auto it = settings.begin(); it != settings.end(); ++it)
+    {
+        if ((it->first.find("Timing") != std::string::npos || it->first.find("TIMING") != std::string::npos || it->first.find("MIDITrack") != std::string::npos) &&
+            it->second != "" && it->second != "0")
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 double RenderableEffect::GetValueCurveDouble(const std::string &name, double def, SettingsMap &SettingsMap, float offset, double min, double max, int divisor)
 {
     double res = def;
@@ -809,7 +823,18 @@ double RenderableEffect::GetValueCurveDouble(const std::string &name, double def
         res = SettingsMap.GetDouble(tn, def);
     }
 
-    wxString vn = "VALUECURVE_" + name;
+    const std::string vn = "VALUECURVE_" + name;
+    CompiledValueCurve* cvc = SettingsMap.GetCompiledValueCurve(vn);
+    if (cvc != nullptr && cvc->divided && cvc->min == (float)min && cvc->max == (float)max && cvc->divisor == divisor)
+    {
+        // already parsed for this render
+        if (cvc->curve->IsActive())
+        {
+            res = cvc->curve->GetOutputValueAtDivided(offset);
+        }
+        return res;
+    }
+
     wxString vc = SettingsMap.Get(vn, "");
     if (vc != "")
     {
@@ -835,6 +860,8 @@ double RenderableEffect::GetValueCurveDouble(const std::string &name, double def
                 SettingsMap[vn] = valc.Serialise();
             }
         }
+
+        CacheValueCurve(SettingsMap, vn, valc, min, max, divisor, true);
     }
 
     return res;
@@ -857,6 +884,17 @@ int RenderableEffect::GetValueCurveInt(const std::string &name, int def, Setting
     }
 
     const std::string vn = "VALUECURVE_" + name;
+    CompiledValueCurve* cvc = SettingsMap.GetCompiledValueCurve(vn);
+    if (cvc != nullptr && !cvc->divided && cvc->min == (float)min && cvc->max == (float)max && cvc->divisor == divisor)
+    {
+        // already parsed for this render
+        if (cvc->curve->IsActive())
+        {
+            res = cvc->curve->GetOutputValueAt(offset);
+        }
+        return res;
+    }
+
     if (SettingsMap.Contains(vn))
     {
         wxString vc = SettingsMap.Get(vn, "");
@@ -884,7 +922,24 @@ int RenderableEffect::GetValueCurveInt(const std::string &name, int def, Setting
                 SettingsMap[vn] = valc.Serialise();
             }
         }
+
+        CacheValueCurve(SettingsMap, vn, valc, min, max, divisor, false);
     }
 
     return res;
+}
+
+// Keeps the parsed curve with the compiled settings so later frames of the same render skip the parse
+void RenderableEffect::CacheValueCurve(SettingsMap &SettingsMap, const std::string &vn, const ValueCurve &valc, float min, float max, int divisor, bool divided)
+{
+    if (!SettingsMap.IsCompiled()) return;
+
+    CompiledValueCurve cvc;
+    cvc.curve = std::make_shared<ValueCurve>(valc);
+    cvc.curve->Bake();
+    cvc.min = min;
+    cvc.max = max;
+    cvc.divisor = divisor;
+    cvc.divided = divided;
+    SettingsMap.SetCompiledValueCurve(vn, cvc);
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ class Model;
 class SequenceElements;
 class Effect;
 class SettingsMap;
+class ValueCurve;
 class RenderBuffer;
 class wxSlider;
 class wxCheckBox;
@@ -53,6 +54,8 @@ class RenderableEffect
 
         //Methods for rendering the effect
         virtual bool CanRenderOnBackgroundThread(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) { return true; }
+        // false if the output depends on more than the effect's own settings, palette, time and media ... eg timing tracks
+        virtual bool CanCacheRender(Effect *effect, const SettingsMap &settings);
         virtual void Render(Effect *effect, SettingsMap &settings, RenderBuffer &buffer) = 0;
         virtual void RenameTimingTrack(std::string oldname, std::string newname, Effect *effect) { }
         virtual std::list<std::string> CheckEffectSettings(const SettingsMap& settings, AudioManager* media, Model* model, Effect* eff) { std::list<std::string> res; return res; };
@@ -81,6 +84,7 @@ class RenderableEffect
 
         double GetValueCurveDouble(const std::string & name, double def, SettingsMap &SettingsMap, float offset, double min, double max, int divisor = 1);
         int GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, int divisor = 1);
+        static void CacheValueCurve(SettingsMap &SettingsMap, const std::string &vn, const ValueCurve &valc, float min, float max, int divisor, bool divided);
         bool IsVersionOlder(const std::string& compare, const std::string& version);
         void AdjustSettingsToBeFitToTime(int effectIdx, SettingsMap &settings, int startMS, int endMS, xlColorVector &colors);
         virtual void RemoveDefaults(const std::string &version, Effect *effect);
@@ -815,10 +815,10 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
             float f = 0.1f;
             if (buffer.GetMedia() != nullptr)
             {
-                std::list<float>* p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                if (p != nullptr)
+                AudioFrameData p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                if (p.IsValid())
                 {
-                    f = *p->begin();
+                    f = p[0];
                 }
             }
 
@@ -845,10 +845,10 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
             float f = 0.1f;
             if (buffer.GetMedia() != nullptr)
             {
-                std::list<float>* p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                if (p != nullptr)
+                AudioFrameData p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                if (p.IsValid())
                 {
-                    f = *p->begin();
+                    f = p[0];
                 }
             }
 
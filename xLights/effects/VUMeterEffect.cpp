@@ -225,9 +225,9 @@ public:
     virtual ~VUMeterRenderCache() {};
 	std::list<int> _timingmarks; // collection of recent timing marks ... used for sweep
 	int _lasttimingmark; // last time we saw a timing mark ... used for pulse
-	std::list<float> _lastvalues;
-	std::list<float> _lastpeaks;
-    std::list<int> _pausepeakfall;
+	std::vector<float> _lastvalues;
+	std::vector<float> _lastpeaks;
+    std::vector<int> _pausepeakfall;
 	float _lastsize;
     int _colourindex;
 };
@@ -441,9 +441,9 @@ void VUMeterEffect::Render(RenderBuffer &buffer, SequenceElements *elements, int
 	}
 	std::list<int>& _timingmarks = cache->_timingmarks;
 	int &_lasttimingmark = cache->_lasttimingmark;
-	std::list<float>& _lastvalues = cache->_lastvalues;
-	std::list<float>& _lastpeaks = cache->_lastpeaks;
-	std::list<int>& _pausepeakfall = cache->_pausepeakfall;
+	std::vector<float>& _lastvalues = cache->_lastvalues;
+	std::vector<float>& _lastpeaks = cache->_lastpeaks;
+	std::vector<int>& _pausepeakfall = cache->_pausepeakfall;
 	float& _lastsize = cache->_lastsize;
     int & _colourindex = cache->_colourindex;
 
@@ -567,21 +567,21 @@ void VUMeterEffect::Render(RenderBuffer &buffer, SequenceElements *elements, int
 	}
 }
 
-void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, std::list<float>& lastvalues, std::list<float>& lastpeaks, std::list<int>& pauseuntilpeakfall, bool slowdownfalls, int startNote, int endNote, int xoffset, bool peak, int peakhold)
+void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, std::vector<float>& lastvalues, std::vector<float>& lastpeaks, std::vector<int>& pauseuntilpeakfall, bool slowdownfalls, int startNote, int endNote, int xoffset, bool peak, int peakhold)
 {
     if (buffer.GetMedia() == nullptr) return;
 
     int truexoffset = xoffset * buffer.BufferWi / 100;
-	std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+	AudioFrameData pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-	if (pdata != nullptr && pdata->size() != 0)
+	if (pdata.IsValid() && pdata.size() != 0)
 	{
         if (peak)
         {
             if (lastvalues.size() == 0)
             {
-                lastvalues = *pdata;
-                lastpeaks = *pdata;
+                lastvalues.assign(pdata.begin(), pdata.end());
+                lastpeaks.assign(pdata.begin(), pdata.end());
                 for (auto it = lastvalues.begin(); it != lastvalues.end(); ++it)
                 {
                     pauseuntilpeakfall.push_back(0);
@@ -589,8 +589,8 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
             }
             else
             {
-                std::list<float>::iterator newdata = pdata->begin();
-                std::list<float>::iterator olddata = lastpeaks.begin();
+                const float* newdata = pdata.begin();
+                std::vector<float>::iterator olddata = lastpeaks.begin();
                 auto pause = pauseuntilpeakfall.begin();
 
                 while (olddata != lastpeaks.end())
@@ -624,12 +624,12 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		{
 			if (lastvalues.size() == 0)
 			{
-				lastvalues = *pdata;
+				lastvalues.assign(pdata.begin(), pdata.end());
 			}
 			else
 			{
-				std::list<float>::iterator newdata = pdata->begin();
-				std::list<float>::iterator olddata = lastvalues.begin();
+				const float* newdata = pdata.begin();
+				std::vector<float>::iterator olddata = lastvalues.begin();
 
 				while (olddata != lastvalues.end())
 				{
@@ -653,10 +653,10 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		}
 		else
 		{
-			lastvalues = *pdata;
+			lastvalues.assign(pdata.begin(), pdata.end());
 		}
 
-        int datapoints = std::min((int)pdata->size(), endNote - startNote + 1);
+        int datapoints = std::min((int)pdata.size(), endNote - startNote + 1);
 
 		if (usebars > datapoints)
 		{
@@ -673,8 +673,8 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
         {
             cols = 1;
         }
-		std::list<float>::iterator it = lastvalues.begin();
-		std::list<float>::iterator itpeak = lastpeaks.begin();
+		std::vector<float>::iterator it = lastvalues.begin();
+		std::vector<float>::iterator itpeak = lastpeaks.begin();
 
         // skip to our start note
         for (int i = 0; i < startNote; i++)
@@ -773,10 +773,10 @@ void VUMeterEffect::RenderVolumeBarsFrame(RenderBuffer &buffer, int usebars)
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			AudioFrameData pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (pf.IsValid())
 			{
-				f = *pf->begin();
+				f = pf[0];
 			}
 			for (int j = 0; j < cols; j++)
 			{
@@ -811,16 +811,16 @@ void VUMeterEffect::RenderWaveformFrame(RenderBuffer &buffer, int usebars, int y
 		if (start + i >= 0)
 		{
 			float fh = 0.0;
-			std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			AudioFrameData pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (pf.IsValid())
 			{
-				fh = *pf->begin();
+				fh = pf[0];
 			}
 			float fl = 0.0;
 			pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_LOW, "");
-			if (pf != nullptr)
+			if (pf.IsValid())
 			{
-				fl = *pf->begin();
+				fl = pf[0];
 			}
 			int s = (1.0 - fl) * buffer.BufferHt / 2;
 			int e = (1.0 + fh) * buffer.BufferHt / 2;
@@ -971,10 +971,10 @@ void VUMeterEffect::RenderOnFrame(RenderBuffer& buffer)
     if (buffer.GetMedia() == nullptr) return;
    
     float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf.IsValid())
 	{
-		f = *pf->begin();
+		f = pf[0];
 	}
 	xlColor color1;
 	buffer.palette.GetColor(0, color1);
@@ -994,10 +994,10 @@ void VUMeterEffect::RenderOnColourFrame(RenderBuffer& buffer)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf.IsValid())
     {
-        f = *pf->begin();
+        f = pf[0];
     }
 
     xlColor color1;
@@ -1087,10 +1087,10 @@ void VUMeterEffect::RenderIntensityWaveFrame(RenderBuffer &buffer, int usebars)
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			AudioFrameData pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (pf.IsValid())
 			{
-				f = *pf->begin();
+				f = pf[0];
 			}
 			xlColor color1;
 			if (buffer.palette.Size() < 2)
@@ -1123,10 +1123,10 @@ void VUMeterEffect::RenderLevelPulseFrame(RenderBuffer &buffer, int fadeframes,
     if (buffer.GetMedia() == nullptr) return;
     
     float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf.IsValid())
 	{
-		f = *pf->begin();
+		f = pf[0];
 	}
 
 	if (f > (float)sensitivity / 100.0)
@@ -1164,10 +1164,10 @@ void VUMeterEffect::RenderLevelPulseColourFrame(RenderBuffer &buffer, int fadefr
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf.IsValid())
     {
-        f = *pf->begin();
+        f = pf[0];
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1214,10 +1214,10 @@ void VUMeterEffect::RenderLevelColourFrame(RenderBuffer &buffer, int& colourinde
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (pf.IsValid())
     {
-        f = *pf->begin();
+        f = pf[0];
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1657,10 +1657,10 @@ void VUMeterEffect::RenderLevelShapeFrame(RenderBuffer& buffer, const std::strin
     float scaling = (float)scale / 100.0 * 7.0;
 
 	float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (pf.IsValid())
 	{
-		f = *pf->begin();
+		f = pf[0];
 	}
 
 	int centerx = (buffer.BufferWi / 2.0) + truexoffset;
@@ -1949,10 +1949,10 @@ void VUMeterEffect::RenderTimingEventJumpFrame(RenderBuffer &buffer, int fallfra
                 if (useAudioLevel)
                 {
                     float f = 0.0;
-                    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                    if (pf != nullptr)
+                    AudioFrameData pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                    if (pf.IsValid())
                     {
-                        f = *pf->begin();
+                        f = pf[0];
                     }
                     lastsize = f;
                 }
@@ -2156,13 +2156,13 @@ void VUMeterEffect::RenderNoteOnFrame(RenderBuffer& buffer, int startNote, int e
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata.IsValid() && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (auto it = pdata->begin(); it != pdata->end(); it++)
+        for (auto it = pdata.begin(); it != pdata.end(); it++)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2189,13 +2189,13 @@ void VUMeterEffect::RenderNoteLevelPulseFrame(RenderBuffer& buffer, int fadefram
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata.IsValid() && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (auto it = pdata->begin(); it != pdata->end(); it++)
+        for (auto it = pdata.begin(); it != pdata.end(); it++)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2239,11 +2239,11 @@ void VUMeterEffect::RenderLevelBarFrame(RenderBuffer &buffer, int bars, int sens
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    AudioFrameData pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata.IsValid() && pdata.size() != 0)
     {
-        float level = pdata->front();
+        float level = pdata.front();
 
         xlColor color1;
         if (level > (float)sensitivity / 100.0)
@@ -2372,13 +2372,13 @@ void VUMeterEffect::RenderNoteLevelBarFrame(RenderBuffer &buffer, int bars, int
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    AudioFrameData pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (pdata.IsValid() && pdata.size() != 0)
     {
         int i = 0;
         float level = 0.0;
-        for (auto it = pdata->begin(); it != pdata->end(); it++)
+        for (auto it = pdata.begin(); it != pdata.end(); it++)
         {
             if (i > startNote && i <= endNote)
             {
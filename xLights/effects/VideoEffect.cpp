@@ -1,5 +1,7 @@
 #include "VideoEffect.h"
 #include "VideoPanel.h"
+#include "VideoFrameCache.h"
+#include "ImageCache.h"
 #include "../VideoReader.h"
 
 #include "../sequencer/Effect.h"
@@ -172,22 +174,26 @@ public:
     VideoRenderCache()
 	{
 		_videoframerate = -1;
-		_videoreader = nullptr;
         _loops = 0;
         _frameMS = 50;
+        _lengthMS = 0;
+        _videoWidth = 0;
+        _videoHeight = 0;
+        _width = 0;
+        _height = 0;
 	};
-    virtual ~VideoRenderCache() {
-		if (_videoreader != nullptr)
-		{
-			delete _videoreader;
-			_videoreader = nullptr;
-		}
-	};
+    virtual ~VideoRenderCache() {};
 
-    VideoReader* _videoreader;
+    // the readers and decoded frames are shared by all buffers in the VideoFrameCache
 	int _videoframerate;
 	int _loops;
     int _frameMS;
+    int _lengthMS; // 0 if the video could not be opened
+    int _videoWidth;
+    int _videoHeight;
+    int _width;
+    int _height;
+    std::string _fileKey; // worked out when the video is opened so the cache does not stat the file every frame
 };
 
 void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
@@ -239,8 +245,9 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
 	}
 
 	int &_loops = cache->_loops;
-	VideoReader* &_videoreader = cache->_videoreader;
     int& _frameMS = cache->_frameMS;
+    int& _lengthMS = cache->_lengthMS;
+    VideoFrameCache& videoCache = VideoFrameCache::GetCache();
 
     if (synchroniseAudio)
     {
@@ -260,11 +267,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
 
 		_loops = 0;
         _frameMS = buffer.frameTimeInMs;
-		if (_videoreader != nullptr)
-		{
-			delete _videoreader;
-			_videoreader = nullptr;
-		}
+        _lengthMS = 0;
 
         if (buffer.BufferHt == 1)
         {
@@ -273,18 +276,18 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         else if (wxFileExists(filename))
 		{
 			// have to open the file
-            int width = buffer.BufferWi * 100 / (cropRight - cropLeft);
-            int height = buffer.BufferHt * 100 / (cropTop - cropBottom);
-			_videoreader = new VideoReader(filename, width, height, aspectratio);
-
-            if (_videoreader == nullptr)
+            cache->_width = buffer.BufferWi * 100 / (cropRight - cropLeft);
+            cache->_height = buffer.BufferHt * 100 / (cropTop - cropBottom);
+            cache->_fileKey = ImageCache::GetFileKey(filename);
+            if (!videoCache.GetVideoInfo(filename, cache->_fileKey, cache->_width, cache->_height, aspectratio, _lengthMS, cache->_videoWidth, cache->_videoHeight))
             {
                 logger_base.warn("VideoEffect: Failed to load video file %s.", (const char *)filename.c_str());
+                _lengthMS = 0;
             }
             else
             {
                 // extract the video length
-                int videolen = _videoreader->GetLengthMS();
+                int videolen = _lengthMS;
 
                 if (videolen == 0)
                 {
@@ -301,11 +304,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
                     //fp->addVideoTime(filename, videolen);
                 }
 
-                if (starttime != 0)
-                {
-                    logger_base.debug("Video effect initialising ... seeking to start location for the video %f.", (float)starttime);
-                    _videoreader->Seek(starttime * 1000);
-                }
+                // the cache seeks to the start location when the first frame is asked for
 
                 if (durationTreatment == "Slow/Accelerate")
                 {
@@ -328,61 +327,46 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         }
 	}
 
-	if (_videoreader != nullptr && _videoreader->GetLengthMS() > 0)
+	if (_lengthMS > 0)
 	{
-        long frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+        long frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_lengthMS + _frameMS);
 
 	    // get the image for the current frame
-        AVFrame* image = _videoreader->GetNextFrame(frame);
+        std::shared_ptr<const VideoFrameCache::Frame> image = videoCache.GetFrame(filename, cache->_fileKey, cache->_width, cache->_height, aspectratio, frame,
+            cropLeft, cropRight, cropTop, cropBottom);
 		
 		// if we have reached the end and we are to loop
-		if (_videoreader->AtEnd() && durationTreatment == "Loop")
+		if (image == nullptr && durationTreatment == "Loop")
 		{
             // jump back to start and try to read frame again
             _loops++;
-            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_lengthMS + _frameMS);
             if (frame < 0)
             {
                 frame = 0;
             }
             logger_base.debug("Video effect loop #%d at frame %d to video frame %d.", _loops, buffer.curPeriod - buffer.curEffStartPer, frame);
 
-            _videoreader->Seek(0);
-			image = _videoreader->GetNextFrame(frame);
+			image = videoCache.GetFrame(filename, cache->_fileKey, cache->_width, cache->_height, aspectratio, frame,
+                cropLeft, cropRight, cropTop, cropBottom);
 		}
 
-        int xoffset = cropLeft * _videoreader->GetWidth() / 100;
-        int yoffset = cropBottom * _videoreader->GetHeight() / 100;
-        int xtail = (100 - cropRight) * _videoreader->GetWidth() / 100;
-        int ytail = (100 - cropTop) * _videoreader->GetHeight() / 100;
-        int startx = (buffer.BufferWi - _videoreader->GetWidth() * (cropRight - cropLeft) / 100) / 2;
-		int starty = (buffer.BufferHt - _videoreader->GetHeight() * (cropTop - cropBottom) / 100) / 2;
-
-        //wxASSERT(xoffset + xtail + buffer.BufferWi == _videoreader->GetWidth());
-        //wxASSERT(yoffset + ytail + buffer.BufferHt == _videoreader->GetHeight());
+        int startx = (buffer.BufferWi - cache->_videoWidth * (cropRight - cropLeft) / 100) / 2;
+		int starty = (buffer.BufferHt - cache->_videoHeight * (cropTop - cropBottom) / 100) / 2;
 
 		// check it looks valid
 		if (image != nullptr)
 		{
 			// draw the image
 			xlColor c;
-			for (int y = 0; y < _videoreader->GetHeight() - yoffset - ytail; y++)
+            const uint8_t* ptr = image->pixels.data();
+			for (int y = 0; y < image->height; y++)
 			{
-                uint8_t* ptr = image->data[0] + (_videoreader->GetHeight() - 1 - y - yoffset) * _videoreader->GetWidth() * 3 + xoffset * 3;
-
-				for (int x = 0; x < _videoreader->GetWidth() - xoffset - xtail; x++)
+				for (int x = 0; x < image->width; x++)
 				{
-					try
-					{
-						c.Set(*(ptr),
-							  *(ptr + 1),
-							  *(ptr + 2), 255);
-					}
-					catch (...)
-					{
-						// this shouldnt happen so make it stand out
-						c = xlRED;
-					}
+					c.Set(*(ptr),
+						  *(ptr + 1),
+						  *(ptr + 2), 255);
 					buffer.SetPixel(x + startx, y + starty, c);
 
                     ptr += 3;
@@ -0,0 +1,237 @@
+#include "VideoFrameCache.h"
+#include "../VideoReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <log4cpp/Category.hh>
+
+#define VIDEOCACHE_DEFAULT_MB 256
+// how far a reader will decode forward to reach a frame rather than seeking to it
+#define VIDEOCACHE_READAHEAD_MS 2000
+#define VIDEOCACHE_READERS_PER_CLIP 4
+#define VIDEOCACHE_MAX_READERS 16
+
+VideoFrameCache::VideoFrameCache() : _bytes(0), _maxBytes((size_t)VIDEOCACHE_DEFAULT_MB * 1024 * 1024), _hits(0), _misses(0), _readersOpened(0)
+{
+}
+
+VideoFrameCache& VideoFrameCache::GetCache()
+{
+    static VideoFrameCache cache;
+    return cache;
+}
+
+void VideoFrameCache::SetMaxMemoryMB(int mb)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _maxBytes = (size_t)std::max(mb, 1) * 1024 * 1024;
+}
+
+void VideoFrameCache::Purge()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _entries.clear();
+    _lru.clear();
+    _readers.clear();
+    _bytes = 0;
+    _hits = 0;
+    _misses = 0;
+    _readersOpened = 0;
+}
+
+void VideoFrameCache::LogStats()
+{
+    static log4cpp::Category &logger_render = log4cpp::Category::getInstance(std::string("log_render"));
+
+    std::unique_lock<std::mutex> lock(_lock);
+    logger_render.debug("Video frame cache: %lu hits, %lu misses, %d frames using %dMB of %dMB, %lu readers opened, %d open.",
+        (unsigned long)_hits, (unsigned long)_misses, (int)_entries.size(), (int)(_bytes / (1024 * 1024)), (int)(_maxBytes / (1024 * 1024)),
+        (unsigned long)_readersOpened, (int)_readers.size());
+
+    // each render reports its own counts
+    _hits = 0;
+    _misses = 0;
+    _readersOpened = 0;
+}
+
+bool VideoFrameCache::Find(const std::string& key, std::shared_ptr<const Frame>& frame)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) return false;
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+    frame = it->second->frame;
+    return true;
+}
+
+void VideoFrameCache::Add(const std::string& key, std::shared_ptr<const Frame> frame)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    if (_entries.find(key) != _entries.end()) return;
+
+    Entry entry;
+    entry.key = key;
+    entry.frame = frame;
+    entry.bytes = frame->pixels.size();
+    _lru.push_front(entry);
+    _entries[key] = _lru.begin();
+    _bytes += entry.bytes;
+
+    // anyone still using a dropped frame keeps it until they are done with it
+    while (_bytes > _maxBytes && _lru.size() > 1)
+    {
+        _bytes -= _lru.back().bytes;
+        _entries.erase(_lru.back().key);
+        _lru.pop_back();
+    }
+}
+
+// The reader for the clip at this size which is closest behind timestampMS. A new one is opened if none
+// is close enough unless the clip already has its share of readers. A timestamp of -1 takes any reader.
+std::shared_ptr<VideoFrameCache::Reader> VideoFrameCache::GetReader(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int timestampMS)
+{
+    std::string key = fileKey + "|" + std::to_string(width) + "x" + std::to_string(height) + (keepaspectratio ? "|aspect" : "");
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        auto best = _readers.end();
+        auto oldest = _readers.end();
+        int bestBehind = 0;
+        int count = 0;
+        for (auto it = _readers.begin(); it != _readers.end(); ++it)
+        {
+            if ((*it)->key != key) continue;
+
+            count++;
+            oldest = it;
+            if (timestampMS < 0)
+            {
+                best = it;
+                break;
+            }
+
+            // a reader nobody has used yet can go anywhere but one already close by is better
+            int behind = (*it)->timestamp < 0 ? VIDEOCACHE_READAHEAD_MS : timestampMS - (*it)->timestamp;
+            if (behind >= 0 && behind <= VIDEOCACHE_READAHEAD_MS && (best == _readers.end() || behind < bestBehind))
+            {
+                best = it;
+                bestBehind = behind;
+            }
+        }
+
+        if (best == _readers.end() && count >= VIDEOCACHE_READERS_PER_CLIP)
+        {
+            best = oldest;
+        }
+
+        if (best != _readers.end())
+        {
+            _readers.splice(_readers.begin(), _readers, best);
+            return _readers.front();
+        }
+    }
+
+    // opening a video can take a while so dont hold everyone else up while we do it
+    std::shared_ptr<Reader> reader = std::make_shared<Reader>();
+    reader->key = key;
+    reader->reader.reset(new VideoReader(filename, width, height, keepaspectratio));
+    reader->reader->EnablePrefetch(VIDEO_PREFETCH_FRAMES);
+    reader->timestamp = -1;
+    reader->frame = nullptr;
+    ++_readersOpened;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _readers.push_front(reader);
+
+    // a reader someone is still using stays open until they are done with it
+    while (_readers.size() > VIDEOCACHE_MAX_READERS)
+    {
+        _readers.pop_back();
+    }
+    return reader;
+}
+
+bool VideoFrameCache::GetVideoInfo(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int& lengthMS, int& videoWidth, int& videoHeight)
+{
+    std::shared_ptr<Reader> reader = GetReader(filename, fileKey, width, height, keepaspectratio, -1);
+
+    // these dont change once the reader is open so there is no need to wait for whoever is using it
+    lengthMS = reader->reader->GetLengthMS();
+    videoWidth = reader->reader->GetWidth();
+    videoHeight = reader->reader->GetHeight();
+    return reader->reader->IsValid();
+}
+
+std::shared_ptr<const VideoFrameCache::Frame> VideoFrameCache::GetFrame(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int timestampMS,
+    int cropLeft, int cropRight, int cropTop, int cropBottom)
+{
+    std::string key = fileKey + "|" + std::to_string(timestampMS) + "|" + std::to_string(width) + "x" + std::to_string(height) +
+        (keepaspectratio ? "|aspect|" : "|") +
+        std::to_string(cropLeft) + "," + std::to_string(cropRight) + "," + std::to_string(cropTop) + "," + std::to_string(cropBottom);
+
+    std::shared_ptr<const Frame> frame;
+    if (Find(key, frame))
+    {
+        ++_hits;
+        return frame;
+    }
+
+    std::shared_ptr<Reader> reader = GetReader(filename, fileKey, width, height, keepaspectratio, timestampMS);
+    std::unique_lock<std::mutex> readerLock(reader->lock);
+
+    // whoever had the reader before us may have just decoded it
+    if (Find(key, frame))
+    {
+        ++_hits;
+        return frame;
+    }
+    ++_misses;
+
+    VideoReader* videoreader = reader->reader.get();
+    if (!videoreader->IsValid() || videoreader->GetLengthMS() <= 0)
+    {
+        return nullptr;
+    }
+
+    // the same frame with a different crop does not need the reader to move
+    AVFrame* image = reader->frame;
+    if (image == nullptr || reader->timestamp != timestampMS)
+    {
+        if (timestampMS - reader->timestamp > VIDEOCACHE_READAHEAD_MS)
+        {
+            videoreader->Seek(timestampMS);
+        }
+        image = videoreader->GetNextFrame(timestampMS);
+        reader->timestamp = timestampMS;
+        reader->frame = image;
+    }
+
+    if (image == nullptr)
+    {
+        return nullptr;
+    }
+
+    int videoWidth = videoreader->GetWidth();
+    int videoHeight = videoreader->GetHeight();
+    int xoffset = cropLeft * videoWidth / 100;
+    int yoffset = cropBottom * videoHeight / 100;
+    int xtail = (100 - cropRight) * videoWidth / 100;
+    int ytail = (100 - cropTop) * videoHeight / 100;
+
+    std::shared_ptr<Frame> cropped = std::make_shared<Frame>();
+    cropped->width = std::max(0, videoWidth - xoffset - xtail);
+    cropped->height = std::max(0, videoHeight - yoffset - ytail);
+    cropped->pixels.resize((size_t)cropped->width * cropped->height * 3);
+    for (int y = 0; y < cropped->height; y++)
+    {
+        uint8_t* ptr = image->data[0] + (videoHeight - 1 - y - yoffset) * videoWidth * 3 + xoffset * 3;
+        memcpy(&cropped->pixels[(size_t)y * cropped->width * 3], ptr, cropped->width * 3);
+    }
+
+    Add(key, cropped);
+    return cropped;
+}
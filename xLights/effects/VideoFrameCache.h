@@ -0,0 +1,85 @@
+#ifndef VIDEOFRAMECACHE_H
+#define VIDEOFRAMECACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+class VideoReader;
+struct AVFrame;
+
+// Process wide cache of decoded video frames shared by every effect buffer that shows the same clip.
+//
+// Frames are keyed by file, modification time, timestamp, output size and crop so a video on a group
+// and on each of its members at the same size is only decoded, scaled and cropped once per frame.
+// The readers are shared too ... an effect gets the reader which is closest behind the frame it wants
+// so effects playing the clip in step decode it once and effects at other offsets do not make each
+// other seek. The least recently used frames are dropped once the memory budget is used.
+class VideoFrameCache
+{
+public:
+    // a frame scaled and cropped with its rows running bottom to top like the render buffer
+    struct Frame
+    {
+        int width;
+        int height;
+        std::vector<uint8_t> pixels; // RGB
+    };
+
+private:
+    struct Reader
+    {
+        std::mutex lock;
+        std::string key;
+        std::unique_ptr<VideoReader> reader;
+        std::atomic_int timestamp; // the last frame asked for
+        AVFrame* frame; // what the reader returned for it
+    };
+
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const Frame> frame;
+        size_t bytes;
+    };
+
+    std::mutex _lock;
+    std::list<Entry> _lru; // most recently used at the front
+    std::map<std::string, std::list<Entry>::iterator> _entries;
+    std::list<std::shared_ptr<Reader>> _readers; // most recently used at the front
+    size_t _bytes;
+    size_t _maxBytes;
+    std::atomic_ulong _hits;
+    std::atomic_ulong _misses;
+    std::atomic_ulong _readersOpened;
+
+    VideoFrameCache();
+
+    std::shared_ptr<Reader> GetReader(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int timestampMS);
+    bool Find(const std::string& key, std::shared_ptr<const Frame>& frame);
+    void Add(const std::string& key, std::shared_ptr<const Frame> frame);
+
+public:
+    static VideoFrameCache& GetCache();
+
+    void SetMaxMemoryMB(int mb);
+    void Purge();
+    // logs and then resets the hit, miss and reader counts
+    void LogStats();
+
+    // fileKey is ImageCache::GetFileKey(filename) ... callers work it out once per effect rather than once per frame
+
+    // the length of the clip and the size the reader scales it to, false if it cannot be opened
+    bool GetVideoInfo(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int& lengthMS, int& videoWidth, int& videoHeight);
+
+    // the frame showing at timestampMS scaled to fit width x height and cropped to the given percentages.
+    // Null past the end of the video.
+    std::shared_ptr<const Frame> GetFrame(const std::string& filename, const std::string& fileKey, int width, int height, bool keepaspectratio, int timestampMS,
+        int cropLeft, int cropRight, int cropTop, int cropBottom);
+};
+
+#endif
@@ -51,7 +51,8 @@ const std::vector<std::string> Model::DEFAULT_BUFFER_STYLES {DEFAULT, PER_PREVIE
 Model::Model(const ModelManager &manager) : modelDimmingCurve(nullptr), ModelXml(nullptr),
     parm1(0), parm2(0), parm3(0), pixelStyle(1), pixelSize(2), transparency(0), blackTransparency(0),
     StrobeRate(0), changeCount(0), modelManager(manager), CouldComputeStartChannel(false), maxVertexCount(0),
-    splitRGB(false), rgbwHandlingType(0)
+    splitRGB(false), rgbwHandlingType(0), previewChangeCount(0), previewWidth(-1), previewHeight(-1),
+    previewPixelStyle(-1), previewPixelSize(-1)
 {
     // These member vars were not initialised so give them some defaults.
     BufferHt = 0;
@@ -2718,6 +2719,16 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
     int w, h;
     preview->GetVirtualCanvasSize(w, h);
 
+    // split RGB pixels leave out their black parts so their vertices depend on the colors
+    bool cacheVertices = !splitRGB;
+    if (c == nullptr && cacheVertices
+        && previewChangeCount == changeCount && previewNodes.size() == NodeCount
+        && previewWidth == w && previewHeight == h
+        && previewPixelStyle == pixelStyle && previewPixelSize == pixelSize) {
+        DisplayCachedModelOnWindow(preview, va);
+        return;
+    }
+
 	 ModelScreenLocation& screenLocation = GetModelScreenLocation();
 	 screenLocation.SetPreviewSize(w, h, std::vector<NodeBaseClassPtr>());
 
@@ -2738,6 +2749,8 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
         maxVertexCount = vcount;
     }
     va.PreAlloc(maxVertexCount);
+    int firstVertex = va.count;
+    previewNodes.clear();
 
     int first = 0; 
     int last = NodeCount;
@@ -2780,6 +2793,7 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
                 }
             }
         }
+        int nodeFirstVertex = va.count;
         size_t CoordCount=GetCoordCount(n);
         for(size_t c2=0; c2 < CoordCount; c2++) {
             // draw node on screen
@@ -2824,6 +2838,17 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
                 va.AddTrianglesCircle(sx, sy, ((float)pixelSize) / 2.0f, ccolor, ecolor);
             }
         }
+        previewNodes.push_back(std::make_pair(n, (int)va.count - nodeFirstVertex));
+    }
+    if (cacheVertices) {
+        previewVertices.assign(&va.vertices[firstVertex * 2], &va.vertices[va.count * 2]);
+        previewChangeCount = changeCount;
+        previewWidth = w;
+        previewHeight = h;
+        previewPixelStyle = pixelStyle;
+        previewPixelSize = pixelSize;
+    } else {
+        previewNodes.clear();
     }
     if (pixelStyle > 1) {
         va.Finish(GL_TRIANGLES);
@@ -2835,6 +2860,68 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
     }
 }
 
+// display model using colors stored in each node and the vertices from the last time it was fully drawn
+void Model::DisplayCachedModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulator &va) {
+    int vcount = previewVertices.size() / 2;
+    va.PreAlloc(vcount);
+    if (vcount > 0) {
+        memcpy(&va.vertices[va.count * 2], &previewVertices[0], sizeof(float) * vcount * 2);
+    }
+
+    uint8_t *colors = &va.colors[va.count * 4];
+    xlColor color;
+    for (auto it = previewNodes.begin(); it != previewNodes.end(); ++it) {
+        int n = it->first;
+        Nodes[n]->GetColor(color);
+        if (Nodes[n]->model->modelDimmingCurve != nullptr) {
+            Nodes[n]->model->modelDimmingCurve->reverse(color);
+        }
+        if (Nodes[n]->model->StrobeRate) {
+            int r = rand() % 5;
+            if (r != 0) {
+                color = xlBLACK;
+            }
+        }
+
+        int trans = color == xlBLACK ? blackTransparency : transparency;
+        if (pixelStyle < 2) {
+            xlColor c3(color);
+            ApplyTransparency(c3, trans);
+            for (int v = 0; v < it->second; v++) {
+                *colors++ = c3.Red();
+                *colors++ = c3.Green();
+                *colors++ = c3.Blue();
+                *colors++ = c3.Alpha();
+            }
+        } else {
+            // each circle segment is two edge vertices then the center
+            xlColor ccolor(color);
+            xlColor ecolor(color);
+            ApplyTransparency(ccolor, trans);
+            ApplyTransparency(ecolor, pixelStyle == 2 ? trans : 100);
+            for (int v = 0; v < it->second; v += 3) {
+                for (int e = 0; e < 2; e++) {
+                    *colors++ = ecolor.Red();
+                    *colors++ = ecolor.Green();
+                    *colors++ = ecolor.Blue();
+                    *colors++ = ecolor.Alpha();
+                }
+                *colors++ = ccolor.Red();
+                *colors++ = ccolor.Green();
+                *colors++ = ccolor.Blue();
+                *colors++ = ccolor.Alpha();
+            }
+        }
+    }
+    va.count += vcount;
+
+    if (pixelStyle > 1) {
+        va.Finish(GL_TRIANGLES);
+    } else {
+        va.Finish(GL_POINTS, pixelStyle == 1 ? GL_POINT_SMOOTH : 0, preview->calcPixelSize(pixelSize));
+    }
+}
+
 wxString Model::GetNodeNear(ModelPreview* preview, wxPoint pt)
 {
     int w, h;
@@ -3099,11 +3186,13 @@ bool Model::HasCurve(int segment) {
 }
 
 void Model::SetCurve(int segment, bool create) {
-    return GetModelScreenLocation().SetCurve(segment, create);
+    GetModelScreenLocation().SetCurve(segment, create);
+    IncrementChangeCount();
 }
 
 void Model::AddHandle(ModelPreview* preview, int mouseX, int mouseY) {
     GetModelScreenLocation().AddHandle(preview, mouseX, mouseY);
+    IncrementChangeCount();
 }
 
 void Model::InsertHandle(int after_handle) {
@@ -3111,6 +3200,7 @@ void Model::InsertHandle(int after_handle) {
     if (GetModelScreenLocation().IsLocked()) return;
 
     GetModelScreenLocation().InsertHandle(after_handle);
+    IncrementChangeCount();
 }
 
 void Model::DeleteHandle(int handle) {
@@ -3118,6 +3208,7 @@ void Model::DeleteHandle(int handle) {
     if (GetModelScreenLocation().IsLocked()) return;
 
     GetModelScreenLocation().DeleteHandle(handle);
+    IncrementChangeCount();
 }
 
 void Model::SetTop(ModelPreview* preview,int y) {
@@ -380,6 +380,18 @@ public:
 
 protected:
     int maxVertexCount;
+
+    // The preview vertices of each node in the order they are drawn. They only depend on the layout so
+    // while that is unchanged playback just has to fill in the colors.
+    std::vector<float> previewVertices;
+    std::vector<std::pair<int, int>> previewNodes; // node and the number of vertices it has
+    unsigned long previewChangeCount;
+    int previewWidth;
+    int previewHeight;
+    int previewPixelStyle;
+    int previewPixelSize;
+
+    void DisplayCachedModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulator &va);
 };
 
 template <class ScreenLocation>
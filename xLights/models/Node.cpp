@@ -136,3 +136,34 @@ void NodeClassRGBW::GetForChannels(unsigned char *buf) const {
             break;
     }
 }
+
+void NodeTable::Build(const std::vector<NodeBaseClassPtr> &nodes) {
+    size_t count = nodes.size();
+    bufX.resize(count);
+    bufY.resize(count);
+    actChan.resize(count);
+    sparkle.resize(count);
+    coordStart.resize(count + 1);
+    coordX.clear();
+    coordY.clear();
+
+    for (size_t n = 0; n < count; n++) {
+        const NodeBaseClass *node = nodes[n].get();
+        actChan[n] = node->ActChan;
+        sparkle[n] = node->sparkle;
+        coordStart[n] = coordX.size();
+        if (node->Coords.empty()) {
+            bufX[n] = 0;
+            bufY[n] = 0;
+        } else {
+            bufX[n] = node->Coords[0].bufX;
+            bufY[n] = node->Coords[0].bufY;
+            for (auto &c : node->Coords) {
+                coordX.push_back(c.bufX);
+                coordY.push_back(c.bufY);
+            }
+        }
+    }
+    coordStart[count] = coordX.size();
+}
+
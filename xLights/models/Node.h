@@ -414,6 +414,27 @@ private:
 
 typedef std::unique_ptr<NodeBaseClass> NodeBaseClassPtr;
 
+// The buffer coordinates of a list of nodes held in flat arrays so the render loops walk contiguous
+// memory rather than following a pointer per node. bufX/bufY are each node's first coordinate and
+// every coordinate of node n is in coordX/coordY from coordStart[n] up to coordStart[n + 1].
+// The table is a copy so it must be rebuilt whenever the nodes or their coordinates change.
+// sparkle starts as a copy of the nodes' values but from then on the render advances it here, not in the nodes.
+class NodeTable
+{
+public:
+    std::vector<unsigned short> bufX;
+    std::vector<unsigned short> bufY;
+    std::vector<unsigned int> actChan;
+    std::vector<unsigned short> sparkle;
+    std::vector<unsigned int> coordStart;
+    std::vector<unsigned short> coordX;
+    std::vector<unsigned short> coordY;
+
+    void Build(const std::vector<NodeBaseClassPtr> &nodes);
+    size_t size() const { return actChan.size(); }
+    bool IsVisible(size_t n) const { return coordStart[n + 1] != coordStart[n]; }
+};
+
 
 #endif /* Node_h */
 
@@ -127,6 +127,7 @@ void PolyLineModel::InsertHandle(int after_handle) {
         ModelXml->AddAttribute(SegAttrName(after_handle+1), val);
     }
     GetModelScreenLocation().InsertHandle(after_handle);
+    IncrementChangeCount();
 }
 
 void PolyLineModel::DeleteHandle(int handle) {
@@ -143,6 +144,7 @@ void PolyLineModel::DeleteHandle(int handle) {
         polyLineSizes.erase(polyLineSizes.begin() + handle);
     }
     GetModelScreenLocation().DeleteHandle(handle);
+    IncrementChangeCount();
 }
 
 void PolyLineModel::InitModel() {
@@ -808,6 +810,7 @@ void PolyLineModel::ImportXlightsModel(std::string filename, xLightsFrame* xligh
             }
 
             GetModelScreenLocation().Read(ModelXml);
+            IncrementChangeCount();
 
             xlights->MarkEffectsFileDirty(true);
         }
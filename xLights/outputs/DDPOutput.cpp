@@ -229,7 +229,7 @@ void DDPOutput::EndFrame(int suppressFrames)
 
             memcpy(&_data[10], _fulldata + index, thissend);
 
-            _datagram->SendTo(_remoteAddr, &_data[0], DDP_PACKET_LEN - (1440 - thissend));
+            IPOutput::SendPacket(_datagram, _remoteAddr, &_data[0], DDP_PACKET_LEN - (1440 - thissend));
             _sequenceNum = _sequenceNum == 15 ? 1 : _sequenceNum + 1;
 
             tosend -= thissend;
@@ -343,6 +343,10 @@ void E131Output::Close()
             (*it)->Close();
         }
     }
+    else
+    {
+        IPOutput::Close();
+    }
 }
 #pragma endregion Start and Stop
 
@@ -404,7 +408,7 @@ void E131Output::EndFrame(int suppressFrames)
         if (_changed || NeedToOutput(suppressFrames))
         {
             _data[111] = _sequenceNum;
-            _datagram->SendTo(_remoteAddr, _data, E131_PACKET_LEN - (512 - _channels));
+            IPOutput::SendPacket(_datagram, _remoteAddr, _data, E131_PACKET_LEN - (512 - _channels));
             _sequenceNum = _sequenceNum == 255 ? 0 : _sequenceNum + 1;
             FrameOutput();
         }
@@ -436,16 +440,10 @@ void E131Output::SetOneChannel(long channel, unsigned char data)
 
     if (IsOutputCollection())
     {
-        long unum = channel / _channels;
-        auto it = _outputs.begin();
-        for (long i = 0; i < unum && it != _outputs.end(); i++)
-        {
-            ++it;
-        }
-
-        if (it != _outputs.end())
+        size_t unum = channel / _channels;
+        if (unum < _outputs.size())
         {
-            (*it)->SetOneChannel(channel % _channels, data);
+            _outputs[unum]->SetOneChannel(channel % _channels, data);
         }
     }
     else
@@ -461,26 +459,20 @@ void E131Output::SetManyChannels(long channel, unsigned char data[], long size)
 {
     if (IsOutputCollection())
     {
-        long startu = (channel) / _channels;
+        size_t u = (channel) / _channels;
         long startc = (channel) % _channels;
 
-        auto o = _outputs.begin();
-        for (long i = 0; i < startu; i++)
-        {
-            ++o;
-        }
-
         long left = size;
-        while (left > 0 && o != _outputs.end())
+        while (left > 0 && u < _outputs.size())
         {
 #ifdef _MSC_VER
             long send = min(left, _channels);
 #else
             long send = std::min(left, _channels);
 #endif
-            (*o)->SetManyChannels(startc, &data[size - left], send);
+            _outputs[u]->SetManyChannels(startc, &data[size - left], send);
             left -= send;
-            ++o;
+            ++u;
             startc = 0;
         }
     }
@@ -541,11 +533,13 @@ Output* E131Output::GetActualOutput(long startChannel)
         return this;
     }
 
-    for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
+    // the universes are all the same size and follow each other
+    if (startChannel >= _startChannel && _channels > 0)
     {
-        if ((*it)->GetStartChannel() <= startChannel && (*it)->GetEndChannel() >= startChannel)
+        size_t u = (startChannel - _startChannel) / _channels;
+        if (u < _outputs.size())
         {
-            return *it;
+            return _outputs[u];
         }
     }
 
@@ -578,15 +572,11 @@ std::string E131Output::GetChannelMapping(long ch) const
 
     if (IsOutputCollection())
     {
-        long unum = (ch - GetStartChannel()) / _channels;
-
-        auto o = _outputs.begin();
-        for (long i = 0; i < unum; i++)
+        size_t unum = (ch - GetStartChannel()) / _channels;
+        if (ch >= GetStartChannel() && unum < _outputs.size())
         {
-            ++o;
+            res = _outputs[unum]->GetChannelMapping(ch);
         }
-
-        res = (*o)->GetChannelMapping(ch);
     }
     else
     {
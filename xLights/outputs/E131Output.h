@@ -3,6 +3,7 @@
 
 #include "IPOutput.h"
 #include <wx/socket.h>
+#include <vector>
 
 // ******************************************************
 // * This class represents a single universe for E1.31
@@ -25,9 +26,9 @@ class E131Output : public IPOutput
     wxIPV4address _remoteAddr;
     wxDatagramSocket *_datagram;
 
-    // in case it is a multi universe e131
+    // in case it is a multi universe e131 ... a vector so a channel can be mapped straight to its universe
     int _numUniverses;
-    std::list<Output*> _outputs;
+    std::vector<Output*> _outputs;
     #pragma endregion Member Variables
 
 public:
@@ -55,7 +56,7 @@ public:
     virtual std::string GetUniverseString() const override;
 
     // These are required because one e1.31 output can actually be multiple
-    virtual std::list<Output*> GetOutputs() const override { return _outputs; }
+    virtual std::list<Output*> GetOutputs() const override { return std::list<Output*>(_outputs.begin(), _outputs.end()); }
     virtual bool IsOutputCollection() const override { return _numUniverses > 1; }
     virtual int GetUniverses() const override { return _numUniverses; }
     virtual void SetTransientData(int on, long startChannel, int nullnumber) override;
@@ -12,19 +12,215 @@
 #include <icmpapi.h>
 #endif
 
+#ifdef __LINUX__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
 std::string IPOutput::__localIP = "";
 
+#pragma region Batched Send
+// the most packets we hand to the kernel in one call
+#define IPOUTPUT_MAX_BATCH 1024
+
+class IPOutputPacket
+{
+public:
+    wxDatagramSocket* datagram;
+    wxIPV4address* remoteAddr;
+    size_t offset;
+    size_t len;
+};
+
+class IPOutputBatch
+{
+public:
+    bool batching = false;
+    std::vector<wxByte> data;
+    std::vector<IPOutputPacket> packets;
+};
+
+// each output group is flushed on its own thread and batches and sends only its own packets
+static thread_local IPOutputBatch __batch;
+
+#ifdef __LINUX__
+static std::mutex __batchSocketLock;
+static int __batchSocket = -1;
+static std::string __batchSocketIP = "";
+static int __batchSocketUsers = 0;
+
+// one socket shared by all outputs so a group's packets can go out in a handful of sendmmsg calls
+// the kernel is happy for several threads to send on it at once, we only need to protect creating it
+// like the outputs own sockets it is bound to an ephemeral port so packets go out from a different source port to
+// the unbatched ones ... E1.31, ArtNET and DDP receivers do not look at the source port
+static int GetBatchSocket()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::unique_lock<std::mutex> locker(__batchSocketLock);
+
+    if (__batchSocket != -1 && __batchSocketIP == IPOutput::GetLocalIP()) return __batchSocket;
+
+    if (__batchSocket != -1)
+    {
+        close(__batchSocket);
+        __batchSocket = -1;
+    }
+
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s == -1)
+    {
+        logger_base.warn("Unable to create batch send socket ... packets will be sent one at a time.");
+        return -1;
+    }
+
+    // never block the output thread, like the outputs own wxSOCKET_NOWAIT sockets anything the kernel cant take is dropped
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+
+    int broadcast = 1;
+    setsockopt(s, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    if (IPOutput::GetLocalIP() != "")
+    {
+        sockaddr_in local;
+        memset(&local, 0x00, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = 0;
+        if (inet_pton(AF_INET, IPOutput::GetLocalIP().c_str(), &local.sin_addr) != 1 ||
+            bind(s, (sockaddr*)&local, sizeof(local)) != 0)
+        {
+            logger_base.warn("Unable to bind batch send socket to %s ... packets will be sent one at a time.", (const char *)IPOutput::GetLocalIP().c_str());
+            close(s);
+            return -1;
+        }
+        setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, &local.sin_addr, sizeof(local.sin_addr));
+    }
+
+    __batchSocket = s;
+    __batchSocketIP = IPOutput::GetLocalIP();
+    return __batchSocket;
+}
+#endif
+
+static void AddBatchSocketUser()
+{
+#ifdef __LINUX__
+    std::unique_lock<std::mutex> locker(__batchSocketLock);
+    __batchSocketUsers++;
+#endif
+}
+
+static void ReleaseBatchSocketUser()
+{
+#ifdef __LINUX__
+    std::unique_lock<std::mutex> locker(__batchSocketLock);
+    __batchSocketUsers--;
+    if (__batchSocketUsers <= 0 && __batchSocket != -1)
+    {
+        close(__batchSocket);
+        __batchSocket = -1;
+        __batchSocketIP = "";
+    }
+#endif
+}
+
+void IPOutput::BeginBatch()
+{
+    __batch.batching = true;
+    __batch.data.clear();
+    __batch.packets.clear();
+}
+
+void IPOutput::SendPacket(wxDatagramSocket* datagram, wxIPV4address& remoteAddr, const wxByte* data, size_t len)
+{
+    if (!__batch.batching)
+    {
+        datagram->SendTo(remoteAddr, data, len);
+        return;
+    }
+
+    // the caller may reuse its buffer for the next packet so take a copy
+    IPOutputPacket packet;
+    packet.datagram = datagram;
+    packet.remoteAddr = &remoteAddr;
+    packet.offset = __batch.data.size();
+    packet.len = len;
+    __batch.data.insert(__batch.data.end(), data, data + len);
+    __batch.packets.push_back(packet);
+}
+
+int IPOutput::EndBatch()
+{
+    __batch.batching = false;
+
+    std::vector<IPOutputPacket>& packets = __batch.packets;
+    size_t sent = 0;
+
+#ifdef __LINUX__
+    int s = packets.size() > 1 ? GetBatchSocket() : -1;
+    if (s != -1)
+    {
+        std::vector<mmsghdr> msgs(std::min(packets.size(), (size_t)IPOUTPUT_MAX_BATCH));
+        std::vector<iovec> iovs(msgs.size());
+
+        while (sent < packets.size())
+        {
+            size_t count = std::min(packets.size() - sent, msgs.size());
+            for (size_t i = 0; i < count; i++)
+            {
+                IPOutputPacket& p = packets[sent + i];
+                iovs[i].iov_base = &__batch.data[p.offset];
+                iovs[i].iov_len = p.len;
+                memset(&msgs[i], 0x00, sizeof(mmsghdr));
+                msgs[i].msg_hdr.msg_name = (void*)p.remoteAddr->GetAddressData();
+                msgs[i].msg_hdr.msg_namelen = p.remoteAddr->GetAddressDataLen();
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            int res = sendmmsg(s, &msgs[0], count, MSG_DONTWAIT);
+            if (res <= 0)
+            {
+                // send whatever is left the slow way
+                break;
+            }
+            sent += res;
+        }
+    }
+#endif
+
+    for (size_t i = sent; i < packets.size(); i++)
+    {
+        IPOutputPacket& p = packets[i];
+        p.datagram->SendTo(*p.remoteAddr, &__batch.data[p.offset], p.len);
+    }
+
+    int count = packets.size();
+    packets.clear();
+    return count;
+}
+#pragma endregion Batched Send
+
 #pragma region Constructors and Destructors
 IPOutput::IPOutput(wxXmlNode* node) : Output(node)
 {
     _ip = node->GetAttribute("ComPort", "").ToStdString();
     _universe = wxAtoi(node->GetAttribute("BaudRate", "1"));
+    _batchSocketUser = false;
 }
 
 IPOutput::IPOutput() : Output()
 {
     _universe = 0;
     _ip = "";
+    _batchSocketUser = false;
 }
 #pragma endregion Constructors and Destructors
 
@@ -192,3 +388,25 @@ bool IPOutput::operator==(const IPOutput& output) const
 }
 #pragma endregion Operators
 
+#pragma region Start and Stop
+bool IPOutput::Open()
+{
+    if (!_batchSocketUser)
+    {
+        _batchSocketUser = true;
+        AddBatchSocketUser();
+    }
+
+    return Output::Open();
+}
+
+void IPOutput::Close()
+{
+    if (_batchSocketUser)
+    {
+        _batchSocketUser = false;
+        ReleaseBatchSocketUser();
+    }
+}
+#pragma endregion Start and Stop
+
@@ -8,6 +8,7 @@ class IPOutput : public Output
 {
 protected:
     static std::string __localIP;
+    bool _batchSocketUser; // true between Open and Close ... the shared batch socket is closed when the last user closes
 
     virtual void Save(wxXmlNode* node) override;
 
@@ -16,7 +17,7 @@ public:
     #pragma region Constructors and Destructors
     IPOutput(wxXmlNode* node);
     IPOutput();
-    virtual ~IPOutput() override {};
+    virtual ~IPOutput() override { IPOutput::Close(); };
     #pragma endregion Constructors and Destructors
 
     #pragma region Static Functions
@@ -29,6 +30,14 @@ public:
     static std::string DecodeError(wxSocketError err);
     #pragma endregion Static Functions
 
+    #pragma region Batched Send
+    // Between BeginBatch and EndBatch packets sent on this thread are queued rather than sent. EndBatch sends them all
+    // with as few system calls as the platform allows (sendmmsg on linux) and returns the number sent.
+    static void BeginBatch();
+    static int EndBatch();
+    static void SendPacket(wxDatagramSocket* datagram, wxIPV4address& remoteAddr, const wxByte* data, size_t len);
+    #pragma endregion Batched Send
+
     #pragma region Getters and Setters
     virtual bool IsIpOutput() const override { return true; }
     virtual bool IsSerialOutput() const override { return false; }
@@ -45,7 +54,8 @@ public:
     bool CanPing() const override { return (GetIP() != "MULTICAST"); }
 
     #pragma region Start and Stop
-    virtual bool Open() override { return Output::Open(); }
+    virtual bool Open() override;
+    virtual void Close() override;
     #pragma endregion Start and Stop
 };
 
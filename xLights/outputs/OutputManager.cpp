@@ -9,15 +9,102 @@
 #include "ArtNetOutput.h"
 #include "DDPOutput.h"
 #include "TestPreset.h"
+#include "../JobPool.h"
 #include <wx/msgdlg.h>
 #include "../osxMacUtils.h"
 #include <wx/config.h>
+#include <wx/stopwatch.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <condition_variable>
 
 int OutputManager::_lastSecond = -10;
 int OutputManager::_currentSecond = -10;
 int OutputManager::_lastSecondCount = 0;
 int OutputManager::_currentSecondCount = 0;
 
+// the most threads we will use to send a frame
+#define OUTPUT_MAX_THREADS 16
+
+#pragma region Output Groups
+// Counts down as the output groups finish so the frame can wait for all of them
+class OutputGroupLatch
+{
+    std::mutex _lock;
+    std::condition_variable _signal;
+    int _pending;
+
+public:
+    OutputGroupLatch() : _pending(0) {}
+
+    void Reset(int pending)
+    {
+        std::unique_lock<std::mutex> locker(_lock);
+        _pending = pending;
+    }
+
+    void CountDown()
+    {
+        std::unique_lock<std::mutex> locker(_lock);
+        if (--_pending <= 0)
+        {
+            _signal.notify_all();
+        }
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> locker(_lock);
+        _signal.wait(locker, [this] { return _pending <= 0; });
+    }
+};
+
+// The outputs that share a destination ... these are always sent in order on one thread
+class OutputGroup : public Job
+{
+    std::string _name;
+    std::list<Output*> _outputs;
+    OutputGroupLatch* _latch;
+    int _suppressFrames;
+    bool _allOff;
+    int _packets;
+
+public:
+    OutputGroup(const std::string& destination, OutputGroupLatch* latch) : _name("Output " + destination), _latch(latch), _suppressFrames(0), _allOff(false), _packets(0) {}
+    virtual ~OutputGroup() {}
+
+    void AddOutput(Output* output) { _outputs.push_back(output); }
+    void Prepare(int suppressFrames, bool allOff) { _suppressFrames = suppressFrames; _allOff = allOff; }
+
+    int GetPackets() const { return _packets; }
+
+    // any ip packets are queued and then sent together from this thread once the whole group is done
+    void Send()
+    {
+        IPOutput::BeginBatch();
+        for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
+        {
+            if (_allOff)
+            {
+                (*it)->AllOff();
+            }
+            (*it)->EndFrame(_suppressFrames);
+        }
+        _packets = IPOutput::EndBatch();
+    }
+
+    virtual void Process() override
+    {
+        Send();
+        _latch->CountDown();
+    }
+    virtual std::string GetStatus() override { return _name; }
+    virtual bool DeleteWhenComplete() override { return false; }
+    virtual const std::string GetName() const override { return _name; }
+};
+#pragma endregion Output Groups
+
 #pragma region Constructors and Destructors
 OutputManager::OutputManager()
 {
@@ -26,10 +113,23 @@ OutputManager::OutputManager()
     _syncUniverse = 0;
     _outputting = false;
     _suppressFrames = 0;
+    _lastFrameSendTime = 0;
+    _lastFramePackets = 0;
+    _outputGroupsValid = false;
+    _changeCount = 0;
+    _outputIndexChangeCount = -1;
+    _outputGroupLatch = new OutputGroupLatch();
+    // threads are only created once there is more than one group to send
+    _outputPool = new JobPool();
+    _outputPool->Start(OUTPUT_MAX_THREADS, OUTPUT_MAX_THREADS);
 }
 
 OutputManager::~OutputManager()
 {
+    delete _outputPool;
+    ClearOutputGroups();
+    delete _outputGroupLatch;
+
     // destroy all out output objects
     DeleteAllOutputs();
 }
@@ -56,6 +156,7 @@ bool OutputManager::Load(const std::string& showdir, bool syncEnabled)
             if (e->GetName() == "network")
             {
                 _outputs.push_back(Output::Create(e));
+                _changeCount++;
                 if (_outputs.back() == nullptr)
                 {
                     // this shouldnt happen unless we are loading a future file with an output type we dont recognise
@@ -162,6 +263,7 @@ bool OutputManager::Discover()
         if (std::find(outputs.begin(), outputs.end(), *it) == outputs.end())
         {
             _outputs.push_back(*it);
+            _changeCount++;
             found = true;
         }
     }
@@ -171,6 +273,7 @@ bool OutputManager::Discover()
         if (std::find(outputs.begin(), outputs.end(), *it) == outputs.end())
         {
             _outputs.push_back(*it);
+            _changeCount++;
             found = true;
         }
     }
@@ -180,10 +283,16 @@ bool OutputManager::Discover()
         if (std::find(outputs.begin(), outputs.end(), *it) == outputs.end())
         {
             _outputs.push_back(*it);
+            _changeCount++;
             found = true;
         }
     }
 
+    if (found)
+    {
+        SomethingChanged();
+    }
+
     return found;
 }
 #pragma endregion Controller Discovery
@@ -197,6 +306,11 @@ Output* OutputManager::GetOutput(int outputNumber) const
         return nullptr;
     }
 
+    if (IsOutputIndexValid())
+    {
+        return _outputIndex[outputNumber];
+    }
+
     auto iter = _outputs.begin();
     std::advance(iter, outputNumber);
     return *iter;
@@ -219,6 +333,18 @@ void OutputManager::SuspendAll(bool suspend)
 // get an output based on an absolute channel number
 Output* OutputManager::GetOutput(long absoluteChannel, long& startChannel) const
 {
+    if (IsOutputIndexValid())
+    {
+        // find the last output starting at or before the channel
+        auto it = std::upper_bound(_outputIndex.begin(), _outputIndex.end(), absoluteChannel,
+            [](long channel, const Output* o) { return channel < o->GetStartChannel(); });
+        if (it == _outputIndex.begin()) return nullptr;
+        --it;
+        if (absoluteChannel > (*it)->GetEndChannel()) return nullptr;
+        startChannel = absoluteChannel - (*it)->GetStartChannel() + 1;
+        return *it;
+    }
+
     for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
     {
         if (absoluteChannel >= (*it)->GetStartChannel() && absoluteChannel <= (*it)->GetEndChannel())
@@ -477,6 +603,16 @@ void OutputManager::SomethingChanged() const
 
         start += (*it)->GetChannels() * (*it)->GetUniverses();
     }
+
+    // edits to an output only reach us through here so count them as a change too
+    _changeCount++;
+
+    // start channels only ever increase so the outputs are already in order
+    _outputIndex.assign(_outputs.begin(), _outputs.end());
+    _outputIndexChangeCount = _changeCount;
+
+    // the destinations may have changed
+    _outputGroupsValid = false;
 }
 
 void OutputManager::SetForceFromIP(const std::string& forceFromIP)
@@ -511,6 +647,7 @@ void OutputManager::AddOutput(Output* output, Output* after)
         }
         _outputs = newoutputs;
     }
+    _changeCount++;
 
     SomethingChanged();
 
@@ -544,6 +681,7 @@ void OutputManager::AddOutput(Output* output, int pos)
         }
         _outputs = newoutputs;
     }
+    _changeCount++;
 
     SomethingChanged();
 
@@ -557,6 +695,7 @@ void OutputManager::DeleteOutput(Output* output)
 
     _dirty = true;
     _outputs.remove(output);
+    _changeCount++;
     delete output;
     
     SomethingChanged();
@@ -573,7 +712,8 @@ void OutputManager::DeleteAllOutputs()
     }
 
     _outputs.clear();
-    
+    _changeCount++;
+
     SomethingChanged();
 }
 
@@ -607,6 +747,7 @@ void OutputManager::MoveOutput(Output* output, int toOutputNumber)
     }
 
     _outputs = res;
+    _changeCount++;
 
     SomethingChanged();
 }
@@ -718,6 +859,8 @@ void OutputManager::Replace(Output* replacethis, Output* withthis)
         }
     }
     _outputs = newoutputs;
+    _changeCount++;
+    SomethingChanged();
 }
 #pragma endregion Output Management
 
@@ -744,14 +887,95 @@ void OutputManager::ResetFrame()
     _outputCriticalSection.Leave();
 }
 
+void OutputManager::ClearOutputGroups()
+{
+    for (auto it = _outputGroups.begin(); it != _outputGroups.end(); ++it)
+    {
+        delete *it;
+    }
+    _outputGroups.clear();
+    _outputGroupsValid = false;
+}
+
+void OutputManager::BuildOutputGroups()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    ClearOutputGroups();
+
+    std::map<std::string, OutputGroup*> groups;
+    for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
+    {
+        // outputs that dont go to an ip address or serial port all share the one group
+        std::string destination = "";
+        if ((*it)->IsIpOutput())
+        {
+            destination = (*it)->GetIP();
+        }
+        else if ((*it)->IsSerialOutput())
+        {
+            destination = (*it)->GetCommPort();
+        }
+
+        auto group = groups.find(destination);
+        if (group == groups.end())
+        {
+            OutputGroup* g = new OutputGroup(destination, _outputGroupLatch);
+            _outputGroups.push_back(g);
+            group = groups.insert(std::make_pair(destination, g)).first;
+        }
+        group->second->AddOutput(*it);
+    }
+    _outputGroupsValid = true;
+
+    logger_base.debug("%d outputs will be sent in %d groups.", (int)_outputs.size(), (int)_outputGroups.size());
+}
+
+// Sends all the outputs with each destination on its own thread and waits until they are all done
+// returns the number of ip packets sent
+int OutputManager::FlushOutputGroups(bool allOff)
+{
+    if (!_outputGroupsValid) BuildOutputGroups();
+    if (_outputGroups.size() == 0) return 0;
+
+    for (auto it = _outputGroups.begin(); it != _outputGroups.end(); ++it)
+    {
+        (*it)->Prepare(_suppressFrames, allOff);
+    }
+
+    // the last group is sent on this thread rather than sitting idle while we wait
+    _outputGroupLatch->Reset(_outputGroups.size() - 1);
+    for (size_t i = 0; i < _outputGroups.size() - 1; i++)
+    {
+        _outputPool->PushJob(_outputGroups[i]);
+    }
+    _outputGroups.back()->Send();
+    _outputGroupLatch->Wait();
+
+    int packets = 0;
+    for (auto it = _outputGroups.begin(); it != _outputGroups.end(); ++it)
+    {
+        packets += (*it)->GetPackets();
+    }
+    return packets;
+}
+
 void OutputManager::EndFrame()
 {
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
 
-    for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
+    wxStopWatch sw;
+
+    // each group sends its own ip packets ... they are all out before we get to the sync packets
+    _lastFramePackets = FlushOutputGroups(false);
+    _lastFrameSendTime = sw.TimeInMicro().ToLong();
+
+    if (_lastFrameSendTime > 20000)
     {
-        (*it)->EndFrame(_suppressFrames);
+        logger_base.debug("Sending frame took %ldms for %d packets.", _lastFrameSendTime / 1000, _lastFramePackets);
     }
 
     if (IsSyncEnabled())
@@ -788,6 +1012,9 @@ bool OutputManager::StartOutput()
 
     logger_base.debug("Starting light output.");
 
+    // pick up any changed ip addresses or serial ports
+    _outputGroupsValid = false;
+
     int started = 0;
     bool ok = true;
     bool err = false;
@@ -799,7 +1026,11 @@ bool OutputManager::StartOutput()
         if (!ok && ok != preok)
         {
             logger_base.error("An error occured opening output %d (%s). Do you want to continue trying to start output?", started + 1, (const char *)(*it)->GetDescription().c_str());
-            if (wxMessageBox(wxString::Format(wxT("An error occured opening output %d (%s). Do you want to continue trying to start output?"), started+1, (*it)->GetDescription()), "Continue?", wxYES_NO) == wxNO) return _outputting;
+            if (wxMessageBox(wxString::Format(wxT("An error occured opening output %d (%s). Do you want to continue trying to start output?"), started+1, (*it)->GetDescription()), "Continue?", wxYES_NO) == wxNO)
+            {
+                _outputCriticalSection.Leave();
+                return _outputting;
+            }
             err = true;
         }
         if (ok) started++;
@@ -849,11 +1080,7 @@ void OutputManager::StopOutput()
 void OutputManager::AllOff()
 {
     if (!_outputCriticalSection.TryEnter()) return;
-    for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
-    {
-        (*it)->AllOff();
-        (*it)->EndFrame(_suppressFrames);
-    }
+    FlushOutputGroups(true);
     _outputCriticalSection.Leave();
 }
 
@@ -1045,6 +1272,10 @@ int OutputManager::GetPacketsPerSecond() const
 
 void OutputManager::RegisterSentPacket()
 {
+    // outputs are flushed from several threads at once
+    static std::mutex lock;
+    std::unique_lock<std::mutex> locker(lock);
+
     int second = wxGetLocalTime() % 60;
 
     if (second == _currentSecond)
@@ -2,12 +2,16 @@
 #define OUTPUTMANAGER_H
 
 #include <list>
+#include <vector>
 #include <string>
 #include <wx/thread.h>
 
 class Output;
 class Controller;
 class TestPreset;
+class JobPool;
+class OutputGroup;
+class OutputGroupLatch;
 
 #define NETWORKSFILE "xlights_networks.xml";
 
@@ -16,6 +20,9 @@ class OutputManager
     #pragma region Member Variables
     std::string _filename;
     std::list<Output*> _outputs;
+    mutable std::vector<Output*> _outputIndex; // _outputs in start channel order for fast lookups, rebuilt by SomethingChanged
+    mutable int _changeCount; // bumped whenever an output is added, removed or edited
+    mutable int _outputIndexChangeCount; // _changeCount when _outputIndex was last built
     std::list<TestPreset*> _testPresets;
     int _syncUniverse;
     bool _syncEnabled;
@@ -23,6 +30,12 @@ class OutputManager
     int _suppressFrames;
     bool _outputting; // true if we are currently sending out data
     wxCriticalSection _outputCriticalSection; // used to protect areas that must be single threaded
+    long _lastFrameSendTime; // microseconds taken to send the last frame
+    int _lastFramePackets; // packets sent in the last frame
+    std::vector<OutputGroup*> _outputGroups; // outputs grouped by destination ip or serial port, each group is flushed on its own thread
+    mutable bool _outputGroupsValid; // cleared by SomethingChanged
+    JobPool* _outputPool;
+    OutputGroupLatch* _outputGroupLatch;
     #pragma endregion Member Variables
 
     static int _lastSecond;
@@ -31,6 +44,10 @@ class OutputManager
     static int _currentSecondCount;
 
     bool SetGlobalOutputtingFlag(bool state, bool force = false);
+    bool IsOutputIndexValid() const { return _outputIndexChangeCount == _changeCount; }
+    void BuildOutputGroups();
+    void ClearOutputGroups();
+    int FlushOutputGroups(bool allOff);
 
 public:
 
@@ -87,12 +104,18 @@ public:
     bool StartOutput();
     void StopOutput();
     bool IsOutputting() const { return _outputting; }
+    // hold this around StartFrame/SetManyChannels/EndFrame when sending from another thread so outputs cannot be started or stopped
+    // part way through a frame ... and around StartOutput/StopOutput so they wait for that frame rather than giving up
+    void LockOutput() { _outputCriticalSection.Enter(); }
+    void UnlockOutput() { _outputCriticalSection.Leave(); }
     #pragma endregion Start and Stop
 
     #pragma region Frame Handling
     void StartFrame(long msec);
     void EndFrame();
     void ResetFrame();
+    long GetLastFrameSendTime() const { return _lastFrameSendTime; }
+    int GetLastFramePackets() const { return _lastFramePackets; }
     #pragma endregion Frame Handling
 
     #pragma region Packet Sync
@@ -77,6 +77,54 @@ void SettingsMap::RemapChangedSettingKey(std::string &n,  std::string &value)
     Remaps.map(n);
 }
 
+// Sequences store each distinct settings and palette string once and most of them are used by many
+// effects so effects created from the same string share one parsed map. Only weak references are kept
+// here so a map goes away with the last effect using it.
+class SettingsMapPool
+{
+public:
+    template <typename F>
+    std::shared_ptr<SettingsMap> Get(const std::string &str, F prepare)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        auto it = _maps.find(str);
+        if (it != _maps.end())
+        {
+            std::shared_ptr<SettingsMap> map = it->second.lock();
+            if (map != nullptr) return map;
+        }
+
+        std::shared_ptr<SettingsMap> map = std::make_shared<SettingsMap>();
+        map->Parse(str);
+        prepare(*map);
+        _maps[str] = map;
+
+        // forget the maps nobody uses any more now and then so the pool does not grow forever
+        if (_maps.size() >= _purgeAt)
+        {
+            for (auto it2 = _maps.begin(); it2 != _maps.end(); )
+            {
+                if (it2->second.expired())
+                {
+                    it2 = _maps.erase(it2);
+                }
+                else
+                {
+                    ++it2;
+                }
+            }
+            _purgeAt = std::max((size_t)1024, _maps.size() * 2);
+        }
+        return map;
+    }
+
+private:
+    std::mutex _lock;
+    std::unordered_map<std::string, std::weak_ptr<SettingsMap>> _maps;
+    size_t _purgeAt = 1024;
+} SettingsPool, PalettePool;
+
 static std::vector<std::string> CHECKBOX_IDS {
     "C_CHECKBOX_Palette1", "C_CHECKBOX_Palette2", "C_CHECKBOX_Palette3",
     "C_CHECKBOX_Palette4", "C_CHECKBOX_Palette5", "C_CHECKBOX_Palette6",
@@ -121,23 +169,25 @@ Effect::Effect(EffectLayer* parent,int id, const std::string & name, const std::
 {
     mColorMask = xlColor::NilColor();
     mEffectIndex = (parent->GetParentElement() == nullptr) ? -1 : parent->GetParentElement()->GetSequenceElements()->GetEffectManager().GetEffectIndex(name);
-    mSettings.Parse(settings);
-
-    // Fixes an erroneous blank settings created by using:
-    //  settings["key"] == "test val"
-    // code which as a side effect creates a blank value under the key
-    // an example of this is fix to issue #622
-    if (mSettings.Get("T_CHOICE_Out_Transition_Type", "XXX") == "")
-    {
-        mSettings.erase("T_CHOICE_Out_Transition_Type");
-    }
-    if (mSettings.Get("Converted", "XXX") == "")
+    mSettings = SettingsPool.Get(settings, [](SettingsMap &map)
     {
-        mSettings.erase("Converted");
-    }
+        // Fixes an erroneous blank settings created by using:
+        //  settings["key"] == "test val"
+        // code which as a side effect creates a blank value under the key
+        // an example of this is fix to issue #622
+        if (map.Get("T_CHOICE_Out_Transition_Type", "XXX") == "")
+        {
+            map.erase("T_CHOICE_Out_Transition_Type");
+        }
+        if (map.Get("Converted", "XXX") == "")
+        {
+            map.erase("Converted");
+        }
+    });
+    mSettingsShared = true;
 
     // check for any other odd looking blank settings
-    for (auto it = mSettings.begin(); it != mSettings.end(); ++it)
+    for (auto it = mSettings->begin(); it != mSettings->end(); ++it)
     {
         if (it->second == "")
         {
@@ -163,8 +213,9 @@ Effect::Effect(EffectLayer* parent,int id, const std::string & name, const std::
         mName = new std::string(name);
     }
 
-    mPaletteMap.Parse(palette);
-    ParseColorMap(mPaletteMap, mColors, mCC);
+    mPaletteMap = PalettePool.Get(palette, [](SettingsMap &) {});
+    mPaletteShared = true;
+    ParseColorMap(*mPaletteMap, mColors, mCC);
 }
 
 Effect::~Effect()
@@ -227,11 +278,7 @@ void Effect::SetEffectName(const std::string & name)
 
 wxString Effect::GetDescription() const
 {
-    if (mSettings.Contains("X_Effect_Description"))
-    {
-        return mSettings["X_Effect_Description"];
-    }
-    return "";
+    return mSettings->Get("X_Effect_Description", "");
 }
 
 void Effect::SetStartTimeMS(int startTimeMS)
@@ -273,18 +320,18 @@ bool Effect::OverlapsWith(int startTimeMS, int EndTimeMS)
 
 bool Effect::IsLocked() const
 {
-    return mSettings.Contains("X_Effect_Locked");
+    return mSettings->Contains("X_Effect_Locked");
 }
 
 void Effect::SetLocked(bool lock)
 {
     if (lock)
     {
-        mSettings["X_Effect_Locked"] = "True";
+        GetSettings()["X_Effect_Locked"] = "True";
     }
-    else
+    else if (IsLocked())
     {
-        mSettings.erase("X_Effect_Locked");
+        GetSettings().erase("X_Effect_Locked");
     }
 }
 
@@ -296,7 +343,39 @@ void Effect::IncrementChangeCount()
 std::string Effect::GetSettingsAsString() const
 {
     std::unique_lock<std::mutex> lock(settingsLock);
-    return mSettings.AsString();
+    return mSettings->AsString();
+}
+
+SettingsMap &Effect::EditSettings()
+{
+    if (mSettingsShared)
+    {
+        mSettings = std::make_shared<SettingsMap>(*mSettings);
+        mSettingsShared = false;
+    }
+    return *mSettings;
+}
+
+SettingsMap &Effect::EditPaletteMap()
+{
+    if (mPaletteShared)
+    {
+        mPaletteMap = std::make_shared<SettingsMap>(*mPaletteMap);
+        mPaletteShared = false;
+    }
+    return *mPaletteMap;
+}
+
+SettingsMap &Effect::GetSettings()
+{
+    std::unique_lock<std::mutex> lock(settingsLock);
+    return EditSettings();
+}
+
+SettingsMap &Effect::GetPaletteMap()
+{
+    std::unique_lock<std::mutex> lock(settingsLock);
+    return EditPaletteMap();
 }
 
 void Effect::SetSettings(const std::string &settings, bool keepxsettings)
@@ -306,7 +385,7 @@ void Effect::SetSettings(const std::string &settings, bool keepxsettings)
     SettingsMap x;
     if (keepxsettings)
     {
-        for (auto it = mSettings.begin(); it != mSettings.end(); ++it)
+        for (auto it = mSettings->begin(); it != mSettings->end(); ++it)
         {
             if (it->first.size() > 2 && it->first[0] == 'X' && it->first[1] == '_')
             {
@@ -314,12 +393,18 @@ void Effect::SetSettings(const std::string &settings, bool keepxsettings)
             }
         }
     }
-    mSettings.Parse(settings);
+    // anyone holding our own settings keeps seeing them ... only a shared map is let go
+    if (mSettingsShared)
+    {
+        mSettings = std::make_shared<SettingsMap>();
+        mSettingsShared = false;
+    }
+    mSettings->Parse(settings);
     if (keepxsettings)
     {
         for (auto it = x.begin(); it != x.end(); ++it)
         {
-            mSettings[it->first] = it->second;
+            (*mSettings)[it->first] = it->second;
         }
     }
     IncrementChangeCount();
@@ -330,26 +415,28 @@ void Effect::ApplySetting(const std::string& id, const std::string& value, Value
     wxString idd(id);
     if (idd.StartsWith("C_"))
     {
+        SettingsMap &paletteMap = GetPaletteMap();
         if (vc != nullptr && vc->IsActive())
         {
-            mPaletteMap[vcid] = vc->Serialise();
+            paletteMap[vcid] = vc->Serialise();
         }
         else
         {
-            mPaletteMap.erase(vcid);
-            mPaletteMap[id] = value;
+            paletteMap.erase(vcid);
+            paletteMap[id] = value;
         }
     }
     else
     {
+        SettingsMap &settings = GetSettings();
         if (vc != nullptr && vc->IsActive())
         {
-            mSettings[vcid] = vc->Serialise();
+            settings[vcid] = vc->Serialise();
         }
         else
         {
-            mSettings.erase(vcid);
-            mSettings[id] = value;
+            settings.erase(vcid);
+            settings[id] = value;
         }
     }
     IncrementChangeCount();
@@ -359,7 +446,7 @@ void Effect::CopySettingsMap(SettingsMap &target, bool stripPfx) const
 {
     std::unique_lock<std::mutex> lock(settingsLock);
 
-    for (std::map<std::string,std::string>::const_iterator it=mSettings.begin(); it!=mSettings.end(); ++it)
+    for (std::map<std::string,std::string>::const_iterator it=mSettings->begin(); it!=mSettings->end(); ++it)
     {
         std::string name = it->first;
         if (stripPfx && name[1] == '_')
@@ -368,7 +455,7 @@ void Effect::CopySettingsMap(SettingsMap &target, bool stripPfx) const
         }
         target[name] = it->second;
     }
-    for (std::map<std::string,std::string>::const_iterator it=mPaletteMap.begin(); it!=mPaletteMap.end(); ++it)
+    for (std::map<std::string,std::string>::const_iterator it=mPaletteMap->begin(); it!=mPaletteMap->end(); ++it)
     {
         std::string name = it->first;
         if (stripPfx && name[1] == '_'  && (name[2] == 'S' || name[2] == 'C' || name[2] == 'V')) //only need the slider, checkbox and value curve entries
@@ -382,21 +469,26 @@ void Effect::CopySettingsMap(SettingsMap &target, bool stripPfx) const
 std::string Effect::GetPaletteAsString() const
 {
     std::unique_lock<std::mutex> lock(settingsLock);
-    return mPaletteMap.AsString();
+    return mPaletteMap->AsString();
 }
 
 void Effect::SetPalette(const std::string& i)
 {
     std::unique_lock<std::mutex> lock(settingsLock);
-    mPaletteMap.Parse(i);
+    if (mPaletteShared)
+    {
+        mPaletteMap = std::make_shared<SettingsMap>();
+        mPaletteShared = false;
+    }
+    mPaletteMap->Parse(i);
     mColors.clear();
     mCC.clear();
     IncrementChangeCount();
-    if (mPaletteMap.empty())
+    if (mPaletteMap->empty())
     {
         return;
     }
-    ParseColorMap(mPaletteMap, mColors, mCC);
+    ParseColorMap(*mPaletteMap, mColors, mCC);
 }
 
 void Effect::CopyPalette(xlColorVector &target, xlColorCurveVector& newcc) const
@@ -411,11 +503,11 @@ void Effect::PaletteMapUpdated() {
     mColors.clear();
     mCC.clear();
     IncrementChangeCount();
-    if (mPaletteMap.empty())
+    if (mPaletteMap->empty())
     {
         return;
     }
-    ParseColorMap(mPaletteMap, mColors, mCC);
+    ParseColorMap(*mPaletteMap, mColors, mCC);
 }
 
 bool operator<(const Effect &e1, const Effect &e2)
@@ -6,6 +6,7 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <memory>
 
 #include "ColorCurve.h"
 #include "../UtilClasses.h"
@@ -36,8 +37,11 @@ class Effect
     EffectLayer* mParentLayer;
     xlColor mColorMask;
     mutable std::mutex settingsLock;
-    SettingsMap mSettings;
-    SettingsMap mPaletteMap;
+    // effects loaded with the same settings or palette share one copy of them until they are changed
+    std::shared_ptr<SettingsMap> mSettings;
+    std::shared_ptr<SettingsMap> mPaletteMap;
+    bool mSettingsShared;
+    bool mPaletteShared;
     xlColorVector mColors;
     xlColorCurveVector mCC;
     DrawGLUtils::xlDisplayList background;
@@ -45,6 +49,9 @@ class Effect
     Effect() {}  //don't allow default or copy constructor
     Effect(const Effect &e) {}
     static void ParseColorMap(const SettingsMap &mPaletteMap, xlColorVector &mColors, xlColorCurveVector& mCC);
+    // our own copy of the settings to change ... the caller must hold settingsLock
+    SettingsMap &EditSettings();
+    SettingsMap &EditPaletteMap();
 
 public:
     Effect(EffectLayer* parent, int id, const std::string & name, const std::string &settings, const std::string &palette,
@@ -90,20 +97,21 @@ public:
     std::string GetSettingsAsString() const;
     void SetSettings(const std::string &settings, bool keepxsettings);
     void ApplySetting(const std::string& id, const std::string& value, ValueCurve* vc, const std::string& vcid);
-    const SettingsMap &GetSettings() const { return mSettings; }
+    const SettingsMap &GetSettings() const { return *mSettings; }
     void CopySettingsMap(SettingsMap &target, bool stripPfx = false) const;
 
     const xlColorVector &GetPalette() const { return mColors; }
     int GetPaletteSize() const { return mColors.size(); }
-    const SettingsMap &GetPaletteMap() const { return mPaletteMap; }
+    const SettingsMap &GetPaletteMap() const { return *mPaletteMap; }
     std::string GetPaletteAsString() const;
     void SetPalette(const std::string& i);
     void CopyPalette(xlColorVector &target, xlColorCurveVector& newcc) const;
 
     /* Do NOT call these on any thread other than the main thread */
-    SettingsMap &GetSettings() { return mSettings; }
+    /* The settings returned are the effect's own so call the const versions if only reading them */
+    SettingsMap &GetSettings();
     xlColorVector &GetPalette() { return mColors; }
-    SettingsMap &GetPaletteMap() { return mPaletteMap; }
+    SettingsMap &GetPaletteMap();
     void PaletteMapUpdated();
 
     DrawGLUtils::xlDisplayList &GetBackgroundDisplayList() { return background; }
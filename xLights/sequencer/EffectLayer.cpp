@@ -1168,7 +1168,7 @@ std::list<std::string> EffectLayer::GetFileReferences(EffectManager& em) const
 
     for (int k = 0; k < GetEffectCount(); k++)
     {
-        Effect* ef = GetEffect(k);
+        const Effect* ef = GetEffect(k);
 
         if (ef->GetEffectIndex() >= 0)
         {
@@ -2609,10 +2609,10 @@ std::map<int, std::list<float>> xLightsFrame::LoadPolyphonicTranscription(AudioM
 
         for (size_t i = 0; i < frames; i++)
         {
-            std::list<float>* pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
-            if (pdata != nullptr)
+            AudioFrameData pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
+            if (pdata.IsValid())
             {
-                res[i*intervalMS] = *pdata;
+                res[i*intervalMS] = std::list<float>(pdata.begin(), pdata.end());
             }
         }
 
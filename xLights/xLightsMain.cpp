@@ -32,6 +32,8 @@
 #include "xLightsVersion.h"
 #include "RenderCommandEvent.h"
 #include "effects/RenderableEffect.h"
+#include "effects/ImageCache.h"
+#include "effects/VideoFrameCache.h"
 #include "LayoutPanel.h"
 #include "models/ModelGroup.h"
 #include "PixelTestDialog.h"
@@ -261,6 +263,10 @@ const long xLightsFrame::ID_MNU_BKPPURGE_WEEK = wxNewId();
 const long xLightsFrame::ID_MNU_BKP_PURGE = wxNewId();
 const long xLightsFrame::ID_MNU_BACKUP = wxNewId();
 const long xLightsFrame::ID_MNU_EXCLUDEPRESETS = wxNewId();
+const long xLightsFrame::ID_MNU_COMPRESSEDFSEQ = wxNewId();
+const long xLightsFrame::ID_MNU_RENDERCACHE = wxNewId();
+const long xLightsFrame::ID_MNU_PERSISTRENDERCACHE = wxNewId();
+const long xLightsFrame::ID_MNU_RENDERCACHESIZE = wxNewId();
 const long xLightsFrame::ID_MNU_EXCLUDEAUDIOPKGSEQ = wxNewId();
 const long xLightsFrame::ID_MENUITEM_ICON_SMALL = wxNewId();
 const long xLightsFrame::ID_MENUITEM_ICON_MEDIUM = wxNewId();
@@ -951,6 +957,14 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     MenuSettings->Append(MenuItem_ExcludePresetsFromPackagedSequences);
     MenuItem_ExcludeAudioPackagedSequence = new wxMenuItem(MenuSettings, ID_MNU_EXCLUDEAUDIOPKGSEQ, _("Exclude Audio From Packaged Sequences"), wxEmptyString, wxITEM_CHECK);
     MenuSettings->Append(MenuItem_ExcludeAudioPackagedSequence);
+    MenuItem_CompressedFSEQ = new wxMenuItem(MenuSettings, ID_MNU_COMPRESSEDFSEQ, _("Compressed FSEQ (v2)"), wxEmptyString, wxITEM_CHECK);
+    MenuSettings->Append(MenuItem_CompressedFSEQ);
+    MenuItem_RenderCache = new wxMenuItem(MenuSettings, ID_MNU_RENDERCACHE, _("Cache Rendered Effects"), wxEmptyString, wxITEM_CHECK);
+    MenuSettings->Append(MenuItem_RenderCache);
+    MenuItem_PersistRenderCache = new wxMenuItem(MenuSettings, ID_MNU_PERSISTRENDERCACHE, _("Save Render Cache In Show Folder"), wxEmptyString, wxITEM_CHECK);
+    MenuSettings->Append(MenuItem_PersistRenderCache);
+    MenuItem_RenderCacheSize = new wxMenuItem(MenuSettings, ID_MNU_RENDERCACHESIZE, _("Render Cache Memory Size ..."), wxEmptyString, wxITEM_NORMAL);
+    MenuSettings->Append(MenuItem_RenderCacheSize);
     ToolIconSizeMenu = new wxMenu();
     MenuItem10 = new wxMenuItem(ToolIconSizeMenu, ID_MENUITEM_ICON_SMALL, _("Small\tALT-1"), wxEmptyString, wxITEM_RADIO);
     ToolIconSizeMenu->Append(MenuItem10);
@@ -1235,6 +1249,10 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     Connect(ID_MNU_BKPPURGE_WEEK,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_BackupPurgeIntervalSelected);
     Connect(ID_MNU_BACKUP,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_BackupSubfoldersSelected);
     Connect(ID_MNU_EXCLUDEPRESETS,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_ExcludePresetsFromPackagedSequencesSelected);
+    Connect(ID_MNU_COMPRESSEDFSEQ,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_CompressedFSEQSelected);
+    Connect(ID_MNU_RENDERCACHE,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_RenderCacheSelected);
+    Connect(ID_MNU_PERSISTRENDERCACHE,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_PersistRenderCacheSelected);
+    Connect(ID_MNU_RENDERCACHESIZE,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_RenderCacheSizeSelected);
     Connect(ID_MNU_EXCLUDEAUDIOPKGSEQ,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::OnMenuItem_ExcludeAudioPackagedSequenceSelected);
     Connect(ID_MENUITEM_ICON_SMALL,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::SetToolIconSize);
     Connect(ID_MENUITEM_ICON_MEDIUM,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xLightsFrame::SetToolIconSize);
@@ -1611,6 +1629,30 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     MenuItem_ExcludeAudioPackagedSequence->Check(_excludeAudioFromPackagedSequences);
     logger_base.debug("Exclude Audio From Packaged Sequences: %s.", _excludeAudioFromPackagedSequences ? "true" : "false");
 
+    config->Read("xLightsCompressedFSEQ", &_compressedFSEQ, false);
+    MenuItem_CompressedFSEQ->Check(_compressedFSEQ);
+    logger_base.debug("Compressed FSEQ: %s.", _compressedFSEQ ? "true" : "false");
+
+    bool renderCache = false;
+    config->Read("xLightsRenderCache", &renderCache, false);
+    MenuItem_RenderCache->Check(renderCache);
+    _renderCache.Enable(renderCache);
+    config->Read("xLightsPersistRenderCache", &_persistRenderCache, false);
+    MenuItem_PersistRenderCache->Check(_persistRenderCache);
+    MenuItem_PersistRenderCache->Enable(renderCache);
+    MenuItem_RenderCacheSize->Enable(renderCache);
+    config->Read("xLightsRenderCacheMB", &_renderCacheMB, 1024);
+    _renderCache.SetMaxMemoryMB(_renderCacheMB);
+    logger_base.debug("Render cache: %s, %dMB, saved in show folder: %s.", renderCache ? "true" : "false", _renderCacheMB, _persistRenderCache ? "true" : "false");
+
+    int imageCacheMB = 512;
+    config->Read("xLightsImageCacheMB", &imageCacheMB, 512);
+    ImageCache::GetCache().SetMaxMemoryMB(imageCacheMB);
+    int videoCacheMB = 256;
+    config->Read("xLightsVideoCacheMB", &videoCacheMB, 256);
+    VideoFrameCache::GetCache().SetMaxMemoryMB(videoCacheMB);
+    logger_base.debug("Image cache: %dMB, video frame cache: %dMB.", imageCacheMB, videoCacheMB);
+
     config->Read("xLightsShowACLights", &_showACLights, false);
     MenuItem_ACLIghts->Check(_showACLights);
     logger_base.debug("Show AC Lights toolbar: %s.", _showACLights ? "true" : "false");
@@ -1866,14 +1908,12 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     //to whatever the timing that is selected
     Timer1.Start(50, wxTIMER_CONTINUOUS);
 
-    // What makes 4 the right answer ... try 10 ... why ... usually it is one thread that runs slow and that model
-    // holds up others so in the time while we wait for the busy thread we can actually run a lot more models
-    // what is the worst that could happen ... all models want to run hard so we lose some efficiency while we churn between
-    // threads ... a minor loss of efficiency ... I think the one thread blocks the others is more common.
-    // Dan is concerned on 32 bit windows 10 will chew up too much heap memory ... so splitting the difference we get 7
+    // Render jobs no longer block a thread while waiting for the models they depend on, they park
+    // and are re-queued when the frame they need is ready, so one thread per core keeps every core busy.
+    // A couple of extra threads cover effects that have to hand off to the main thread to render.
 
-    // CAUTION ... if this results in a value < 20 then it will set it to 20. If > 250 then it will set it to 250 ... that is not obvious until you step into the code
-    jobPool.Start(wxThread::GetCPUCount() * 7);
+    // CAUTION ... if this results in a value < 4 then it will set it to 4. If > 250 then it will set it to 250 ... that is not obvious until you step into the code
+    jobPool.Start(wxThread::GetCPUCount() + 2, 4);
 
     if (!xLightsApp::sequenceFiles.IsEmpty())
     {
@@ -1940,6 +1980,10 @@ xLightsFrame::~xLightsFrame()
     config->Write("xLightsBackupSubdirectories", _backupSubfolders);
     config->Write("xLightsExcludePresetsPkgSeq", _excludePresetsFromPackagedSequences);
     config->Write("xLightsExcludeAudioPkgSeq", _excludeAudioFromPackagedSequences);
+    config->Write("xLightsCompressedFSEQ", _compressedFSEQ);
+    config->Write("xLightsRenderCache", _renderCache.IsEnabled());
+    config->Write("xLightsPersistRenderCache", _persistRenderCache);
+    config->Write("xLightsRenderCacheMB", _renderCacheMB);
     config->Write("xLightsShowACLights", _showACLights);
     config->Write("xLightsShowACRamps", _showACRamps);
     config->Write("xLightsPlayControlsOnPreview", _playControlsOnPreview);
@@ -5343,7 +5387,8 @@ void xLightsFrame::CheckSequence(bool display)
 void xLightsFrame::CheckEffect(Effect* ef, wxFile& f, int& errcount, int& warncount, const std::string& name, const std::string& modelName, bool node)
 {
     EffectManager& em = mSequenceElements.GetEffectManager();
-    SettingsMap& sm = ef->GetSettings();
+    // only reading so dont take the effect's own copy of settings it shares with other effects
+    const SettingsMap& sm = static_cast<const Effect*>(ef)->GetSettings();
 
     // check excessive fadein/fadeout time
     float fadein = sm.GetFloat("T_TEXTCTRL_Fadein", 0.0);
@@ -5564,7 +5609,7 @@ int xLightsFrame::ExportNodes(wxFile& f, StrandElement* e, NodeLayer* nl, int n,
 
     for (int k = 0; k < nl->GetEffectCount(); k++)
     {
-        Effect* ef = nl->GetEffect(k);
+        const Effect* ef = nl->GetEffect(k);
 
         std::string fs = "";
         if (ef->GetEffectIndex() >= 0)
@@ -5596,7 +5641,7 @@ int xLightsFrame::ExportNodes(wxFile& f, StrandElement* e, NodeLayer* nl, int n,
             effectTotalTime[ef->GetEffectName()] = duration;
         }
 
-        SettingsMap& sm = ef->GetSettings();
+        const SettingsMap& sm = ef->GetSettings();
         f.Write(wxString::Format("\"%s\",%02d:%02d.%03d,%02d:%02d.%03d,%02d:%02d.%03d,\"%s\",\"%s\",%s,%s\n",
             ef->GetEffectName(),
             ef->GetStartTimeMS() / 60000,
@@ -5659,7 +5704,7 @@ int xLightsFrame::ExportElement(wxFile& f, Element* e, std::map<std::string, int
 
             for (int k = 0; k < el->GetEffectCount(); k++)
             {
-                Effect* ef = el->GetEffect(k);
+                const Effect* ef = el->GetEffect(k);
                 std::string fs = "";
                 if (ef->GetEffectIndex() >= 0)
                 {
@@ -5690,7 +5735,7 @@ int xLightsFrame::ExportElement(wxFile& f, Element* e, std::map<std::string, int
                     effectTotalTime[ef->GetEffectName()] = duration;
                 }
 
-                SettingsMap& sm = ef->GetSettings();
+                const SettingsMap& sm = ef->GetSettings();
                 f.Write(wxString::Format("\"%s\",%02d:%02d.%03d,%02d:%02d.%03d,%02d:%02d.%03d,\"%s\",\"%s\",%s,%s\n",
                     ef->GetEffectName(),
                     ef->GetStartTimeMS() / 60000,
@@ -6299,6 +6344,46 @@ void xLightsFrame::OnMenuItem_ExcludeAudioPackagedSequenceSelected(wxCommandEven
     _excludeAudioFromPackagedSequences = MenuItem_ExcludeAudioPackagedSequence->IsChecked();
 }
 
+void xLightsFrame::OnMenuItem_CompressedFSEQSelected(wxCommandEvent& event)
+{
+    _compressedFSEQ = MenuItem_CompressedFSEQ->IsChecked();
+}
+
+void xLightsFrame::OnMenuItem_RenderCacheSelected(wxCommandEvent& event)
+{
+    _renderCache.Enable(MenuItem_RenderCache->IsChecked());
+    MenuItem_PersistRenderCache->Enable(_renderCache.IsEnabled());
+    MenuItem_RenderCacheSize->Enable(_renderCache.IsEnabled());
+}
+
+void xLightsFrame::OnMenuItem_RenderCacheSizeSelected(wxCommandEvent& event)
+{
+    long mb = wxGetNumberFromUser("Memory the render cache can use before it drops the least recently used effects.", "Megabytes", "Render Cache Memory Size", _renderCacheMB, 16, 65536, this);
+    if (mb > 0)
+    {
+        _renderCacheMB = mb;
+        _renderCache.SetMaxMemoryMB(_renderCacheMB);
+    }
+}
+
+void xLightsFrame::OnMenuItem_PersistRenderCacheSelected(wxCommandEvent& event)
+{
+    _persistRenderCache = MenuItem_PersistRenderCache->IsChecked();
+    SetRenderCacheFolder();
+}
+
+void xLightsFrame::SetRenderCacheFolder()
+{
+    if (_persistRenderCache && showDirectory != "")
+    {
+        _renderCache.SetFolder((showDirectory + wxFileName::GetPathSeparator() + "RenderCache").ToStdString());
+    }
+    else
+    {
+        _renderCache.SetFolder("");
+    }
+}
+
 void xLightsFrame::ShowACLights()
 {
     wxAuiPaneInfo& tb = MainAuiManager->GetPane(_T("ACToolbar"));
@@ -63,6 +63,7 @@
 #include "ModelPreview.h"
 #include "EffectAssist.h"
 #include "SequenceData.h"
+#include "RenderCache.h"
 #include "PhonemeDictionary.h"
 
 #include "sequencer/EffectsGrid.h"
@@ -490,6 +491,10 @@ public:
     void OnMenuItem_VideoTutorialsSelected(wxCommandEvent& event);
     void OnMenuItem_ExcludePresetsFromPackagedSequencesSelected(wxCommandEvent& event);
     void OnMenuItem_ExcludeAudioPackagedSequenceSelected(wxCommandEvent& event);
+    void OnMenuItem_CompressedFSEQSelected(wxCommandEvent& event);
+    void OnMenuItem_RenderCacheSelected(wxCommandEvent& event);
+    void OnMenuItem_PersistRenderCacheSelected(wxCommandEvent& event);
+    void OnMenuItem_RenderCacheSizeSelected(wxCommandEvent& event);
     void OnMenuItemColorManagerSelected(wxCommandEvent& event);
     void OnMenuItem_DonateSelected(wxCommandEvent& event);
     void OnMenuItemTimingPlayOnDClick(wxCommandEvent& event);
@@ -711,6 +716,10 @@ private:
     static const long ID_MNU_BACKUP;
     static const long ID_MNU_EXCLUDEPRESETS;
     static const long ID_MNU_EXCLUDEAUDIOPKGSEQ;
+    static const long ID_MNU_COMPRESSEDFSEQ;
+    static const long ID_MNU_RENDERCACHE;
+    static const long ID_MNU_PERSISTRENDERCACHE;
+    static const long ID_MNU_RENDERCACHESIZE;
     static const long ID_MENUITEM_ICON_SMALL;
     static const long ID_MENUITEM_ICON_MEDIUM;
     static const long ID_MENUITEM_ICON_LARGE;
@@ -884,6 +893,10 @@ private:
     wxMenuItem* MenuItem_Donate;
     wxMenuItem* MenuItem_DownloadSequences;
     wxMenuItem* MenuItem_ExcludeAudioPackagedSequence;
+    wxMenuItem* MenuItem_CompressedFSEQ;
+    wxMenuItem* MenuItem_RenderCache;
+    wxMenuItem* MenuItem_PersistRenderCache;
+    wxMenuItem* MenuItem_RenderCacheSize;
     wxMenuItem* MenuItem_ExcludePresetsFromPackagedSequences;
     wxMenuItem* MenuItem_ExportEffects;
     wxMenuItem* MenuItem_FPP_Connect;
@@ -997,6 +1010,11 @@ private:
     bool _backupSubfolders;
     bool _excludePresetsFromPackagedSequences;
     bool _excludeAudioFromPackagedSequences;
+    bool _compressedFSEQ;
+    bool _persistRenderCache;
+    int _renderCacheMB;
+    RenderCache _renderCache;
+    void SetRenderCacheFolder();
     bool _showACLights;
     bool _showACRamps;
     bool _playControlsOnPreview;
@@ -1100,7 +1118,9 @@ public:
     void ReadXlightsFile(const wxString& FileName, wxString *mediaFilename = nullptr);
     void ReadFalconFile(const wxString& FileName, ConvertDialog* convertdlg);
     void WriteFalconPiFile(const wxString& filename); //  Falcon Pi Player *.pseq
+    void WriteFalconPiV2File(const wxString& filename); //  Falcon Pi Player compressed v2 *.fseq
     OutputManager* GetOutputManager() { return &_outputManager; };
+    RenderCache* GetRenderCache() { return &_renderCache; }
 
 private:
 
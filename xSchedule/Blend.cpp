@@ -1,21 +1,443 @@
 #include "Blend.h"
 
-//#define SIMD
+#include <log4cpp/Category.hh>
+#include <wx/stopwatch.h>
+#include <algorithm>
+#include <vector>
+
+// SSE2 is always available on 64 bit intel so we only need to check for AVX2 at runtime.
+// Anything else uses the scalar versions.
+#if defined(__x86_64__) || defined(_M_X64)
+#define BLEND_SIMD
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BLEND_AVX2
+#else
+#define BLEND_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+typedef void (*BlendKernel)(wxByte* buffer, const wxByte* blendBuffer, size_t count);
+
+// One implementation of each blend mode. The pixel modes take a pixel count, the rest take a channel count.
+class BlendKernels
+{
+public:
+    const char* name;
+    BlendKernel overwriteIfZero;
+    BlendKernel mask;
+    BlendKernel unmask;
+    BlendKernel average;
+    BlendKernel maximum;
+    BlendKernel minimum;
+    BlendKernel overwriteIfBlack;
+    BlendKernel maskPixel;
+    BlendKernel unmaskPixel;
+};
+
+#pragma region Scalar
+static void OverwriteIfZeroScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        if (*(buffer + i) == 0x00)
+        {
+            *(buffer + i) = *(blendBuffer + i);
+        }
+    }
+}
+
+static void MaskScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        if (*(blendBuffer + i) > 0)
+        {
+            *(buffer + i) = 0x00;
+        }
+    }
+}
+
+static void UnmaskScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        if (*(blendBuffer + i) == 0)
+        {
+            *(buffer + i) = 0x00;
+        }
+    }
+}
+
+static void AverageScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        *(buffer + i) = (wxByte)(((int)*(buffer + i) + (int)*(blendBuffer + i)) / 2);
+    }
+}
+
+static void MaximumScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        *(buffer + i) = std::max(*(buffer + i), *(blendBuffer + i));
+    }
+}
+
+static void MinimumScalar(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    for (size_t i = 0; i < channels; ++i)
+    {
+        *(buffer + i) = std::min(*(buffer + i), *(blendBuffer + i));
+    }
+}
+
+static void OverwriteIfBlackScalar(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        wxByte* p = buffer + i * 3;
+        auto sum = *p + *(p + 1) + *(p + 2);
+        if (sum == 0)
+        {
+            const wxByte* pp = blendBuffer + i * 3;
+            *p = *pp;
+            *(p + 1) = *(pp + 1);
+            *(p + 2) = *(pp + 2);
+        }
+    }
+}
+
+static void MaskPixelScalar(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        const wxByte* p = blendBuffer + i * 3;
+        auto sum = *p + *(p + 1) + *(p + 2);
+        if (sum > 0)
+        {
+            wxByte* pp = buffer + i * 3;
+            *pp = 0x00;
+            *(pp + 1) = 0x00;
+            *(pp + 2) = 0x00;
+        }
+    }
+}
+
+static void UnmaskPixelScalar(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        const wxByte* p = blendBuffer + i * 3;
+        auto sum = *p + *(p + 1) + *(p + 2);
+        if (sum == 0)
+        {
+            wxByte* pp = buffer + i * 3;
+            *pp = 0x00;
+            *(pp + 1) = 0x00;
+            *(pp + 2) = 0x00;
+        }
+    }
+}
+
+static const BlendKernels __scalarKernels = { "Scalar", OverwriteIfZeroScalar, MaskScalar, UnmaskScalar, AverageScalar, MaximumScalar, MinimumScalar, OverwriteIfBlackScalar, MaskPixelScalar, UnmaskPixelScalar };
+#pragma endregion Scalar
+
+#ifdef BLEND_SIMD
+#pragma region SSE2
+// unaligned loads cost nothing extra on any cpu with AVX and very little on older ones so we dont try to align the buffers
+#define LOAD128(p) _mm_loadu_si128((const __m128i*)(p))
+#define STORE128(p, v) _mm_storeu_si128((__m128i*)(p), v)
+
+static void OverwriteIfZeroSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i b = LOAD128(buffer + i);
+        __m128i bb = LOAD128(blendBuffer + i);
+        __m128i mask = _mm_cmpeq_epi8(b, zero); // sets FF where B is zero
+        STORE128(buffer + i, _mm_or_si128(b, _mm_and_si128(mask, bb)));
+    }
+    OverwriteIfZeroScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+static void MaskSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i b = LOAD128(buffer + i);
+        __m128i mask = _mm_cmpeq_epi8(LOAD128(blendBuffer + i), zero); // sets FF where BB is zero
+        STORE128(buffer + i, _mm_and_si128(mask, b));
+    }
+    MaskScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+static void UnmaskSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i b = LOAD128(buffer + i);
+        __m128i mask = _mm_cmpeq_epi8(LOAD128(blendBuffer + i), zero); // sets FF where BB is zero
+        STORE128(buffer + i, _mm_andnot_si128(mask, b));
+    }
+    UnmaskScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+static void AverageSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i b = LOAD128(buffer + i);
+        __m128i bb = LOAD128(blendBuffer + i);
+        // avg rounds up but we have always rounded down so take off the odd bit
+        __m128i r = _mm_sub_epi8(_mm_avg_epu8(b, bb), _mm_and_si128(_mm_xor_si128(b, bb), one));
+        STORE128(buffer + i, r);
+    }
+    AverageScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+static void MaximumSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        STORE128(buffer + i, _mm_max_epu8(LOAD128(buffer + i), LOAD128(blendBuffer + i)));
+    }
+    MaximumScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+static void MinimumSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+    for (; i + 16 <= channels; i += 16)
+    {
+        STORE128(buffer + i, _mm_min_epu8(LOAD128(buffer + i), LOAD128(blendBuffer + i)));
+    }
+    MinimumScalar(buffer + i, blendBuffer + i, channels - i);
+}
+
+// Works on 16 pixels (48 bytes, exactly 3 registers) at a time and sets every byte of black pixels to FF.
+// A pixel is black if the byte it starts on and the two after it are all zero. We work that out at the
+// first byte of each pixel and then copy the answer into the other two bytes.
+static inline void BlackPixelsSSE2(const wxByte* p, __m128i black[3])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i starts[3] = {
+        _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1),
+        _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0),
+        _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0) };
+
+    __m128i z[4];
+    for (int i = 0; i < 3; ++i)
+    {
+        z[i] = _mm_cmpeq_epi8(LOAD128(p + i * 16), zero);
+    }
+    z[3] = zero; // no pixel starting in the block runs past the end of it
+
+    __m128i s[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        __m128i next1 = _mm_or_si128(_mm_srli_si128(z[i], 1), _mm_slli_si128(z[i + 1], 15));
+        __m128i next2 = _mm_or_si128(_mm_srli_si128(z[i], 2), _mm_slli_si128(z[i + 1], 14));
+        s[i] = _mm_and_si128(_mm_and_si128(z[i], starts[i]), _mm_and_si128(next1, next2));
+    }
+
+    __m128i prev = zero;
+    for (int i = 0; i < 3; ++i)
+    {
+        __m128i prev1 = _mm_or_si128(_mm_slli_si128(s[i], 1), _mm_srli_si128(prev, 15));
+        __m128i prev2 = _mm_or_si128(_mm_slli_si128(s[i], 2), _mm_srli_si128(prev, 14));
+        black[i] = _mm_or_si128(s[i], _mm_or_si128(prev1, prev2));
+        prev = s[i];
+    }
+}
+
+static void OverwriteIfBlackSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    __m128i black[3];
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        wxByte* p = buffer + i * 3;
+        const wxByte* pp = blendBuffer + i * 3;
+        BlackPixelsSSE2(p, black);
+        for (int j = 0; j < 3; ++j)
+        {
+            __m128i r = _mm_or_si128(_mm_andnot_si128(black[j], LOAD128(p + j * 16)), _mm_and_si128(black[j], LOAD128(pp + j * 16)));
+            STORE128(p + j * 16, r);
+        }
+    }
+    OverwriteIfBlackScalar(buffer + i * 3, blendBuffer + i * 3, pixels - i);
+}
+
+static void MaskPixelSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    __m128i black[3];
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        wxByte* p = buffer + i * 3;
+        BlackPixelsSSE2(blendBuffer + i * 3, black);
+        for (int j = 0; j < 3; ++j)
+        {
+            STORE128(p + j * 16, _mm_and_si128(black[j], LOAD128(p + j * 16)));
+        }
+    }
+    MaskPixelScalar(buffer + i * 3, blendBuffer + i * 3, pixels - i);
+}
 
-#ifdef SIMD
-#include "emmintrin.h"
-#define ALIGNMENT (128 / 8)
+static void UnmaskPixelSSE2(wxByte* buffer, const wxByte* blendBuffer, size_t pixels)
+{
+    __m128i black[3];
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        wxByte* p = buffer + i * 3;
+        BlackPixelsSSE2(blendBuffer + i * 3, black);
+        for (int j = 0; j < 3; ++j)
+        {
+            STORE128(p + j * 16, _mm_andnot_si128(black[j], LOAD128(p + j * 16)));
+        }
+    }
+    UnmaskPixelScalar(buffer + i * 3, blendBuffer + i * 3, pixels - i);
+}
+
+static const BlendKernels __sse2Kernels = { "SSE2", OverwriteIfZeroSSE2, MaskSSE2, UnmaskSSE2, AverageSSE2, MaximumSSE2, MinimumSSE2, OverwriteIfBlackSSE2, MaskPixelSSE2, UnmaskPixelSSE2 };
+#pragma endregion SSE2
+
+#pragma region AVX2
+// AVX2 byte shifts dont cross the two 128 bit lanes so the pixel modes stay on SSE2
+#define LOAD256(p) _mm256_loadu_si256((const __m256i*)(p))
+#define STORE256(p, v) _mm256_storeu_si256((__m256i*)(p), v)
 
-int GetMisalignedBytes(wxByte* b1, wxByte* b2)
+BLEND_AVX2 static void OverwriteIfZeroAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
 {
-    int m1 = (size_t)b1 % ALIGNMENT;
-    int m2 = (size_t)b2 % ALIGNMENT;
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        __m256i b = LOAD256(buffer + i);
+        __m256i mask = _mm256_cmpeq_epi8(b, zero);
+        STORE256(buffer + i, _mm256_or_si256(b, _mm256_and_si256(mask, LOAD256(blendBuffer + i))));
+    }
+    OverwriteIfZeroSSE2(buffer + i, blendBuffer + i, channels - i);
+}
+
+BLEND_AVX2 static void MaskAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        __m256i mask = _mm256_cmpeq_epi8(LOAD256(blendBuffer + i), zero);
+        STORE256(buffer + i, _mm256_and_si256(mask, LOAD256(buffer + i)));
+    }
+    MaskSSE2(buffer + i, blendBuffer + i, channels - i);
+}
 
-    if (m1 == m2) return m1;
-    return -1;
+BLEND_AVX2 static void UnmaskAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        __m256i mask = _mm256_cmpeq_epi8(LOAD256(blendBuffer + i), zero);
+        STORE256(buffer + i, _mm256_andnot_si256(mask, LOAD256(buffer + i)));
+    }
+    UnmaskSSE2(buffer + i, blendBuffer + i, channels - i);
+}
+
+BLEND_AVX2 static void AverageAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        __m256i b = LOAD256(buffer + i);
+        __m256i bb = LOAD256(blendBuffer + i);
+        __m256i r = _mm256_sub_epi8(_mm256_avg_epu8(b, bb), _mm256_and_si256(_mm256_xor_si256(b, bb), one));
+        STORE256(buffer + i, r);
+    }
+    AverageSSE2(buffer + i, blendBuffer + i, channels - i);
+}
+
+BLEND_AVX2 static void MaximumAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        STORE256(buffer + i, _mm256_max_epu8(LOAD256(buffer + i), LOAD256(blendBuffer + i)));
+    }
+    MaximumSSE2(buffer + i, blendBuffer + i, channels - i);
+}
+
+BLEND_AVX2 static void MinimumAVX2(wxByte* buffer, const wxByte* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        STORE256(buffer + i, _mm256_min_epu8(LOAD256(buffer + i), LOAD256(blendBuffer + i)));
+    }
+    MinimumSSE2(buffer + i, blendBuffer + i, channels - i);
+}
+
+static const BlendKernels __avx2Kernels = { "AVX2", OverwriteIfZeroAVX2, MaskAVX2, UnmaskAVX2, AverageAVX2, MaximumAVX2, MinimumAVX2, OverwriteIfBlackSSE2, MaskPixelSSE2, UnmaskPixelSSE2 };
+#pragma endregion AVX2
+
+static bool HasAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // the OS must also be saving the AVX registers
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 0x06) != 0x06) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
 }
 #endif
 
+static const BlendKernels* ChooseBlendKernels()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    const BlendKernels* kernels = &__scalarKernels;
+#ifdef BLEND_SIMD
+    kernels = HasAVX2() ? &__avx2Kernels : &__sse2Kernels;
+#endif
+    logger_base.info("Blending using %s.", kernels->name);
+    return kernels;
+}
+
+static const BlendKernels* GetBlendKernels()
+{
+    static const BlendKernels* kernels = ChooseBlendKernels();
+    return kernels;
+}
+
+std::string GetBlendInstructionSet()
+{
+    return GetBlendKernels()->name;
+}
+
 void PopulateBlendModes(wxChoice* choice)
 {
     choice->AppendString("Overwrite");
@@ -139,6 +561,7 @@ void Blend(wxByte* buffer, size_t bufferSize, wxByte* blendBuffer, size_t blendB
     }
 }
 
+
 void Overwrite(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
     memcpy(buffer, blendBuffer, channels);
@@ -146,331 +569,118 @@ void Overwrite(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 
 void OverwriteIfZero(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(buffer + i) == 0x00)
-            {
-                *(buffer + i) = *(blendBuffer + i);
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(b, zero); // sets FF where B is zero
-            __m128i newv = _mm_and_si128(mask, bb); // grab bb where B has zero
-            __m128i r = _mm_or_si128(b, newv); // merge them
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(buffer + offset) == 0)
-            {
-                *(buffer + offset) = *(blendBuffer + offset);
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(buffer + i) == 0x00)
-            {
-                *(buffer + i) = *(blendBuffer + i);
-            }
-        }
-    }
+    GetBlendKernels()->overwriteIfZero(buffer, blendBuffer, channels);
 }
 
 void Mask(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(blendBuffer + i) > 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(bb, zero); // sets FF where BB is zero
-            __m128i r = _mm_and_si128(mask, b); // and the mask
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(blendBuffer + offset) > 0)
-            {
-                *(buffer + offset) = 0x00;
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(blendBuffer + i) > 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-    }
+    GetBlendKernels()->mask(buffer, blendBuffer, channels);
 }
 
 void MaskPixel(wxByte* buffer, wxByte* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        wxByte* p = blendBuffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum > 0)
-        {
-            wxByte* pp = buffer + i * 3;
-            *pp = 0x00;
-            *(pp + 1) = 0x00;
-            *(pp + 2) = 0x00;
-        }
-    }
+    GetBlendKernels()->maskPixel(buffer, blendBuffer, pixels);
 }
 
 void Unmask(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(blendBuffer + i) == 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(bb, zero); // sets FF where BB is zero
-            __m128i r = _mm_andnot_si128(mask, b); // invert the mask and then and it
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(blendBuffer + offset) == 0)
-            {
-                *(buffer + offset) = 0x00;
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(blendBuffer + i) == 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-    }
+    GetBlendKernels()->unmask(buffer, blendBuffer, channels);
 }
 
 void UnmaskPixel(wxByte* buffer, wxByte* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        wxByte* p = blendBuffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum == 0)
-        {
-            wxByte* pp = buffer + i * 3;
-            *pp = 0x00;
-            *(pp + 1) = 0x00;
-            *(pp + 2) = 0x00;
-        }
-    }
+    GetBlendKernels()->unmaskPixel(buffer, blendBuffer, pixels);
 }
 
 void Average(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = (wxByte)(((int)*(buffer + i) + (int)*(blendBuffer + i)) / 2);
-        }
-
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_avg_epu8(b, bb);
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = (wxByte)(((int)*(buffer + offset) + (int)*(blendBuffer + offset)) / 2);
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = (wxByte)(((int)*(buffer + i) + (int)*(blendBuffer + i)) / 2);
-        }
-    }
+    GetBlendKernels()->average(buffer, blendBuffer, channels);
 }
 
 void Maximum(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = std::max(*(buffer + i), *(blendBuffer + i));
-        }
-
-        // do the aligned pieces using SIMD instructions ... up to 16 times faster
-        int simd = (channels - misaligned) / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_max_epu8(b, bb);
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-                                }
-
-        // do the residual part at the end where we dont have enough bytes to process
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = std::max(*(buffer + offset), *(blendBuffer + offset));
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = std::max(*(buffer + i), *(blendBuffer + i));
-        }
-    }
+    GetBlendKernels()->maximum(buffer, blendBuffer, channels);
 }
 
 void Minimum(wxByte* buffer, wxByte* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = std::min(*(buffer + i), *(blendBuffer + i));
-        }
-
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_min_epu8(b, bb);
+    GetBlendKernels()->minimum(buffer, blendBuffer, channels);
+}
 
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
+void OverwriteIfBlack(wxByte* buffer, wxByte* blendBuffer, size_t pixels)
+{
+    GetBlendKernels()->overwriteIfBlack(buffer, blendBuffer, pixels);
+}
 
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = std::min(*(buffer + offset), *(blendBuffer + offset));
-        }
-    }
-    else
+#pragma region Benchmark
+std::string BlendBenchmark(size_t channels, int iterations)
+{
+    std::vector<const BlendKernels*> sets;
+    sets.push_back(&__scalarKernels);
+#ifdef BLEND_SIMD
+    sets.push_back(&__sse2Kernels);
+    if (HasAVX2()) sets.push_back(&__avx2Kernels);
 #endif
+
+    // roughly half the channels are zero and one pixel in four is black so every path through the modes is exercised
+    channels -= channels % 3;
+    std::vector<wxByte> buffer(channels);
+    std::vector<wxByte> blendBuffer(channels);
+    for (size_t i = 0; i < channels; ++i)
     {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = std::min(*(buffer + i), *(blendBuffer + i));
-        }
+        buffer[i] = ((i * 7919) % 13 < 6 || (i / 3) % 4 == 0) ? 0 : (wxByte)((i * 31) % 256);
+        blendBuffer[i] = ((i * 104729) % 11 < 5 || (i / 3) % 4 == 1) ? 0 : (wxByte)((i * 17) % 256);
     }
-}
+    std::vector<wxByte> expected(channels);
+    std::vector<wxByte> work(channels);
 
-void OverwriteIfBlack(wxByte* buffer, wxByte* blendBuffer, size_t pixels)
-{
-    for (size_t i = 0; i < pixels; ++i)
+    std::string res = wxString::Format("Blending %d channels %d times using %s.\n", (int)channels, iterations, GetBlendInstructionSet()).ToStdString();
+
+    const char* modes[] = { "Overwrite if zero", "Mask out if not zero", "Mask out if zero", "Average", "Maximum", "Minimum", "Overwrite if black", "Mask out if not black", "Mask out if black" };
+    for (int m = 0; m < 9; ++m)
     {
-        wxByte* p = buffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum == 0)
+        res += wxString::Format("%s:", modes[m]).ToStdString();
+        bool pixelMode = m >= 6;
+        long scalarTime = 0;
+        for (auto it = sets.begin(); it != sets.end(); ++it)
         {
-            wxByte* pp = blendBuffer + i * 3;
-            *p = *pp;
-            *(p + 1) = *(pp + 1);
-            *(p + 2) = *(pp + 2);
+            BlendKernel kernels[] = { (*it)->overwriteIfZero, (*it)->mask, (*it)->unmask, (*it)->average, (*it)->maximum, (*it)->minimum, (*it)->overwriteIfBlack, (*it)->maskPixel, (*it)->unmaskPixel };
+            BlendKernel kernel = kernels[m];
+            size_t count = pixelMode ? channels / 3 : channels;
+
+            // check we get the same answer as the scalar code
+            work = buffer;
+            kernel(&work[0], &blendBuffer[0], count);
+            if (*it == &__scalarKernels)
+            {
+                expected = work;
+            }
+            bool same = work == expected;
+
+            // blending the result again takes the same time so we dont reset the buffer between runs
+            wxStopWatch sw;
+            for (int i = 0; i < iterations; ++i)
+            {
+                kernel(&work[0], &blendBuffer[0], count);
+            }
+            long time = sw.TimeInMicro().ToLong() / iterations;
+            if (*it == &__scalarKernels)
+            {
+                scalarTime = time;
+                res += wxString::Format(" %s %ldus", (*it)->name, time).ToStdString();
+            }
+            else
+            {
+                res += wxString::Format(" %s %ldus (%.1fx)", (*it)->name, time, time == 0 ? 0.0 : (double)scalarTime / time).ToStdString();
+            }
+            if (!same)
+            {
+                res += " RESULTS DIFFER";
+            }
         }
+        res += "\n";
     }
+
+    return res;
 }
+#pragma endregion Benchmark
@@ -37,4 +37,9 @@ void UnmaskPixel(wxByte* buffer, wxByte* blendBuffer, size_t pixels);
 APPLYMETHOD EncodeBlendMode(const std::string blendMode);
 std::string DecodeBlendMode(APPLYMETHOD blendMode);
 
+// the instruction set the blend modes are using on this machine
+std::string GetBlendInstructionSet();
+// times every blend mode with each instruction set this machine supports and returns a report
+std::string BlendBenchmark(size_t channels = 500000, int iterations = 100);
+
 #endif
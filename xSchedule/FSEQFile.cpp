@@ -3,38 +3,81 @@
 #include <log4cpp/Category.hh>
 #include <wx/filename.h>
 #include "../xLights/UtilFunctions.h"
+#include "../xLights/FSEQv2.h"
 
-FSEQFile::FSEQFile()
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class FSEQReadAheadThread : public wxThread
+{
+    FSEQFile* _fseq;
+    bool _stop;
+
+public:
+    FSEQReadAheadThread(FSEQFile* fseq) : wxThread(wxTHREAD_JOINABLE)
+    {
+        _fseq = fseq;
+        _stop = false;
+    }
+
+    // must be called holding the read ahead lock so the thread cant miss it
+    void Stop()
+    {
+        _stop = true;
+    }
+
+    virtual void* Entry() override
+    {
+        while (!_stop)
+        {
+            _fseq->FillReadAhead(_stop);
+        }
+        return nullptr;
+    }
+};
+
+void FSEQFile::Init()
 {
     _audiofilename = "";
     _channelsPerFrame = 0;
-    _filename = "";
     _frameMS = 0;
     _frames = 0;
     _fh = nullptr;
     _frameBuffer = nullptr;
+    _v2Reader = nullptr;
     _minorVersion = 0;
     _majorVersion = 0;
     _colourEncoding = 0;
     _gamma = 255;
     _frame0Offset = 0;
+    _mapped = nullptr;
+    _mappedSize = 0;
+#ifdef __WXMSW__
+    _mapHandle = nullptr;
+#endif
+    _readAheadThread = nullptr;
+    _lastRequestedFrame = -1;
+    _underruns = 0;
+    _framesRequested = 0;
+}
+
+FSEQFile::FSEQFile()
+{
+    Init();
+    _filename = "";
     _ok = false;
 }
 
 FSEQFile::FSEQFile(const std::string& filename)
 {
-    _audiofilename = "";
-    _channelsPerFrame = 0;
+    Init();
     _filename = FixFile("", filename);
-    _frameMS = 0;
-    _frames = 0;
-    _fh = nullptr;
-    _frameBuffer = nullptr;
-    _minorVersion = 0;
-    _majorVersion = 0;
-    _colourEncoding = 0;
-    _gamma = 255;
-    _frame0Offset = 0;
     _ok = true;
     Load(filename);
 }
@@ -53,6 +96,9 @@ FSEQFile::~FSEQFile()
 
 void FSEQFile::Close()
 {
+    StopReadAhead();
+    UnmapFile();
+
     if (_fh != nullptr)
     {
         _fh->Close();
@@ -60,7 +106,22 @@ void FSEQFile::Close()
         _fh = nullptr;
 
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-        logger_base.info("FSEQ file %s closed.", (const char *)_filename.c_str());
+        if (_framesRequested > 0)
+        {
+            logger_base.info("FSEQ file %s closed. Read ahead underruns %ld of %ld frames.", (const char *)_filename.c_str(), (long)_underruns, (long)_framesRequested);
+        }
+        else
+        {
+            logger_base.info("FSEQ file %s closed.", (const char *)_filename.c_str());
+        }
+        _underruns = 0;
+        _framesRequested = 0;
+    }
+
+    if (_v2Reader != nullptr)
+    {
+        delete _v2Reader;
+        _v2Reader = nullptr;
     }
 
     if (_frameBuffer != nullptr)
@@ -113,6 +174,34 @@ void FSEQFile::Load(const std::string& filename)
             _frame0Offset = ReadInt16(_fh);
             _fh->Read(&_minorVersion, sizeof(_minorVersion));
             _fh->Read(&_majorVersion, sizeof(_majorVersion));
+
+            if (_majorVersion == 2)
+            {
+                // compressed file ... the v2 reader does all the work
+                _fh->Close();
+                _v2Reader = new FSEQv2Reader();
+                if (_v2Reader->Open(_filename))
+                {
+                    _channelsPerFrame = _v2Reader->GetChannels();
+                    _frames = _v2Reader->GetFrames();
+                    _frameMS = _v2Reader->GetStepTime();
+                    if (_v2Reader->GetMediaFilename() != "")
+                    {
+                        _audiofilename = FixFile("", _v2Reader->GetMediaFilename());
+                    }
+                    _frameBuffer = (wxByte*)calloc(_channelsPerFrame, 1);
+
+                    logger_base.info("FSEQ v2 file %s opened.", (const char *)_filename.c_str());
+                    _ok = true;
+                }
+                else
+                {
+                    logger_base.error("FSEQ v2 file %s could not be read.", (const char *)_filename.c_str());
+                    Close();
+                }
+                return;
+            }
+
             int fixedheader = ReadInt16(_fh); // fixed header length
             _channelsPerFrame = ReadInt32(_fh);
             _frames = ReadInt32(_fh);
@@ -154,18 +243,241 @@ void FSEQFile::Load(const std::string& filename)
     }
 }
 
+void FSEQFile::EnableReadAhead(size_t frames, bool memoryMap)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_ok || _readAheadThread != nullptr || frames == 0) return;
+
+    // compressed files are decompressed a block at a time so mapping them gains nothing
+    if (memoryMap && _v2Reader == nullptr)
+    {
+        MapFile();
+    }
+
+    _lastRequestedFrame = -1;
+    _underruns = 0;
+    _framesRequested = 0;
+    for (size_t i = 0; i < frames; i++)
+    {
+        _readAheadBuffers.push_back((wxByte*)calloc(_channelsPerFrame, 1));
+        _readAheadFrames.push_back(-1);
+    }
+
+    _readAheadThread = new FSEQReadAheadThread(this);
+    if (_readAheadThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("FSEQ file %s failed to start read ahead thread.", (const char *)_filename.c_str());
+        delete _readAheadThread;
+        _readAheadThread = nullptr;
+        StopReadAhead();
+        return;
+    }
+
+    logger_base.debug("FSEQ file %s reading ahead %ld frames%s.", (const char *)_filename.c_str(), (long)frames, _mapped != nullptr ? " from memory map" : "");
+}
+
+void FSEQFile::StopReadAhead()
+{
+    if (_readAheadThread != nullptr)
+    {
+        {
+            std::unique_lock<std::mutex> locker(_readAheadLock);
+            _readAheadThread->Stop();
+            _readAheadSignal.notify_all();
+        }
+        _readAheadThread->Wait();
+        delete _readAheadThread;
+        _readAheadThread = nullptr;
+    }
+
+    for (auto it = _readAheadBuffers.begin(); it != _readAheadBuffers.end(); ++it)
+    {
+        free(*it);
+    }
+    _readAheadBuffers.clear();
+    _readAheadFrames.clear();
+}
+
+bool FSEQFile::MapFile()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+#ifdef __WXMSW__
+    HANDLE file = CreateFileW(wxString(_filename).wc_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        logger_base.warn("FSEQ file %s could not be opened for memory mapping.", (const char *)_filename.c_str());
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE map = nullptr;
+    if (GetFileSizeEx(file, &size))
+    {
+        map = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    // the mapping keeps the file open
+    CloseHandle(file);
+    if (map != nullptr)
+    {
+        _mapped = (wxByte*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (_mapped == nullptr)
+    {
+        logger_base.warn("FSEQ file %s could not be memory mapped. Error %d.", (const char *)_filename.c_str(), (int)GetLastError());
+        if (map != nullptr)
+        {
+            CloseHandle(map);
+        }
+        return false;
+    }
+    _mapHandle = map;
+    _mappedSize = (size_t)size.QuadPart;
+#else
+    int fd = open(_filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        logger_base.warn("FSEQ file %s could not be opened for memory mapping.", (const char *)_filename.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            _mapped = (wxByte*)p;
+            _mappedSize = st.st_size;
+            madvise(p, _mappedSize, MADV_SEQUENTIAL);
+        }
+    }
+    // the mapping keeps the file open
+    close(fd);
+    if (_mapped == nullptr)
+    {
+        logger_base.warn("FSEQ file %s could not be memory mapped.", (const char *)_filename.c_str());
+        return false;
+    }
+#endif
+    return true;
+}
+
+void FSEQFile::UnmapFile()
+{
+    if (_mapped == nullptr) return;
+
+#ifdef __WXMSW__
+    UnmapViewOfFile(_mapped);
+    CloseHandle(_mapHandle);
+    _mapHandle = nullptr;
+#else
+    munmap(_mapped, _mappedSize);
+#endif
+    _mapped = nullptr;
+    _mappedSize = 0;
+}
+
+void FSEQFile::ReadFrame(size_t frame, wxByte* buffer)
+{
+    if (_mapped != nullptr)
+    {
+        size_t start = _frame0Offset + _channelsPerFrame * frame;
+        if (start + _channelsPerFrame <= _mappedSize)
+        {
+            memcpy(buffer, _mapped + start, _channelsPerFrame);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> locker(_fileLock);
+    if (_v2Reader != nullptr)
+    {
+        _v2Reader->ReadFrame(frame, buffer, _channelsPerFrame);
+    }
+    else
+    {
+        if (_fh->Tell() != _frame0Offset + _channelsPerFrame * frame)
+        {
+            // we need to seek to our frame
+            _fh->Seek(_frame0Offset + _channelsPerFrame * frame, wxFromStart);
+        }
+
+        // read in the frame from disk
+        _fh->Read(buffer, _channelsPerFrame);
+    }
+}
+
+bool FSEQFile::FillReadAhead(bool& stop)
+{
+    long frame = -1;
+    size_t slot = 0;
+    {
+        std::unique_lock<std::mutex> locker(_readAheadLock);
+        size_t n = _readAheadBuffers.size();
+        for (long f = _lastRequestedFrame + 1; f <= _lastRequestedFrame + (long)n && f < (long)_frames; f++)
+        {
+            if (_readAheadFrames[f % n] != f)
+            {
+                frame = f;
+                slot = f % n;
+                break;
+            }
+        }
+
+        if (frame == -1)
+        {
+            // we are full ... wait for playback to move on
+            if (!stop)
+            {
+                _readAheadSignal.wait(locker);
+            }
+            return false;
+        }
+
+        // mark the slot as being read so ReadData wont use it
+        _readAheadFrames[slot] = -1;
+    }
+
+    ReadFrame(frame, _readAheadBuffers[slot]);
+
+    std::unique_lock<std::mutex> locker(_readAheadLock);
+    _readAheadFrames[slot] = frame;
+    return true;
+}
+
 void FSEQFile::ReadData(wxByte* buffer, size_t buffersize, size_t frame, APPLYMETHOD applyMethod, size_t offset, size_t channels)
 {
     if (frame >= _frames) return; // cant read past end of file
 
-    if (_fh->Tell() != _frame0Offset + _channelsPerFrame * frame)
+    bool found = false;
+    if (_readAheadThread != nullptr)
+    {
+        std::unique_lock<std::mutex> locker(_readAheadLock);
+        size_t slot = frame % _readAheadBuffers.size();
+        _framesRequested++;
+        if (_readAheadFrames[slot] == (long)frame)
+        {
+            memcpy(_frameBuffer, _readAheadBuffers[slot], _channelsPerFrame);
+            found = true;
+        }
+        else
+        {
+            _underruns++;
+            if (_underruns == 1 || _underruns % 100 == 0)
+            {
+                static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+                logger_base.warn("FSEQ file %s read ahead underrun at frame %ld. %ld underruns so far.", (const char *)_filename.c_str(), (long)frame, (long)_underruns);
+            }
+        }
+        _lastRequestedFrame = frame;
+        _readAheadSignal.notify_all();
+    }
+
+    if (!found)
     {
-        // we need to seek to our frame
-        _fh->Seek(_frame0Offset + _channelsPerFrame * frame, wxFromStart);
+        // storage did not keep up or we jumped ... read it ourselves
+        ReadFrame(frame, _frameBuffer);
     }
-    
-    // read in the frame from disk
-    _fh->Read(_frameBuffer, _channelsPerFrame);
 
     if (channels > 0)
     {
@@ -176,4 +488,3 @@ void FSEQFile::ReadData(wxByte* buffer, size_t buffersize, size_t frame, APPLYME
         Blend(buffer, buffersize, _frameBuffer, _channelsPerFrame, applyMethod, offset);
     }
 }
-
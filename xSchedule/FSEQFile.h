@@ -6,7 +6,18 @@
 #include <list>
 #include "Blend.h"
 
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
 class wxFile;
+class FSEQv2Reader;
+class FSEQReadAheadThread;
+
+// default number of frames the read ahead thread keeps ready
+#define FSEQ_READAHEAD_FRAMES 40
+// only memory map on 64 bit where there is address space to spare
+#define FSEQ_READAHEAD_MMAP (sizeof(void*) >= 8)
 
 class FSEQFile
 {
@@ -23,6 +34,33 @@ class FSEQFile
     wxByte _colourEncoding;
     size_t _frame0Offset;
     wxByte* _frameBuffer;
+    FSEQv2Reader* _v2Reader;
+
+    // guards the file handle/reader as both the read ahead thread and ReadData can use them
+    std::mutex _fileLock;
+
+    // memory mapped frame data for uncompressed files
+    wxByte* _mapped;
+    size_t _mappedSize;
+#ifdef __WXMSW__
+    void* _mapHandle;
+#endif
+
+    // read ahead ring ... frame n lives in slot n % size
+    FSEQReadAheadThread* _readAheadThread;
+    std::mutex _readAheadLock;
+    std::condition_variable _readAheadSignal;
+    std::vector<wxByte*> _readAheadBuffers;
+    std::vector<long> _readAheadFrames;
+    long _lastRequestedFrame;
+    size_t _underruns;
+    size_t _framesRequested;
+
+    void Init();
+    bool MapFile();
+    void UnmapFile();
+    void StopReadAhead();
+    void ReadFrame(size_t frame, wxByte* buffer);
 
     public:
 
@@ -42,6 +80,16 @@ class FSEQFile
 		bool IsOk() const { return _ok; }
 		size_t GetChannels() const { return _channelsPerFrame; }
         void Close();
+
+        // start a background thread reading frames ahead of playback, optionally memory mapping the file
+        void EnableReadAhead(size_t frames = FSEQ_READAHEAD_FRAMES, bool memoryMap = FSEQ_READAHEAD_MMAP);
+        bool IsReadAhead() const { return _readAheadThread != nullptr; }
+        bool IsMemoryMapped() const { return _mapped != nullptr; }
+        size_t GetUnderruns() const { return _underruns; }
+        size_t GetFramesRequested() const { return _framesRequested; }
+
+        // called by the read ahead thread ... reads the next missing frame returning false if there was nothing to do
+        bool FillReadAhead(bool& stop);
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "OutputThread.h"
+#include "../xLights/outputs/OutputManager.h"
+#include <log4cpp/Category.hh>
+#include <chrono>
+#include <thread>
+
+#ifdef __LINUX__
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#endif
+
+wxDEFINE_EVENT(EVT_OUTPUTTICK, wxCommandEvent);
+
+const long OutputThread::LatenessBuckets[OUTPUT_LATENESS_BUCKETS] = { 1, 2, 5, 10, 20, 50, 100, -1 };
+
+// how often the lateness histogram is written to the log
+#define OUTPUT_LATENESS_LOG_SECS 60
+
+#pragma region OutputTickQueue
+bool OutputTickQueue::Push(const OutputTick& tick)
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % OUTPUT_TICK_QUEUE_SIZE;
+    if (next == _tail.load(std::memory_order_acquire))
+    {
+        // full ... the UI is not keeping up
+        return false;
+    }
+    _ticks[head] = tick;
+    _head.store(next, std::memory_order_release);
+    return true;
+}
+
+bool OutputTickQueue::Pop(OutputTick& tick)
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    tick = _ticks[tail];
+    _tail.store((tail + 1) % OUTPUT_TICK_QUEUE_SIZE, std::memory_order_release);
+    return true;
+}
+#pragma endregion OutputTickQueue
+
+OutputThread::OutputThread(wxEvtHandler* owner, OutputManager* outputManager, int interval) : wxThread(wxTHREAD_JOINABLE)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _owner = owner;
+    _outputManager = outputManager;
+    _stop = false;
+    _interval = interval;
+    _tickPending = false;
+    _pendingMS = 0;
+    _sendingMS = 0;
+    _pendingReady = false;
+    _framesSent = 0;
+    _framesNotReady = 0;
+    _deadlinesMissed = 0;
+    for (int i = 0; i < OUTPUT_LATENESS_BUCKETS; i++)
+    {
+        _lateness[i] = 0;
+    }
+
+    if (Create() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("Failed to create output thread.");
+        return;
+    }
+    SetPriority(wxPRIORITY_MAX);
+    if (Run() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("Failed to start output thread.");
+    }
+}
+
+void OutputThread::Stop()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!IsRunning()) return;
+
+    logger_base.debug("Asking output thread to stop.");
+    _stop = true;
+    Wait();
+    logger_base.info("Output thread stopped. %s", (const char *)GetLatenessReport().c_str());
+}
+
+void OutputThread::SetInterval(int interval)
+{
+    if (interval < 1) interval = 1;
+    _interval = interval;
+}
+
+void OutputThread::PublishFrame(const wxByte* buffer, size_t size, long msec)
+{
+    std::unique_lock<std::mutex> locker(_frameLock);
+    _pending.assign(buffer, buffer + size);
+    _pendingMS = msec;
+    _pendingReady = true;
+}
+
+void OutputThread::SendFrameNow(const wxByte* buffer, size_t size, long msec)
+{
+    std::unique_lock<std::mutex> sendLocker(_sendLock);
+    PublishFrame(buffer, size, msec);
+    SendFrame();
+}
+
+size_t OutputThread::DrainTicks()
+{
+    // clear this first so a tick queued while we drain still notifies
+    _tickPending = false;
+
+    size_t count = 0;
+    OutputTick tick;
+    while (_ticks.Pop(tick))
+    {
+        count++;
+    }
+    return count;
+}
+
+// the caller must hold _sendLock
+void OutputThread::SendFrame()
+{
+    long msec = 0;
+    {
+        std::unique_lock<std::mutex> locker(_frameLock);
+        if (_pendingReady)
+        {
+            _sending.swap(_pending);
+            msec = _pendingMS;
+            _pendingReady = false;
+        }
+        else
+        {
+            // the UI has not calculated the next frame yet ... send the last one again so the lights keep getting refreshed
+            // at the frame rate the same way the old timer did when it output on every second tick
+            _framesNotReady++;
+            msec = _sendingMS;
+        }
+    }
+
+    if (_sending.size() == 0) return;
+
+    // outputs must not be started or stopped while we are part way through a frame
+    _outputManager->LockOutput();
+    if (_outputManager->IsOutputting())
+    {
+        _outputManager->StartFrame(msec);
+        _outputManager->SetManyChannels(0, &_sending[0], _sending.size());
+        _outputManager->EndFrame();
+        _framesSent++;
+    }
+    _outputManager->UnlockOutput();
+    _sendingMS = msec;
+}
+
+void OutputThread::RecordLateness(long lateMS)
+{
+    for (int i = 0; i < OUTPUT_LATENESS_BUCKETS - 1; i++)
+    {
+        if (lateMS < LatenessBuckets[i])
+        {
+            _lateness[i]++;
+            return;
+        }
+    }
+    _lateness[OUTPUT_LATENESS_BUCKETS - 1]++;
+}
+
+std::string OutputThread::GetLatenessReport() const
+{
+    std::string res = wxString::Format("Frames sent %ld, resent as not ready %ld, deadlines missed %ld. Lateness:", (long)_framesSent, (long)_framesNotReady, (long)_deadlinesMissed).ToStdString();
+    for (int i = 0; i < OUTPUT_LATENESS_BUCKETS; i++)
+    {
+        if (LatenessBuckets[i] < 0)
+        {
+            res += wxString::Format(" >=%ldms:%ld", LatenessBuckets[i - 1], (long)_lateness[i]).ToStdString();
+        }
+        else
+        {
+            res += wxString::Format(" <%ldms:%ld", LatenessBuckets[i], (long)_lateness[i]).ToStdString();
+        }
+    }
+    return res;
+}
+
+void* OutputThread::Entry()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("Output thread started.");
+
+#ifdef __LINUX__
+    // ask for real time scheduling ... this needs privileges so failing is normal
+    sched_param param;
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        logger_base.debug("Output thread could not get real time scheduling, running at normal high priority.");
+    }
+#endif
+
+    auto deadline = std::chrono::steady_clock::now();
+    auto lastLog = deadline;
+    long frame = 0;
+
+    while (!_stop)
+    {
+        deadline += std::chrono::milliseconds((int)_interval);
+
+#ifdef __LINUX__
+        // steady_clock is CLOCK_MONOTONIC on linux
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+        std::this_thread::sleep_until(deadline);
+#endif
+        if (_stop) break;
+
+        auto now = std::chrono::steady_clock::now();
+        long lateMS = (long)std::chrono::duration_cast<std::chrono::milliseconds>(now - deadline).count();
+        RecordLateness(lateMS);
+
+        {
+            std::unique_lock<std::mutex> sendLocker(_sendLock);
+            SendFrame();
+        }
+
+        if (lateMS >= _interval)
+        {
+            // we fell a whole frame behind ... start the schedule again from now rather than sending a burst of frames
+            _deadlinesMissed++;
+            deadline = now;
+        }
+
+        OutputTick tick;
+        tick.frame = frame++;
+        tick.lateMS = lateMS;
+        _ticks.Push(tick);
+        if (!_tickPending.exchange(true))
+        {
+            wxCommandEvent event(EVT_OUTPUTTICK);
+            wxPostEvent(_owner, event);
+        }
+
+        if (now - lastLog > std::chrono::seconds(OUTPUT_LATENESS_LOG_SECS))
+        {
+            lastLog = now;
+            logger_base.debug("Output thread: %s", (const char *)GetLatenessReport().c_str());
+        }
+    }
+
+    logger_base.debug("Output thread exiting.");
+
+    return nullptr;
+}
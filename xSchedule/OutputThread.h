@@ -0,0 +1,97 @@
+#ifndef OUTPUTTHREAD_H
+#define OUTPUTTHREAD_H
+
+#include <wx/wx.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+
+class OutputManager;
+
+wxDECLARE_EVENT(EVT_OUTPUTTICK, wxCommandEvent);
+
+// lateness histogram buckets ... upper bounds in ms, the last bucket catches everything else
+#define OUTPUT_LATENESS_BUCKETS 8
+#define OUTPUT_TICK_QUEUE_SIZE 64
+
+class OutputTick
+{
+public:
+    long frame;
+    long lateMS;
+};
+
+// Single producer (output thread) single consumer (UI thread) queue that never blocks either side
+class OutputTickQueue
+{
+    OutputTick _ticks[OUTPUT_TICK_QUEUE_SIZE];
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+
+public:
+    OutputTickQueue() : _head(0), _tail(0) {}
+    bool Push(const OutputTick& tick);
+    bool Pop(OutputTick& tick);
+};
+
+// Keeps the lights on an absolute deadline schedule independent of the UI thread.
+//
+// At each deadline the most recently published frame is sent to the outputs and a tick is queued
+// for the UI thread which then calculates the next frame and publishes it.
+class OutputThread : public wxThread
+{
+    OutputManager* _outputManager;
+    wxEvtHandler* _owner;
+    std::atomic<bool> _stop;
+    std::atomic<int> _interval;
+    std::atomic<bool> _tickPending;
+    OutputTickQueue _ticks;
+
+    std::mutex _frameLock;
+    std::vector<wxByte> _pending;
+    long _pendingMS;
+    bool _pendingReady;
+    std::mutex _sendLock; // held while a frame is sent so SendFrameNow and the output thread take turns
+    std::vector<wxByte> _sending; // kept so it can be resent if the UI is late
+    long _sendingMS;
+
+    std::atomic<size_t> _lateness[OUTPUT_LATENESS_BUCKETS];
+    std::atomic<size_t> _framesSent;
+    std::atomic<size_t> _framesNotReady;
+    std::atomic<size_t> _deadlinesMissed;
+
+    void SendFrame();
+    void RecordLateness(long lateMS);
+
+public:
+    static const long LatenessBuckets[OUTPUT_LATENESS_BUCKETS];
+
+    OutputThread(wxEvtHandler* owner, OutputManager* outputManager, int interval);
+    virtual ~OutputThread() {}
+
+    // stops the thread and waits for it to exit
+    void Stop();
+
+    void SetInterval(int interval);
+    int GetInterval() const { return _interval; }
+
+    // called by the UI thread with a completed frame to send at the next deadline
+    void PublishFrame(const wxByte* buffer, size_t size, long msec);
+
+    // called by the UI thread to send a frame before returning ... it is also resent until the next one is published
+    void SendFrameNow(const wxByte* buffer, size_t size, long msec);
+
+    // called by the UI thread, returns the number of ticks since the last call
+    size_t DrainTicks();
+
+    size_t GetLateness(int bucket) const { return _lateness[bucket]; }
+    size_t GetFramesSent() const { return _framesSent; }
+    size_t GetFramesNotReady() const { return _framesNotReady; }
+    size_t GetDeadlinesMissed() const { return _deadlinesMissed; }
+    std::string GetLatenessReport() const;
+
+    virtual void* Entry() override;
+};
+
+#endif
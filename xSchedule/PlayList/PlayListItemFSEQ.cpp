@@ -145,6 +145,7 @@ void PlayListItemFSEQ::LoadFiles()
     {
         _fseqFile = new FSEQFile();
         _fseqFile->Load(_fseqFileName);
+        _fseqFile->EnableReadAhead();
         _msPerFrame = _fseqFile->GetFrameMS();
         _durationMS = _fseqFile->GetLengthMS();
     }
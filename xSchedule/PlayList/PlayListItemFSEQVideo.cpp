@@ -171,6 +171,7 @@ void PlayListItemFSEQVideo::LoadFiles(bool doCache)
     {
         _fseqFile = new FSEQFile();
         _fseqFile->Load(_fseqFileName);
+        _fseqFile->EnableReadAhead();
         _msPerFrame = _fseqFile->GetFrameMS();
         _durationMS = _fseqFile->GetLengthMS();
     }
@@ -35,6 +35,7 @@
 #include "../xLights/UtilFunctions.h"
 #include "Pinger.h"
 #include "events/ListenerManager.h"
+#include "OutputThread.h"
 
 ScheduleManager::ScheduleManager(xScheduleFrame* frame, const std::string& showDir)
 {
@@ -46,6 +47,7 @@ ScheduleManager::ScheduleManager(xScheduleFrame* frame, const std::string& showD
 
     _listenerManager = nullptr;
     _pinger = nullptr;
+    _outputThread = nullptr;
     _webRequestToggle = false;
     _backgroundPlayList = nullptr;
     _queuedSongs = new PlayList();
@@ -206,6 +208,9 @@ ScheduleManager::ScheduleManager(xScheduleFrame* frame, const std::string& showD
     logger_base.info("Allocated frame buffer of %ld bytes", _outputManager->GetTotalChannels());
     _buffer = (wxByte*)malloc(_outputManager->GetTotalChannels());
     memset(_buffer, 0x00, _outputManager->GetTotalChannels());
+
+    // frames are sent to the lights by this thread so UI activity does not delay them
+    _outputThread = new OutputThread(frame, _outputManager, 50);
 }
 
 void ScheduleManager::AddPlayList(PlayList* playlist)
@@ -344,6 +349,14 @@ ScheduleManager::~ScheduleManager()
     CloseFPPSyncSendSocket();
     CloseOSCSyncSendSocket();
     CloseARTNetSyncSendSocket();
+
+    if (_outputThread != nullptr)
+    {
+        _outputThread->Stop();
+        delete _outputThread;
+        _outputThread = nullptr;
+    }
+
     AllOff();
     _outputManager->StopOutput();
     StopVirtualMatrices();
@@ -624,7 +637,6 @@ void ScheduleManager::AllOff()
     logger_base.debug("Turning all the lights off.");
 
     memset(_buffer, 0x00, _outputManager->GetTotalChannels()); // clear out any prior frame data
-    _outputManager->StartFrame(0);
 
     if ((_backgroundPlayList != nullptr || _eventPlayLists.size() > 0) && _scheduleOptions->IsSendBackgroundWhenNotRunning())
     {
@@ -697,8 +709,8 @@ void ScheduleManager::AllOff()
         (*it)->Frame(_buffer, _outputManager->GetTotalChannels());
     }
 
-    _outputManager->SetManyChannels(0, _buffer, _outputManager->GetTotalChannels());
-    _outputManager->EndFrame();
+    // send it now so stopping the output straight after cannot leave the lights on
+    OutputFrame(0, true);
 }
 
 int ScheduleManager::Frame(bool outputframe)
@@ -743,7 +755,6 @@ int ScheduleManager::Frame(bool outputframe)
         if (outputframe)
         {
             memset(_buffer, 0x00, totalChannels); // clear out any prior frame data
-            _outputManager->StartFrame(msec);
         }
 
         bool done = false;
@@ -860,8 +871,7 @@ int ScheduleManager::Frame(bool outputframe)
 
             _listenerManager->ProcessFrame(_buffer, totalChannels);
 
-            _outputManager->SetManyChannels(0, _buffer, totalChannels);
-            _outputManager->EndFrame();
+            OutputFrame(msec);
         }
 
         if (done)
@@ -887,8 +897,7 @@ int ScheduleManager::Frame(bool outputframe)
         {
             if (outputframe)
             {
-                _outputManager->StartFrame(0);
-                _outputManager->AllOff();
+                memset(_buffer, 0x00, totalChannels); // all off
             }
 
             if ((_backgroundPlayList != nullptr || _eventPlayLists.size() > 0) && _scheduleOptions->IsSendBackgroundWhenNotRunning())
@@ -962,8 +971,7 @@ int ScheduleManager::Frame(bool outputframe)
 
             if (outputframe)
             {
-                _outputManager->SetManyChannels(0, _buffer, totalChannels);
-                _outputManager->EndFrame();
+                OutputFrame(0);
             }
         }
         else
@@ -972,8 +980,7 @@ int ScheduleManager::Frame(bool outputframe)
             {
                 if (outputframe)
                 {
-                    _outputManager->StartFrame(0);
-                    _outputManager->AllOff();
+                    memset(_buffer, 0x00, totalChannels); // all off
                 }
 
                 auto it = _eventPlayLists.begin();
@@ -1023,8 +1030,7 @@ int ScheduleManager::Frame(bool outputframe)
 
                 if (outputframe)
                 {
-                    _outputManager->SetManyChannels(0, _buffer, totalChannels);
-                    _outputManager->EndFrame();
+                    OutputFrame(0);
                 }
             }
         }
@@ -1036,6 +1042,76 @@ int ScheduleManager::Frame(bool outputframe)
     return rate;
 }
 
+void ScheduleManager::OutputFrame(long msec, bool now)
+{
+    if (_outputThread != nullptr && now)
+    {
+        // sent before we return so nothing that follows can overtake it
+        _outputThread->SendFrameNow(_buffer, _outputManager->GetTotalChannels(), msec);
+    }
+    else if (_outputThread != nullptr)
+    {
+        // sent at the next output deadline
+        _outputThread->PublishFrame(_buffer, _outputManager->GetTotalChannels(), msec);
+    }
+    else
+    {
+        _outputManager->StartFrame(msec);
+        _outputManager->SetManyChannels(0, _buffer, _outputManager->GetTotalChannels());
+        _outputManager->EndFrame();
+    }
+}
+
+// the output thread may be part way through a frame so wait for it rather than letting the start or stop be dropped
+void ScheduleManager::StartLightsOutput()
+{
+    _outputManager->LockOutput();
+    _outputManager->StartOutput();
+    _outputManager->UnlockOutput();
+}
+
+void ScheduleManager::StopLightsOutput()
+{
+    _outputManager->LockOutput();
+    _outputManager->StopOutput();
+    _outputManager->UnlockOutput();
+}
+
+void ScheduleManager::SetOutputInterval(int interval)
+{
+    if (_outputThread != nullptr)
+    {
+        _outputThread->SetInterval(interval);
+    }
+}
+
+int ScheduleManager::GetOutputInterval() const
+{
+    if (_outputThread != nullptr)
+    {
+        return _outputThread->GetInterval();
+    }
+    return 50;
+}
+
+size_t ScheduleManager::DrainOutputTicks()
+{
+    if (_outputThread != nullptr)
+    {
+        return _outputThread->DrainTicks();
+    }
+    return 0;
+}
+
+std::string ScheduleManager::GetOutputLatenessReport() const
+{
+    if (_outputThread != nullptr)
+    {
+        return _outputThread->GetLatenessReport();
+    }
+    return "";
+}
+
 void ScheduleManager::CreateBrightnessArray()
 {
     for (size_t i = 0; i < 256; i++)
@@ -3108,7 +3184,7 @@ void ScheduleManager::SetOutputToLights(xScheduleFrame* frame, bool otl, bool in
                 {
                     wxMessageBox("Warning: Lights output is already open in another process. This will cause issues.", "WARNING", 4 | wxCENTRE, frame);
                 }
-                _outputManager->StartOutput();
+                StartLightsOutput();
                 StartVirtualMatrices();
                 ManageBackground();
             }
@@ -3117,7 +3193,7 @@ void ScheduleManager::SetOutputToLights(xScheduleFrame* frame, bool otl, bool in
         {
             if (IsOutputToLights())
             {
-                _outputManager->StopOutput();
+                StopLightsOutput();
                 StopVirtualMatrices();
                 ManageBackground();
             }
@@ -3137,13 +3213,13 @@ void ScheduleManager::ManualOutputToLightsClick(xScheduleFrame* frame)
         {
             wxMessageBox("Warning: Lights output is already open in another process. This will cause issues.", "WARNING", 4 | wxCENTRE, frame);
         }
-        _outputManager->StartOutput();
+        StartLightsOutput();
         StartVirtualMatrices();
         ManageBackground();
     }
     else if (_manualOTL == 0)
     {
-        _outputManager->StopOutput();
+        StopLightsOutput();
         StopVirtualMatrices();
         ManageBackground();
     }
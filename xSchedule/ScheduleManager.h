@@ -21,6 +21,7 @@ class PlayListItem;
 class xScheduleFrame;
 class Pinger;
 class ListenerManager;
+class OutputThread;
 
 typedef enum
 {
@@ -89,8 +90,12 @@ class ScheduleManager
     int _timerAdjustment;
     bool _webRequestToggle;
     Pinger* _pinger;
+    OutputThread* _outputThread;
 
     std::string GetPingStatus();
+    void OutputFrame(long msec, bool now = false);
+    void StartLightsOutput();
+    void StopLightsOutput();
     void SendOSC(const OSCPacket& osc);
     std::string FormatTime(size_t timems);
     void CreateBrightnessArray();
@@ -131,6 +136,10 @@ class ScheduleManager
         int GetTimerAdjustment() const { return _timerAdjustment; }
         std::string GetOurIP() const;
         void SetTimerAdjustment(int timerAdjustment) { _timerAdjustment = timerAdjustment; }
+        void SetOutputInterval(int interval);
+        int GetOutputInterval() const;
+        size_t DrainOutputTicks();
+        std::string GetOutputLatenessReport() const;
         PlayList* GetPlayList(int  id) const;
         PlayList* GetBackgroundPlayList() const { return _backgroundPlayList; }
         std::list<PlayList*> GetEventPlayLists() const { return _eventPlayLists; }
@@ -23,6 +23,7 @@
 #include "../xLights/xLightsVersion.h"
 #include <wx/filename.h>
 #include "ScheduleManager.h"
+#include "Blend.h"
 #include "../xLights/outputs/OutputManager.h"
 #include <wx/stdpaths.h>
 #include <wx/debugrpt.h>
@@ -335,6 +336,7 @@ bool xScheduleApp::OnInit()
         { wxCMD_LINE_OPTION, "s", "show", "specify show directory" },
         { wxCMD_LINE_OPTION, "p", "playlist", "specify the playlist to play" },
         { wxCMD_LINE_SWITCH, "w", "wipe", "wipe settings clean" },
+        { wxCMD_LINE_SWITCH, "b", "blendbenchmark", "time the blend modes on a 500,000 channel buffer and exit" },
         { wxCMD_LINE_NONE }
     };
 
@@ -353,6 +355,14 @@ bool xScheduleApp::OnInit()
             logger_base.info("-w: Wiping settings");
             WipeSettings();
         }
+        if (parser.Found("b"))
+        {
+            logger_base.info("-b: Running blend benchmark");
+            std::string report = BlendBenchmark();
+            logger_base.info("%s", (const char *)report.c_str());
+            wxMessageBox(report, _("Blend Benchmark"));
+            return false;
+        }
         if (parser.Found("s", &showDir)) {
             parmfound = true;
             logger_base.info("-s: Show directory set to %s.", (const char *)showDir.c_str());
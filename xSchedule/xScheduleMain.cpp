@@ -43,6 +43,7 @@
 #include "../xLights/outputs/IPOutput.h"
 #include "PlayList/PlayListItemOSC.h"
 #include "../xLights/UtilFunctions.h"
+#include "OutputThread.h"
 
 //#include "../include/xs_xyzzy.xpm"
 #include "../include/xs_save.xpm"
@@ -170,7 +171,6 @@ const long xScheduleFrame::ID_MNU_EDITFPPREMOTE = wxNewId();
 const long xScheduleFrame::ID_MNU_OSCOPTION = wxNewId();
 const long xScheduleFrame::idMenuAbout = wxNewId();
 const long xScheduleFrame::ID_STATUSBAR1 = wxNewId();
-const long xScheduleFrame::ID_TIMER1 = wxNewId();
 const long xScheduleFrame::ID_TIMER2 = wxNewId();
 //*)
 
@@ -308,6 +308,7 @@ BEGIN_EVENT_TABLE(xScheduleFrame,wxFrame)
     EVT_COMMAND(wxID_ANY, EVT_DOCHECKSCHEDULE, xScheduleFrame::DoCheckSchedule)
     EVT_COMMAND(wxID_ANY, EVT_XYZZY, xScheduleFrame::DoXyzzy)
     EVT_COMMAND(wxID_ANY, EVT_XYZZYEVENT, xScheduleFrame::DoXyzzyEvent)
+    EVT_COMMAND(wxID_ANY, EVT_OUTPUTTICK, xScheduleFrame::OnOutputTick)
     END_EVENT_TABLE()
 
 xScheduleFrame::xScheduleFrame(wxWindow* parent, const std::string& showdir, const std::string& playlist, wxWindowID id)
@@ -318,7 +319,6 @@ xScheduleFrame::xScheduleFrame(wxWindow* parent, const std::string& showdir, con
     __schedule = nullptr;
     _statusSetAt = wxDateTime::Now();
     _webServer = nullptr;
-    _timerOutputFrame = false;
     _suspendOTL = false;
 
     //(*Initialize(xScheduleFrame)
@@ -520,8 +520,6 @@ xScheduleFrame::xScheduleFrame(wxWindow* parent, const std::string& showdir, con
     StatusBar1->SetStatusStyles(1,__wxStatusBarStyles_1);
     SetStatusBar(StatusBar1);
     DirDialog1 = new wxDirDialog(this, _("Select show folder ..."), wxEmptyString, wxDD_DEFAULT_STYLE, wxDefaultPosition, wxDefaultSize, _T("wxDirDialog"));
-    _timer.SetOwner(this, ID_TIMER1);
-    _timer.Start(500000, false);
     _timerSchedule.SetOwner(this, ID_TIMER2);
     _timerSchedule.Start(50000, false);
     FileDialog1 = new wxFileDialog(this, _("Select file"), wxEmptyString, _("xlights_schedule.xml"), _("xlights_schedule.xml"), wxFD_DEFAULT_STYLE|wxFD_OPEN|wxFD_FILE_MUST_EXIST, wxDefaultPosition, wxDefaultSize, _T("wxFileDialog"));
@@ -575,7 +573,6 @@ xScheduleFrame::xScheduleFrame(wxWindow* parent, const std::string& showdir, con
     Connect(ID_MNU_EDITFPPREMOTE,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xScheduleFrame::OnMenuItem_EditFPPRemotesSelected);
     Connect(ID_MNU_OSCOPTION,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xScheduleFrame::OnMenuItem_ConfigureOSCSelected);
     Connect(idMenuAbout,wxEVT_COMMAND_MENU_SELECTED,(wxObjectEventFunction)&xScheduleFrame::OnAbout);
-    Connect(ID_TIMER1,wxEVT_TIMER,(wxObjectEventFunction)&xScheduleFrame::On_timerTrigger);
     Connect(ID_TIMER2,wxEVT_TIMER,(wxObjectEventFunction)&xScheduleFrame::On_timerScheduleTrigger);
     Connect(wxEVT_SIZE,(wxObjectEventFunction)&xScheduleFrame::OnResize);
     //*)
@@ -683,9 +680,7 @@ xScheduleFrame::xScheduleFrame(wxWindow* parent, const std::string& showdir, con
         UpdateUI();
     }
 
-    _timer.Stop();
-    if (rate == 0) rate = 50;
-    _timer.Start(rate/2, false);
+    CorrectTimer(rate);
     _timerSchedule.Stop();
     _timerSchedule.Start(500, true);
 
@@ -1210,7 +1205,8 @@ void xScheduleFrame::OnTreeCtrl_PlayListsSchedulesItemActivated(wxTreeEvent& eve
     ValidateWindow();
 }
 
-void xScheduleFrame::On_timerTrigger(wxTimerEvent& event)
+// The output thread has just sent a frame to the lights ... calculate the next one for it
+void xScheduleFrame::OnOutputTick(wxCommandEvent& event)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     static bool reentered = false;
@@ -1218,24 +1214,31 @@ void xScheduleFrame::On_timerTrigger(wxTimerEvent& event)
 
     if (__schedule == nullptr) return;
 
+    size_t ticks = __schedule->DrainOutputTicks();
+    if (ticks == 0) return;
+
     if (reentered)
     {
-        logger_base.warn("Frame timer was re-entered ... dropping this frame.");
+        logger_base.warn("Output tick was re-entered ... dropping this frame.");
         return;
     }
     reentered = true;
 
-    int rate = __schedule->Frame(_timerOutputFrame);
+    if (ticks > 1)
+    {
+        // we were too slow and missed some frames ... just calculate the latest
+        logger_base.debug("UI fell %d frames behind the output thread.", (int)ticks - 1);
+    }
+
+    int rate = __schedule->Frame(true);
 
-    if (last != wxDateTime::Now().GetSecond() && _timerOutputFrame)
+    if (last != wxDateTime::Now().GetSecond())
     {
         last = wxDateTime::Now().GetSecond();
         wxCommandEvent event2(EVT_SCHEDULECHANGED);
         wxPostEvent(this, event2);
     }
 
-    _timerOutputFrame = !_timerOutputFrame;
-
     StaticText_PacketsPerSec->SetLabel(wxString::Format("Packets/Sec: %d", __schedule->GetPPS()));
 
     if (__schedule->GetWebRequestToggle())
@@ -1504,7 +1507,7 @@ void xScheduleFrame::OnButton_UserClick(wxCommandEvent& event)
         playlist = (PlayList*)((MyTreeItemData*)TreeCtrl_PlayListsSchedules->GetItemData(TreeCtrl_PlayListsSchedules->GetItemParent(treeitem)))->GetData();
     }
 
-    size_t rate = _timer.GetInterval();
+    size_t rate = __schedule->GetOutputInterval();
     std::string msg = "";
     __schedule->Action(((wxButton*)event.GetEventObject())->GetLabel().ToStdString(), playlist, schedule, rate, msg);
 
@@ -2162,7 +2165,7 @@ bool xScheduleFrame::HandleHotkeys(wxKeyEvent& event)
                 schedule = (Schedule*)((MyTreeItemData*)TreeCtrl_PlayListsSchedules->GetItemData(treeitem))->GetData();
             }
 
-            size_t rate = _timer.GetInterval();
+            size_t rate = __schedule->GetOutputInterval();
             std::string msg = "";
             __schedule->Action((*it)->GetLabel(), playlist, schedule, rate, msg);
 
@@ -2179,10 +2182,9 @@ bool xScheduleFrame::HandleHotkeys(wxKeyEvent& event)
 void xScheduleFrame::CorrectTimer(int rate)
 {
     if (rate == 0) rate = 50;
-    if ((rate - __schedule->GetTimerAdjustment()) / 2 != _timer.GetInterval())
+    if (rate - __schedule->GetTimerAdjustment() != __schedule->GetOutputInterval())
     {
-        _timer.Stop();
-        _timer.Start((rate - __schedule->GetTimerAdjustment()) / 2);
+        __schedule->SetOutputInterval(rate - __schedule->GetTimerAdjustment());
     }
 }
 
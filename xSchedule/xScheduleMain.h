@@ -42,7 +42,6 @@ class BrightnessControl;
 #include <wx/treectrl.h>
 //*)
 
-#include "../xLights/xLightsTimer.h"
 #include <list>
 
 class wxDebugReportCompress;
@@ -68,7 +67,6 @@ class xScheduleFrame : public wxFrame
     static ScheduleManager* __schedule;
     std::string _showDir;
     wxDateTime _statusSetAt;
-    bool _timerOutputFrame;
     bool _suspendOTL;
     Pinger* _pinger;
 
@@ -137,7 +135,6 @@ public:
         void OnMenuItem_SaveSelected(wxCommandEvent& event);
         void OnMenuItem_ShowFolderSelected(wxCommandEvent& event);
         void OnTreeCtrl_PlayListsSchedulesItemActivated(wxTreeEvent& event);
-        void On_timerTrigger(wxTimerEvent& event);
         void On_timerScheduleTrigger(wxTimerEvent& event);
         void OnMenuItem_OptionsSelected(wxCommandEvent& event);
         void OnMenuItem_ViewLogSelected(wxCommandEvent& event);
@@ -186,6 +183,7 @@ public:
         bool IsSchedule(wxTreeItemId id) const;
         void OnTreeCtrlMenu(wxCommandEvent &event);
         void OnButton_UserClick(wxCommandEvent& event);
+        void OnOutputTick(wxCommandEvent& event);
         void RateNotification(wxCommandEvent& event);
         void StatusMsgNotification(wxCommandEvent& event);
         void RunAction(wxCommandEvent& event);
@@ -256,7 +254,6 @@ public:
         static const long ID_MNU_OSCOPTION;
         static const long idMenuAbout;
         static const long ID_STATUSBAR1;
-        static const long ID_TIMER1;
         static const long ID_TIMER2;
         //*)
 
@@ -336,7 +333,6 @@ public:
         wxStatusBar* StatusBar1;
         wxTimer _timerSchedule;
         wxTreeCtrl* TreeCtrl_PlayListsSchedules;
-        xLightsTimer _timer;
         //*)
 
         DECLARE_EVENT_TABLE()